@@ -34,12 +34,32 @@
 // Radio settings (APC220)
 // =============================
 #define RADIO_SETTINGS_STRING "PARA 435000 3 9 3 0"
+#define RADIO_RX_BUFFER_SIZE 1024     // Buffer RX del driver UART (~1s a 9600 bps)
+#define RADIO_RX_TIMEOUT_SYMBOLS 10   // Hueco (en símbolos) que cierra una trama recibida
+#define RADIO_TX_BUFFER_SIZE 1024     // Buffer TX del driver UART: Serial2.write() no espera a la línea
+#define RADIO_TX_STAGING_SLOTS 8      // Tramas listas para la UART; el crono de cada display se sustituye (potencia de 2)
+#define RADIO_TX_INFLIGHT_SLOTS 32    // Tramas escritas pendientes de salir por la UART (potencia de 2)
+#define RADIO_MODULE_BUFFER_BYTES 256 // Buffer interno del APC220 (hoja de datos)
+#define RADIO_TX_BUFFER_FILL_PCT 75   // Ocupación máxima del buffer del módulo que se permite
+#define RADIO_TX_AIR_EFFICIENCY_PCT 80 // Parte de la velocidad RF que queda para datos (preámbulo, sincronía, CRC)
+
+// =============================
+// Puente serie BLE -> APC220
+// =============================
+#define BRIDGE_FRAME_MAX 255          // Bytes máximos por trama
+#define BRIDGE_QUEUE_SLOTS 16         // Tramas en cola (potencia de 2)
+#define BRIDGE_QUEUE_DROP_POLICY BRIDGE_DROP_NEWEST  // Con créditos no se pisa lo aceptado (o BRIDGE_DROP_OLDEST)
+#define BRIDGE_CREDIT_WINDOW_BYTES 1024 // Bytes concedidos sin salir aún por la UART (~1 s a 9600 bps)
+#define BRIDGE_CREDIT_NOTIFY_BYTES 256  // Avance mínimo de la concesión para notificarla
+#define MESSAGE_HISTORY_SLOTS 32      // Tramas (TX y RX) que guarda /api/messages?since=
 
 // =============================
 // WiFi / Captive Portal
 // =============================
 #define WIFI_AP_SSID "Kroner"
 #define WIFI_AP_PASS ""
+#define WIFI_AP_CHANNEL 1
+#define WIFI_AP_MAX_CONN 10           // Máximo de estaciones que admite el SoftAP del ESP32
 #define WIFI_AP_IP0 192
 #define WIFI_AP_IP1 168
 #define WIFI_AP_IP2 4
@@ -48,6 +68,75 @@
 #define WIFI_AP_MASK1 255
 #define WIFI_AP_MASK2 255
 #define WIFI_AP_MASK3 0
+#define CAPTIVE_DNS_TTL_S 60          // TTL de las respuestas del DNS cautivo
+
+// =============================
+// Servidor HTTP (puerto 80, asíncrono)
+// =============================
+#define WEB_SEND_MAX_BODY 4080        // Cuerpo máximo de POST /api/send (se guarda entero antes de trocear; cabe en la cola vacía)
+#define WEB_LONGPOLL_MAX 8            // Peticiones /api/messages?since= en espera a la vez
+#define WEB_LONGPOLL_TIMEOUT_MS 20000 // Espera máxima sin tramas nuevas (por defecto)
+#define SSE_MAX_CLIENTS 4             // Conexiones simultáneas a /api/stream
+#define SSE_HEARTBEAT_MS 15000        // Comentario ": ping" para conexiones sin tráfico
+#define SSE_RETRY_MS 2000             // Reintento que se indica al navegador tras un corte
+#define SSE_INPUT_SLOTS 16            // Eventos de entrada pendientes de enviar (potencia de 2)
+#define SSE_INPUT_TEXT_MAX 72         // Texto máximo de un evento de entrada (cabe el flanco F1-F3 más largo, ver sse_input_ring.h)
+
+// =============================
+// BLE (NimBLE)
+// =============================
+#define BLE_DEFAULT_MTU 23            // MTU antes de negociar
+#define BLE_PREFERRED_MTU 247         // MTU que se ofrece al central (244 bytes por notificación)
+#define BLE_CONN_INTERVAL_MIN 6       // Intervalo de conexión pedido, en unidades de 1.25 ms (7.5 ms)
+#define BLE_CONN_INTERVAL_MAX 12      // 15 ms
+#define BLE_CONN_LATENCY 0            // Eventos que el central puede saltarse
+#define BLE_CONN_TIMEOUT 400          // Supervisión, en unidades de 10 ms (4 s)
+#define BLE_ADV_INTERVAL 320          // Anuncio, en unidades de 0.625 ms (200 ms)
+
+// =============================
+// Métricas
+// =============================
+#define BLE_STATS_UPDATE_MS 1000      // Refresco de los resúmenes de latencias y del sistema en BLE
+
+// =============================
+// Generador de carga (pruebas de saturación)
+// =============================
+#define LOAD_GEN_DEFAULT_RATE_HZ 50   // Tramas por segundo
+#define LOAD_GEN_DEFAULT_FRAME_LEN 18 // "XXYY1 0 00 MM:SS.d"
+#define LOAD_GEN_DEFAULT_DISPLAYS 4   // Direcciones distintas
+#define LOAD_GEN_DEFAULT_SECONDS 30
+#define LOAD_GEN_MAX_RATE_HZ 5000
+#define LOAD_GEN_MAX_INPUT_HZ 50      // Entradas F1-F3 simuladas por segundo
+#define LOAD_GEN_MAX_SECONDS 600
+#define LOAD_GEN_MAX_BURST 32         // Tramas atrasadas que se generan de una vez
+
+// =============================
+// Ficheros estáticos (LittleFS)
+// =============================
+#define STATIC_CACHE_CONTROL_HTML "no-cache"                // Revalidar con ETag
+#define STATIC_CACHE_CONTROL_ASSETS "public, max-age=86400" // Imágenes, css, js: 1 día
+#define STATIC_CACHE_MAX_BYTES (48 * 1024)   // RAM total de la caché de ficheros
+#define STATIC_CACHE_MAX_FILE (24 * 1024)    // Ficheros mayores se leen siempre de LittleFS
+#define STATIC_CACHE_REVALIDATE_MS 5000      // Comprobar tamaño/fecha como mucho cada 5s
+
+// =============================
+// WebSocket (puerto 81, AsyncWebSocket)
+// =============================
+#define WS_MAX_CLIENTS 16             // Clientes a la vez; los demás se cierran al conectar
+#define WS_CLIENT_QUEUE_DEPTH 8       // Tramas pendientes por cliente (además de WS_MAX_QUEUED_MESSAGES en platformio.ini)
+#define WS_FANOUT_POOL_SIZE 12        // Tramas codificadas compartidas entre clientes
+#define WS_CLIENT_MAX_DROPS 32        // Descartes seguidos antes de desconectar al cliente
+#define WS_CLIENT_STALL_MS 500        // Trama pendiente más antigua que esto desconecta al cliente
+#define WS_BUSY_RETRY_MS 10           // Reintento mientras un cliente sin hueco tiene tramas pendientes
+
+// =============================
+// Entradas (interrupciones F1-F3, teclado y switches)
+// =============================
+#define INPUT_EVENT_QUEUE_SLOTS 64    // Flancos pendientes de enviar (potencia de 2)
+#define INPUT_F_DEBOUNCE_US 500000UL  // Antirrebote por canal en la ISR (500 ms, como antes)
+#define INPUT_IDLE_AFTER_MS 150      // Sin actividad: dejar de barrer y esperar interrupción (> antirrebote de switches)
+#define PULSADOR_EVENT_SLOTS 64       // Eventos binarios pendientes de notificar
+#define PULSADOR_NOTIFY_MAX 244       // Tamaño de pulsadorCharacteristic (MTU 247 - 3)
 
 // =============================
 // Pin mapping
@@ -8,14 +8,14 @@
   #define DEBUG_PRINTLN(x) Serial.println(x)
 #endif
 
-APCModule::APCModule(HardwareSerial &serial, int setPin) : serial(serial), hwSerial(&serial), swSerial(nullptr), setPin(setPin), rxPin(-1), txPin(-1) {
+APCModule::APCModule(HardwareSerial &serial, int setPin) : serial(serial), hwSerial(&serial), swSerial(nullptr), setPin(setPin), rxPin(-1), txPin(-1), parsedValid(false) {
 }
 
-APCModule::APCModule(SoftwareSerial &serial, int setPin) : serial(serial), hwSerial(nullptr), swSerial(&serial), setPin(setPin), rxPin(-1), txPin(-1) {
+APCModule::APCModule(SoftwareSerial &serial, int setPin) : serial(serial), hwSerial(nullptr), swSerial(&serial), setPin(setPin), rxPin(-1), txPin(-1), parsedValid(false) {
 }
 
 APCModule::APCModule(HardwareSerial &serial, int setPin, int rxPin, int txPin)
-    : serial(serial), hwSerial(&serial), swSerial(nullptr), setPin(setPin), rxPin(rxPin), txPin(txPin) {
+    : serial(serial), hwSerial(&serial), swSerial(nullptr), setPin(setPin), rxPin(rxPin), txPin(txPin), parsedValid(false) {
 }
 
 void APCModule::beginSerial(int baudarate) {
@@ -91,6 +91,8 @@ void APCModule::setSettings(String ACPConfig){
   }
   params.trim();
   String toSend = String("WR ") + params; // comando real a enviar
+  APCSettings requested;
+  bool requestedValid = parseSettings(params, requested);
 
   // Entrar en modo CONFIG
   digitalWrite(setPin, LOW);
@@ -120,6 +122,10 @@ void APCModule::setSettings(String ACPConfig){
   response.trim();
   if (response.startsWith(expected)) {
     Serial.println("APCModule: Configuración correcta");
+    if (requestedValid) {
+      parsed = requested;
+      parsedValid = true;
+    }
   } else {
     Serial.print("APCModule: Respuesta inesperada: ");
     Serial.println(response);
@@ -131,7 +137,32 @@ void APCModule::setSettings(String ACPConfig){
 String APCModule::getSettings(){
   String config;
   if (tryReadConfig(config, 500)) {
+    // Lo que devuelve el módulo manda sobre lo que se pidió
+    APCSettings read;
+    int para = config.indexOf("PARA ");
+    if (para >= 0 && parseSettings(config.substring(para), read)) {
+      parsed = read;
+      parsedValid = true;
+    }
     return config;
   }
   return String("");
 }
+
+bool APCModule::getParsedSettings(APCSettings &out) const {
+  if (!parsedValid) return false;
+  out = parsed;
+  return true;
+}
+
+bool APCModule::parseSettings(const String &text, APCSettings &out) {
+  return apcParseSettings(text.c_str(), out);
+}
+
+uint32_t APCModule::rfRateBps(uint8_t code) {
+  return apcRfRateBps(code);
+}
+
+uint32_t APCModule::uartRateBps(uint8_t code) {
+  return apcUartRateBps(code);
+}
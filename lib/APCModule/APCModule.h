@@ -5,6 +5,7 @@
 #include <Stream.h>
 #include <HardwareSerial.h>
 #include <SoftwareSerial.h>
+#include <APCSettings.h>
 
 /**
  * @brief APCModule class for managing ACP220 module
@@ -66,6 +67,33 @@ public:
      * @return String with the current settings of the ACP220 module
     */
     String getSettings();
+
+    /**
+     * @brief Last settings applied or read back from the module
+     * 
+     * @param out Parsed settings
+     * @return false if no valid settings have been seen yet
+    */
+    bool getParsedSettings(APCSettings &out) const;
+
+    /**
+     * @brief Parse a "WR ...", "PARA ..." or bare parameter string (see apcParseSettings)
+     * 
+     * @param text Configuration string
+     * @param out Parsed settings (only written on success)
+     * @return false if a field is missing or out of range
+    */
+    static bool parseSettings(const String &text, APCSettings &out);
+
+    /**
+     * @brief RF data rate in bps for a rate code (0 if invalid)
+    */
+    static uint32_t rfRateBps(uint8_t code);
+
+    /**
+     * @brief UART rate in bps for a rate code (0 if invalid)
+    */
+    static uint32_t uartRateBps(uint8_t code);
     private:
         Stream &serial;
         HardwareSerial *hwSerial;
@@ -73,6 +101,8 @@ public:
         int setPin;
         int rxPin;
         int txPin;
+        APCSettings parsed;
+        bool parsedValid;
 
         bool tryReadConfig(String &out, unsigned long waitMs);
         void beginSerial(int baudrate);
@@ -0,0 +1,38 @@
+#include "APCSettings.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+bool apcParseSettings(const char *text, APCSettings &out) {
+  while (isspace((unsigned char)*text)) text++;
+  if (strncmp(text, "PARA ", 5) == 0) {
+    text += 5;
+  } else if (strncmp(text, "WR ", 3) == 0) {
+    text += 3;
+  }
+
+  unsigned long freq;
+  unsigned rf, power, uart, parity;
+  if (sscanf(text, "%lu %u %u %u %u", &freq, &rf, &power, &uart, &parity) != 5) {
+    return false;
+  }
+  if (rf < 1 || rf > 4 || power > 9 || uart > 6 || parity > 2) {
+    return false;
+  }
+  out.frequencyKHz = freq;
+  out.rfRate = rf;
+  out.power = power;
+  out.uartRate = uart;
+  out.parity = parity;
+  return true;
+}
+
+uint32_t apcRfRateBps(uint8_t code) {
+  static const uint32_t rates[] = {2400, 4800, 9600, 19200};
+  return code >= 1 && code <= 4 ? rates[code - 1] : 0;
+}
+
+uint32_t apcUartRateBps(uint8_t code) {
+  static const uint32_t rates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600};
+  return code <= 6 ? rates[code] : 0;
+}
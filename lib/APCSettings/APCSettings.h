@@ -0,0 +1,39 @@
+#ifndef APCSettings_h
+#define APCSettings_h
+
+#include <stdint.h>
+
+/**
+ * @brief Parsed ACP220 parameters ("WR"/"PARA" <freq> <rfRate> <power> <uart> <parity>)
+ *
+ * Pure parsing with no Arduino dependencies, shared by APCModule and the
+ * host tests (pio test -e native).
+ */
+struct APCSettings {
+    uint32_t frequencyKHz;  // Frecuencia en kHz (434000 = 434 MHz)
+    uint8_t rfRate;         // Código de velocidad RF (1-4)
+    uint8_t power;          // Potencia (0-9)
+    uint8_t uartRate;       // Código de velocidad UART (0-6)
+    uint8_t parity;         // 0 ninguna, 1 par, 2 impar
+};
+
+/**
+ * @brief Parse a "WR ...", "PARA ..." or bare parameter string
+ * 
+ * @param text Configuration string (leading whitespace is ignored)
+ * @param out Parsed settings (only written on success)
+ * @return false if a field is missing or out of range
+*/
+bool apcParseSettings(const char *text, APCSettings &out);
+
+/**
+ * @brief RF data rate in bps for a rate code (0 if invalid)
+*/
+uint32_t apcRfRateBps(uint8_t code);
+
+/**
+ * @brief UART rate in bps for a rate code (0 if invalid)
+*/
+uint32_t apcUartRateBps(uint8_t code);
+
+#endif
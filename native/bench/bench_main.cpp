@@ -0,0 +1,582 @@
+// Benchmarks del pipeline del hub en el host (env:native)
+//
+//   pio run -e native -t exec            (o .pio/build/native/program [--quick])
+//   .pio/build/native/program --load [baud]   barrido del generador de carga
+//
+// Cada etapa se mide dos veces: una pasada sin instrumentar para el
+// throughput y otra cronometrando cada operación para los percentiles.
+// La corrección de cada módulo la comprueban los tests de test/ (pio test -e native).
+
+// `pio test` compila src/ junto a cada test, que trae su propio main()
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include <ESPAsyncWebServer.h>
+#include <base64_baseline.h>
+#include <algorithm>
+#include <vector>
+#include <APCSettings.h>
+#include "kroner_config.h"
+#include "base64_codec.h"
+#include "bridge_credits.h"
+#include "bridge_queue.h"
+#include "display_protocol.h"
+#include "input_debounce.h"
+#include "input_event_queue.h"
+#include "latency_histogram.h"
+#include "latency_metrics.h"
+#include "load_generator.h"
+#include "message_store.h"
+#include "pulsador_events.h"
+#include "radio_frame_assembler.h"
+#include "radio_tx_pacer.h"
+#include "radio_tx_staging.h"
+#include "task_scheduler.h"
+#include "uart_tx_tracker.h"
+#include "ws_fanout.h"
+
+static AsyncWebSocket webSocket("/");
+static NimBLECharacteristic serialBridgeWriteChar("12345678-1234-5678-1234-56789abcdef1", NIMBLE_PROPERTY::WRITE,
+                                                   BRIDGE_FRAME_MAX);
+static BridgeQueue bleBridgeQueue(BRIDGE_QUEUE_DROP_POLICY);
+static BridgeQueue radioRxQueue(BRIDGE_DROP_OLDEST);
+
+// Lo mismo que hace SerialBridgeCallbacks::onWrite() con el valor escrito
+static bool onSerialBridgeWritten() {
+  NimBLEAttValue value = serialBridgeWriteChar.getValue();
+  return bleBridgeQueue.push(value.data(), value.length(), millis(), micros());
+}
+
+// =============================
+// Medición
+// =============================
+static uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t iterations = 200000;
+static volatile uint32_t sink = 0;   // Evita que el compilador elimine el trabajo
+
+static void printHeader() {
+  printf("%-26s %10s %12s %9s %9s %9s %9s\n", "stage", "ops", "ops/s", "MB/s", "p50 ns", "p99 ns", "max ns");
+}
+
+template <typename Fn>
+static void runStage(const char* name, size_t bytesPerOp, Fn op) {
+  // Calentamiento
+  for (uint64_t i = 0; i < iterations / 20; i++) op();
+
+  uint64_t start = nowNs();
+  for (uint64_t i = 0; i < iterations; i++) op();
+  double seconds = (nowNs() - start) / 1e9;
+
+  size_t samples = (size_t)std::min<uint64_t>(iterations, 100000);
+  std::vector<uint32_t> ns(samples);
+  for (size_t i = 0; i < samples; i++) {
+    uint64_t t0 = nowNs();
+    op();
+    ns[i] = (uint32_t)(nowNs() - t0);
+  }
+  std::sort(ns.begin(), ns.end());
+
+  double opsPerSec = iterations / seconds;
+  printf("%-26s %10llu %12.0f %9.1f %9u %9u %9u\n", name, (unsigned long long)iterations, opsPerSec,
+         opsPerSec * bytesPerOp / 1e6, ns[samples / 2], ns[samples * 99 / 100], ns[samples - 1]);
+}
+
+static BridgeFrame makeFrame(const char* text) {
+  BridgeFrame frame;
+  frame.len = (uint16_t)strlen(text);
+  memcpy(frame.data, text, frame.len);
+  frame.time = millis();
+  frame.stampUs = micros();
+  return frame;
+}
+
+// =============================
+// Etapas
+// =============================
+static void benchCodec() {
+  uint8_t payload[244];
+  for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 7);
+  char out[base64EncodedLength(sizeof(payload)) + 1];
+  runStage("base64 244B byte loop", sizeof(payload), [&]() {
+    sink += (uint32_t)base64EncodeBaseline(payload, sizeof(payload), out);
+  });
+  runStage("base64 244B", sizeof(payload), [&]() {
+    sink += (uint32_t)base64Encode(payload, sizeof(payload), out);
+  });
+
+  BridgeFrame chrono = makeFrame("01021 1 00 12:34.5");
+  char json[MESSAGE_JSON_MAX];
+  runStage("json encode (chrono)", chrono.len, [&]() {
+    sink += (uint32_t)encodeFrameJson(chrono, nullptr, json, sizeof(json));
+  });
+
+  BridgeFrame big;
+  big.len = BRIDGE_FRAME_MAX;
+  memset(big.data, 'A', big.len);
+  big.time = 0;
+  big.stampUs = 0;
+  runStage("json encode (255B)", big.len, [&]() {
+    sink += (uint32_t)encodeFrameJson(big, nullptr, json, sizeof(json));
+  });
+
+  runStage("publishLatestMessage", chrono.len, [&]() {
+    sink += (uint32_t)publishLatestMessage(chrono).jsonLen;
+  });
+
+  runStage("encodeRadioMessage", chrono.len, [&]() {
+    sink += (uint32_t)encodeRadioMessage(chrono).binLen;
+  });
+
+  char item[MESSAGE_HISTORY_JSON_MAX];
+  runStage("history copy", chrono.len, [&]() {
+    sink += (uint32_t)copyHistoryMessageJson(getLatestMessageSeq(), item, sizeof(item));
+  });
+}
+
+static void benchParsing() {
+  BridgeFrame chrono = makeFrame("01021 1 00 12:34.5");
+  DisplayFrameInfo info;
+  runStage("parseDisplayFrame", chrono.len, [&]() {
+    sink += parseDisplayFrame(chrono.data, chrono.len, info) ? info.address : 0;
+  });
+
+  // Respuesta del APC220 a "RD" al arrancar (y la configuración por defecto)
+  APCSettings settings;
+  static const char reply[] = "PARA 435000 3 9 3 0";
+  runStage("apc settings parse", sizeof(reply) - 1, [&]() {
+    sink += apcParseSettings(reply, settings) ? apcRfRateBps(settings.rfRate) + apcUartRateBps(settings.uartRate) : 0;
+  });
+
+  RadioFrameAssembler assembler(radioRxQueue);
+  static const uint8_t line[] = "01021 1 00 12:34.5\r\n";
+  BridgeFrame frame;
+  runStage("radio assembler line", sizeof(line) - 1, [&]() {
+    sink += assembler.feed(line, sizeof(line) - 1, 0, 0);
+    while (radioRxQueue.pop(frame)) {
+    }
+  });
+}
+
+static void benchQueue() {
+  BridgeFrame chrono = makeFrame("01021 1 00 12:34.5");
+  BridgeFrame out;
+  BridgeQueue queue(BRIDGE_DROP_OLDEST);
+  runStage("bridge queue push+pop", chrono.len, [&]() {
+    queue.push(chrono.data, chrono.len, 0, 0);
+    sink += queue.pop(out) ? out.len : 0;
+  });
+
+  // SPSC real: productor y consumidor en hilos distintos
+  BridgeQueue spsc(BRIDGE_DROP_NEWEST);
+  std::atomic<bool> done(false);
+  uint64_t consumed = 0;
+  uint64_t start = nowNs();
+  std::thread consumer([&]() {
+    BridgeFrame f;
+    for (;;) {
+      if (spsc.pop(f)) {
+        consumed++;
+      } else if (done.load(std::memory_order_acquire)) {
+        while (spsc.pop(f)) consumed++;
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  for (uint64_t i = 0; i < iterations; i++) {
+    while (!spsc.push(chrono.data, chrono.len, 0, 0)) {
+      std::this_thread::yield();
+    }
+  }
+  done.store(true, std::memory_order_release);
+  consumer.join();
+  double seconds = (nowNs() - start) / 1e9;
+  BridgeQueueStats stats = spsc.getStats();
+  printf("%-26s %10llu %12.0f %9.1f %9s %9s %9s  (full: %u)\n", "bridge queue SPSC 2 thr",
+         (unsigned long long)consumed, consumed / seconds, consumed * chrono.len / seconds / 1e6, "-", "-", "-",
+         (unsigned)stats.droppedNewest);
+}
+
+// Teléfono que respeta los créditos frente a la tarea de radio
+static void benchBridgeCredits() {
+  BridgeQueue queue(BRIDGE_DROP_NEWEST);
+  BridgeCredits credits;
+  credits.reset(244);
+  std::atomic<uint32_t> byteLimit(0), frameLimit(0);   // Última notificación
+  auto publish = [&](bool force) {
+    BridgeCreditGrant grant;
+    if (credits.update(BridgeQueue::CAPACITY - queue.getStats().depth, force, grant)) {
+      frameLimit.store(grant.frameLimit, std::memory_order_release);
+      byteLimit.store(grant.byteLimit, std::memory_order_release);
+    }
+  };
+  publish(true);
+
+  std::atomic<bool> done(false);
+  uint64_t start = nowNs();
+  std::thread radio([&]() {
+    BridgeFrame f;
+    for (;;) {
+      if (queue.pop(f)) {
+        credits.onDrained(f.len);
+        publish(false);
+      } else if (done.load(std::memory_order_acquire)) {
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint8_t data[BRIDGE_FRAME_MAX] = {0};
+  uint32_t sentBytes = 0, sentFrames = 0;
+  for (uint64_t i = 0; i < iterations; i++) {
+    size_t len = 20 + (i * 37) % 225;
+    while ((int32_t)(byteLimit.load(std::memory_order_acquire) - (sentBytes + len)) < 0 ||
+           (int32_t)(frameLimit.load(std::memory_order_acquire) - (sentFrames + 1)) < 0) {
+      std::this_thread::yield();
+    }
+    queue.push(data, len, 0, 0);
+    credits.onReceived(len);
+    sentBytes += len;
+    sentFrames++;
+  }
+  while (queue.size() > 0) std::this_thread::yield();
+  done.store(true, std::memory_order_release);
+  radio.join();
+  double seconds = (nowNs() - start) / 1e9;
+  BridgeCreditStats stats = credits.getStats();
+  printf("%-26s %10llu %12.0f %9.1f %9s %9s %9s  (notifies: %u)\n",
+         "bridge credits 2 thr", (unsigned long long)iterations, iterations / seconds, sentBytes / seconds / 1e6,
+         "-", "-", "-", (unsigned)stats.notifications);
+}
+
+static void benchInputEdges() {
+  // F1-F3 rebotando: un flanco cada 37 µs repartido entre los tres canales,
+  // casi todos dentro de la ventana y rechazados como en la ISR
+  InputDebounce channels[3] = {};
+  uint64_t nowUs = 0;
+  runStage("input debounce F1-F3", 0, [&]() {
+    nowUs += 37;
+    sink += inputDebounceAccept(channels[nowUs % 3], nowUs, INPUT_F_DEBOUNCE_US);
+  });
+
+  InputEventQueue queue;
+  InputEvent event;
+  uint64_t t = 0;
+  runStage("input edge push+pop", 0, [&]() {
+    queue.push((uint8_t)(t % 3), t);
+    t++;
+    sink += queue.pop(event) ? event.channel : 0;
+  });
+
+  // Varios productores (ISR y entradas simuladas) y la tarea de entradas
+  InputEventQueue shared;
+  std::atomic<bool> done(false);
+  uint64_t perProducer = iterations / 2;
+  uint64_t consumed = 0;
+  uint64_t start = nowNs();
+  std::thread consumer([&]() {
+    InputEvent e;
+    for (;;) {
+      if (shared.pop(e)) {
+        consumed++;
+      } else if (done.load(std::memory_order_acquire)) {
+        while (shared.pop(e)) consumed++;
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+  auto producer = [&](uint8_t channel) {
+    for (uint64_t i = 1; i <= perProducer; i++) {
+      while (!shared.push(channel, i)) {
+        std::this_thread::yield();
+      }
+    }
+  };
+  std::thread p0(producer, 0);
+  std::thread p1(producer, 1);
+  p0.join();
+  p1.join();
+  done.store(true, std::memory_order_release);
+  consumer.join();
+  double seconds = (nowNs() - start) / 1e9;
+  printf("%-26s %10llu %12.0f %9s %9s %9s %9s  (full: %u)\n", "input edges 2P/1C",
+         (unsigned long long)consumed, consumed / seconds, "-", "-", "-", "-",
+         (unsigned)shared.getStats().overflows);
+}
+
+// Ráfaga de eventos de entrada empaquetada en notificaciones de 244 bytes
+static void benchPulsadorBatch() {
+  PulsadorEventBatch batch;
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  uint64_t t = 0;
+  const int burst = 8;
+  runStage("pulsador batch 8 ev/244B", PULSADOR_EVENTS_HEADER_LEN + burst * PULSADOR_EVENTS_RECORD_LEN, [&]() {
+    for (int i = 0; i < burst; i++) {
+      batch.append((uint8_t)(PULSADOR_EVENT_F1 + i % 3), 0, t += 1000);
+    }
+    size_t len;
+    while ((len = batch.packNext(packet, PULSADOR_NOTIFY_MAX)) > 0) sink += len;
+  });
+}
+
+// Reserva y confirmación de una trama de chrono por el dosificador TX,
+// con el reloj avanzando lo que tarda en salir por el aire
+static void benchRadioPacer() {
+  RadioTxPacer pacer;
+  pacer.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, 0);
+  const size_t len = 20;
+  uint32_t t = 0;
+  runStage("radio tx pacer 20B", len, [&]() {
+    uint32_t wait = pacer.reserve(len, t);
+    t += wait;
+    pacer.commit(len, t, wait);
+    t += 2000;
+  });
+}
+
+// Seguimiento de tramas en el buffer TX de la UART: marcar y cerrar al salir
+static void benchUartTxTracker() {
+  UartTxTracker tracker;
+  uint32_t driverPending = 0;
+  UartTxDone done;
+  runStage("uart tx tracker", 20, [&]() {
+    tracker.wrote(20);
+    driverPending += 20;
+    tracker.mark(0, 20, 1);
+    // La línea saca ~una trama por iteración, con la FIFO siempre a medias
+    driverPending = driverPending > 30 ? driverPending - 20 : 10;
+    while (tracker.popDone(driverPending, done)) sink += done.len;
+  });
+}
+
+// Cronos de 4 displays entrando más rápido de lo que salen: cada pasada
+// acepta dos tramas (la segunda sustituye a una pendiente) y envía una
+static void benchChronoCoalescing() {
+  RadioTxStaging staging;
+  BridgeFrame frame;
+  uint8_t tag;
+  uint16_t supersededLen;
+  uint32_t seq = 0;
+  runStage("radio tx staging chrono", 18, [&]() {
+    for (int i = 0; i < 2; i++) {
+      BridgeFrame& slot = staging.back();
+      slot.len = (uint16_t)snprintf((char*)slot.data, BRIDGE_FRAME_MAX, "%02u011 0 00 12:34.%u",
+                                    (unsigned)(seq % 4 + 1), (unsigned)(seq % 10));
+      seq++;
+      staging.commit(0, supersededLen, tag);
+    }
+    if (staging.pop(frame, tag)) sink += frame.len;
+  });
+}
+
+static void benchFanout() {
+  // Cuatro clientes: dos JSON y dos binarios
+  wsFanoutInit(webSocket);
+  for (uint8_t num = 0; num < 4; num++) {
+    wsFanoutClientConnected(num);
+    wsFanoutSetBinary(num, num >= 2);
+  }
+
+  BridgeFrame chrono = makeFrame("01021 1 00 12:34.5");
+  DisplayFrameInfo info;
+  parseDisplayFrame(chrono.data, chrono.len, info);
+  const EncodedMessage& message = publishLatestMessage(chrono);
+
+  runStage("ws fanout 4 clients", chrono.len, [&]() {
+    wsFanoutPublish(message, info.address);
+    wsFanoutService();
+  });
+
+  // Cliente lento: publicar varias veces antes de enviar (coalescing)
+  runStage("ws fanout coalesce x4", chrono.len * 4, [&]() {
+    for (int i = 0; i < 4; i++) wsFanoutPublish(message, info.address);
+    wsFanoutService();
+  });
+
+  for (uint8_t num = 0; num < 4; num++) {
+    wsFanoutClientDisconnected(num);
+  }
+}
+
+static void benchMetrics() {
+  LatencyHistogram histogram;
+  uint32_t value = 1;
+  runStage("histogram record", 0, [&]() {
+    value = value * 1103515245u + 12345u;
+    histogram.record(value % 20000);
+  });
+
+  TaskScheduler scheduler;
+  for (int i = 0; i < 8; i++) {
+    scheduler.addTask("job", []() { sink++; }, 10 + i);
+  }
+  runStage("scheduler update (8)", 0, [&]() {
+    scheduler.update();
+  });
+}
+
+// Los percentiles del histograma son cotas de cubeta: no pasar del máximo visto
+static void printLatency(const char* name, const LatencyHistogram& histogram) {
+  uint32_t maxUs = histogram.getMax();
+  printf("  %s latency p50/p99/max: %u/%u/%u us (%u samples)\n", name,
+         (unsigned)std::min(histogram.percentile(50), maxUs), (unsigned)std::min(histogram.percentile(99), maxUs),
+         (unsigned)maxUs, (unsigned)histogram.getCount());
+}
+
+/**
+ * @brief Camino completo: escritura BLE -> cola -> Serial2 -> JSON/binario -> WebSocket
+ */
+static void benchPipeline() {
+  wsFanoutInit(webSocket);
+  for (uint8_t num = 0; num < 4; num++) {
+    wsFanoutClientConnected(num);
+    wsFanoutSetBinary(num, num >= 2);
+  }
+
+  BridgeFrame chrono = makeFrame("01021 1 00 12:34.5");
+  BridgeFrame frame;
+  bridgeLatency.reset();
+  broadcastLatency.reset();
+
+  runStage("pipeline BLE->WS", chrono.len, [&]() {
+    serialBridgeWriteChar.setValue(chrono.data, chrono.len);
+    onSerialBridgeWritten();
+    while (bleBridgeQueue.pop(frame)) {
+      Serial2.write(frame.data, frame.len);
+      bridgeLatency.record(micros() - frame.stampUs);
+      DisplayFrameInfo info;
+      uint32_t key = parseDisplayFrame(frame.data, frame.len, info) ? info.address : 0;
+      wsFanoutPublish(publishLatestMessage(frame), key);
+    }
+    wsFanoutService();
+  });
+
+  printLatency("bridge", bridgeLatency);
+  printLatency("broadcast", broadcastLatency);
+  printf("  Serial2: %llu bytes, WebSocket: %llu text + %llu binary frames, pool exhausted: %u\n",
+         (unsigned long long)Serial2.bytesWritten, (unsigned long long)webSocket.textFrames,
+         (unsigned long long)webSocket.binaryFrames, (unsigned)wsFanoutPoolExhausted());
+
+  for (uint8_t num = 0; num < 4; num++) {
+    wsFanoutClientDisconnected(num);
+  }
+}
+
+// =============================
+// Generador de carga: punto de saturación
+// =============================
+static const uint32_t LOAD_SWEEP_RATES[] = {25, 50, 100, 250, 500, 1000, 2000, 5000};
+
+/**
+ * @brief Consumidor: lo que hace la tarea de radio con cada trama del puente
+ */
+static void radioConsumer(std::atomic<bool>& stop) {
+  BridgeFrame frame;
+  while (!stop.load(std::memory_order_acquire)) {
+    bool any = false;
+    while (bleBridgeQueue.pop(frame)) {
+      any = true;
+      Serial2.write(frame.data, frame.len);
+      bridgeLatency.record(micros() - frame.stampUs);
+      DisplayFrameInfo info;
+      uint32_t key = parseDisplayFrame(frame.data, frame.len, info) && info.type == DISPLAY_TYPE_CHRONO ? info.address : 0;
+      wsFanoutPublish(publishLatestMessage(frame), key);
+    }
+    wsFanoutService();
+    if (!any) std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+/**
+ * @brief Barre tasas con el generador (mismo código que el firmware) hasta que
+ * la cola empieza a perder tramas o el consumidor no mantiene la tasa
+ */
+static void runLoadSweep(uint32_t baud) {
+  Serial2.baud = baud;
+  loadGeneratorInit(bleBridgeQueue, nullptr, nullptr);
+  wsFanoutInit(webSocket);
+  for (uint8_t num = 0; num < 4; num++) {
+    wsFanoutClientConnected(num);
+    wsFanoutSetBinary(num, num >= 2);
+  }
+
+  printf("Load sweep: chrono frames, 4 displays, 4 WebSocket clients, UART %s\n\n",
+         baud ? std::to_string(baud).c_str() : "unthrottled");
+  printf("%8s %10s %10s %10s %8s %12s %12s\n", "rate", "offered", "sustained", "delivered", "dropped",
+         "bridge p99", "bcast p99");
+
+  uint32_t saturation = 0;
+  for (uint32_t rate : LOAD_SWEEP_RATES) {
+    LoadGeneratorConfig config = loadGeneratorDefaults();
+    config.rateHz = rate;
+    config.durationMs = 2000;
+
+    std::atomic<bool> stop(false);
+    std::thread consumer(radioConsumer, std::ref(stop));
+    loadGeneratorStart(config);
+    for (;;) {
+      uint32_t waitUs = loadGeneratorService();
+      if (waitUs == UINT32_MAX) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+    }
+    // Dejar que el consumidor vacíe la cola antes del informe
+    while (bleBridgeQueue.size() > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stop.store(true, std::memory_order_release);
+    consumer.join();
+
+    LoadGeneratorReport r = loadGeneratorGetReport();
+    printf("%8u %10u %10u %10u %8u %10u us %10u us\n", (unsigned)rate, (unsigned)r.offeredFps,
+           (unsigned)r.sustainedFps, (unsigned)r.delivered, (unsigned)r.dropped,
+           (unsigned)std::min(r.bridgeP99Us, r.bridgeMaxUs), (unsigned)std::min(r.broadcastP99Us, r.broadcastMaxUs));
+    if (saturation == 0 && (r.dropped > 0 || r.sustainedFps * 100 < r.offeredFps * 95)) {
+      saturation = rate;
+    }
+  }
+
+  if (saturation) {
+    printf("\nSaturation at %u frames/s\n", (unsigned)saturation);
+  } else {
+    printf("\nNo saturation up to %u frames/s\n", (unsigned)LOAD_SWEEP_RATES[sizeof(LOAD_SWEEP_RATES) / sizeof(LOAD_SWEEP_RATES[0]) - 1]);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--load") == 0) {
+    runLoadSweep(argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 0);
+    return 0;
+  }
+  if (argc > 1 && strcmp(argv[1], "--quick") == 0) {
+    iterations = 20000;
+  }
+
+  printf("Kroner-Hub pipeline benchmarks (%llu ops per stage)\n\n", (unsigned long long)iterations);
+  printHeader();
+  benchCodec();
+  benchParsing();
+  benchQueue();
+  benchBridgeCredits();
+  benchInputEdges();
+  benchPulsadorBatch();
+  benchRadioPacer();
+  benchUartTxTracker();
+  benchChronoCoalescing();
+  benchFanout();
+  benchMetrics();
+  benchPipeline();
+  return 0;
+}
+
+#endif  // PIO_UNIT_TESTING
@@ -0,0 +1,52 @@
+// Definiciones de los sustitutos de native/include para env:native
+// (benchmarks y tests de `pio test -e native`)
+
+#include <Arduino.h>
+
+FakeSerial Serial;
+HardwareSerial Serial2;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+// Reloj manual de los tests: activo desde el primer nativeSetMicros()
+static std::atomic<bool> manualClock(false);
+static std::atomic<uint32_t> manualUs(0);
+
+void nativeSetMicros(uint32_t us) {
+  manualUs.store(us);
+  manualClock.store(true);
+}
+
+void nativeAdvanceMicros(uint32_t us) {
+  manualUs.fetch_add(us);
+}
+
+void nativeRealClock() {
+  manualClock.store(false);
+}
+
+uint32_t micros() {
+  if (manualClock.load()) return manualUs.load();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime).count();
+}
+
+uint32_t millis() {
+  return micros() / 1000;
+}
+
+void delay(uint32_t ms) {
+  if (manualClock.load()) {
+    nativeAdvanceMicros(ms * 1000);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks * portTICK_PERIOD_MS);
+}
+
+// En el firmware despiertan tareas FreeRTOS; en el host no hay a quién despertar
+void notifyRadioTask() {}
+void notifyWebServerTask() {}
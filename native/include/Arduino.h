@@ -0,0 +1,124 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Sustituto mínimo de Arduino.h para env:native (Linux)
+// Solo lo que usan los módulos del pipeline que se compilan en el host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define IRAM_ATTR
+
+// =============================
+// Tiempo
+// =============================
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// Reloj manual para los tests: tras nativeSetMicros(), micros() y millis() solo
+// avanzan con nativeAdvanceMicros(), delay() y vTaskDelay(), que no duermen.
+// nativeRealClock() vuelve al reloj del sistema (el de los benchmarks)
+void nativeSetMicros(uint32_t us);
+void nativeAdvanceMicros(uint32_t us);
+void nativeRealClock();
+
+// =============================
+// FreeRTOS
+// =============================
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+void vTaskDelay(TickType_t ticks);
+
+// Sección crítica: spinlock (en el ESP32 también deshabilita interrupciones)
+struct portMUX_TYPE {
+  std::atomic<bool> locked;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+  while (mux->locked.exchange(true, std::memory_order_acquire)) {
+  }
+}
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+  mux->locked.store(false, std::memory_order_release);
+}
+
+// =============================
+// String (subconjunto)
+// =============================
+class String {
+public:
+  String() {}
+  String(const char* s) : value(s ? s : "") {}
+  void reserve(size_t n) { value.reserve(n); }
+  String& operator+=(const char* s) { value += s; return *this; }
+  String& operator+=(char c) { value += c; return *this; }
+  bool operator==(const String& other) const { return value == other.value; }
+  const char* c_str() const { return value.c_str(); }
+  size_t length() const { return value.length(); }
+
+private:
+  std::string value;
+};
+
+// =============================
+// Serial (descarta la salida de DEBUG_PRINT salvo con NATIVE_VERBOSE)
+// =============================
+class FakeSerial {
+public:
+  template <typename T> size_t print(const T&) { return 0; }
+  template <typename T> size_t println(const T&) { return 0; }
+  size_t println() { return 0; }
+  size_t printf(const char* format, ...) {
+#ifdef NATIVE_VERBOSE
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n > 0 ? (size_t)n : 0;
+#else
+    (void)format;
+    return 0;
+#endif
+  }
+};
+
+extern FakeSerial Serial;
+
+// UART del APC220: cuenta lo escrito y, con baud != 0, tarda lo que tardaría
+// la línea en sacar los bytes (8N1: 10 bits por byte)
+class HardwareSerial {
+public:
+  size_t write(const uint8_t* data, size_t len) {
+    (void)data;
+    if (baud != 0) {
+      auto until = std::chrono::steady_clock::now() + std::chrono::microseconds((uint64_t)len * 10000000 / baud);
+      while (std::chrono::steady_clock::now() < until) {
+      }
+    }
+    bytesWritten += len;
+    writes++;
+    return len;
+  }
+  void flush() {}
+  int available() { return 0; }
+
+  uint32_t baud = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t writes = 0;
+};
+
+extern HardwareSerial Serial2;
+
+#endif
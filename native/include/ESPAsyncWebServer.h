@@ -0,0 +1,55 @@
+#ifndef NATIVE_ESP_ASYNC_WEB_SERVER_H
+#define NATIVE_ESP_ASYNC_WEB_SERVER_H
+
+// Sustituto de AsyncWebSocket (ESPAsyncWebServer) para env:native: cuenta los
+// envíos por cliente y deja marcar clientes sin hueco en su cola de envío
+
+#include <Arduino.h>
+
+// Ids de cliente que distingue el sustituto (los mayores comparten contador)
+#define NATIVE_WS_IDS 64
+
+class AsyncWebSocket {
+public:
+  explicit AsyncWebSocket(const char* url) { (void)url; }
+
+  bool availableForWrite(uint32_t id) { return !blocked[id % NATIVE_WS_IDS]; }
+
+  bool text(uint32_t id, const char* message, size_t len) {
+    (void)message;
+    if (!availableForWrite(id)) return false;
+    textFrames++;
+    bytesSent += len;
+    framesTo[id % NATIVE_WS_IDS]++;
+    return true;
+  }
+
+  bool binary(uint32_t id, const uint8_t* message, size_t len) {
+    (void)message;
+    if (!availableForWrite(id)) return false;
+    binaryFrames++;
+    bytesSent += len;
+    framesTo[id % NATIVE_WS_IDS]++;
+    return true;
+  }
+
+  void close(uint32_t id, uint16_t code = 0, const char* message = nullptr) {
+    (void)code;
+    (void)message;
+    closed[id % NATIVE_WS_IDS] = true;
+  }
+
+  // Solo en el sustituto: simular un cliente con la cola TCP llena
+  void setWritable(uint32_t id, bool writable) { blocked[id % NATIVE_WS_IDS] = !writable; }
+
+  uint64_t textFrames = 0;
+  uint64_t binaryFrames = 0;
+  uint64_t bytesSent = 0;
+  uint32_t framesTo[NATIVE_WS_IDS] = {};
+  bool closed[NATIVE_WS_IDS] = {};
+
+private:
+  bool blocked[NATIVE_WS_IDS] = {};
+};
+
+#endif
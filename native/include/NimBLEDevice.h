@@ -0,0 +1,57 @@
+#ifndef NATIVE_NIMBLE_DEVICE_H
+#define NATIVE_NIMBLE_DEVICE_H
+
+// Sustituto de NimBLE-Arduino para env:native: característica con su valor en RAM
+
+#include <Arduino.h>
+
+namespace NIMBLE_PROPERTY {
+enum : uint16_t {
+  READ = 0x0002,
+  WRITE_NR = 0x0004,
+  WRITE = 0x0008,
+  NOTIFY = 0x0010,
+};
+}
+
+// Valor de un atributo (NimBLEAttValue): puntero y longitud
+class NimBLEAttValue {
+public:
+  NimBLEAttValue(const uint8_t* data, size_t len) : ptr(data), len(len) {}
+  const uint8_t* data() const { return ptr; }
+  size_t length() const { return len; }
+
+private:
+  const uint8_t* ptr;
+  size_t len;
+};
+
+class NimBLECharacteristic {
+public:
+  NimBLECharacteristic(const char* uuid, uint16_t properties, uint16_t maxLen)
+      : len(0), capacity(maxLen > sizeof(buffer) ? sizeof(buffer) : maxLen) {
+    (void)uuid;
+    (void)properties;
+  }
+
+  void setValue(const uint8_t* value, size_t length) {
+    if (length > capacity) length = capacity;
+    memcpy(buffer, value, length);
+    len = length;
+    writes++;
+  }
+
+  void notify() { notifications++; }
+
+  NimBLEAttValue getValue() const { return NimBLEAttValue(buffer, len); }
+
+  uint64_t writes = 0;
+  uint64_t notifications = 0;
+
+private:
+  uint8_t buffer[512];
+  size_t len;
+  size_t capacity;
+};
+
+#endif
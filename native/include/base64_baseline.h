@@ -0,0 +1,32 @@
+#ifndef NATIVE_BASE64_BASELINE_H
+#define NATIVE_BASE64_BASELINE_H
+
+// Codificador base64 de referencia para env:native: el bucle byte a byte que
+// usaba webserver_functions antes de base64_codec, con el relleno '=' que a
+// aquel le faltaba para poder comparar salidas. Lo usan el benchmark (como
+// línea base) y test_base64 (como oráculo).
+
+#include <stdint.h>
+#include <stddef.h>
+
+inline size_t base64EncodeBaseline(const uint8_t* in, size_t len, char* out) {
+  const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t n = 0;
+  size_t i = 0;
+  while (i < len) {
+    uint8_t b1 = in[i++];
+    bool has2 = i < len;
+    uint8_t b2 = has2 ? in[i++] : 0;
+    bool has3 = i < len;
+    uint8_t b3 = has3 ? in[i++] : 0;
+
+    out[n++] = alphabet[b1 >> 2];
+    out[n++] = alphabet[((b1 & 0x03) << 4) | (b2 >> 4)];
+    out[n++] = has2 ? alphabet[((b2 & 0x0F) << 2) | (b3 >> 6)] : '=';
+    out[n++] = has3 ? alphabet[b3 & 0x3F] : '=';
+  }
+  out[n] = '\0';
+  return n;
+}
+
+#endif
@@ -0,0 +1,32 @@
+"""
+Genera variantes .gz de los ficheros de texto de data/ antes de construir
+la imagen LittleFS (buildfs/uploadfs). El servidor web las sirve a los
+clientes que envían Accept-Encoding: gzip.
+"""
+import gzip
+import os
+import shutil
+
+Import("env")
+
+COMPRESSIBLE = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt")
+
+
+def gzip_assets(source, target, env):
+    data_dir = env.subst("$PROJECT_DATA_DIR")
+    for root, _, files in os.walk(data_dir):
+        for name in files:
+            if not name.endswith(COMPRESSIBLE):
+                continue
+            src = os.path.join(root, name)
+            dst = src + ".gz"
+            if os.path.exists(dst) and os.path.getmtime(dst) >= os.path.getmtime(src):
+                continue
+            # mtime=0: mismo contenido -> mismo .gz -> mismo ETag
+            with open(src, "rb") as f_in, open(dst, "wb") as raw:
+                with gzip.GzipFile(filename="", mode="wb", fileobj=raw, compresslevel=9, mtime=0) as f_out:
+                    shutil.copyfileobj(f_in, f_out)
+            print("gzip_assets: %s -> %s" % (os.path.relpath(src, data_dir), os.path.basename(dst)))
+
+
+env.AddPreAction("$BUILD_DIR/${ESP32_FS_IMAGE_NAME}.bin", gzip_assets)
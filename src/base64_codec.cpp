@@ -0,0 +1,50 @@
+#include <string.h>
+#include "base64_codec.h"
+
+static const char ALPHABET[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Tabla de 4096 entradas: 12 bits -> 2 caracteres. Cada grupo de 3 bytes son
+// dos búsquedas y dos copias de 2 bytes. Se genera al compilar (8 KB en flash)
+struct Base64PairTable {
+  char pairs[4096][2];
+  constexpr Base64PairTable() : pairs() {
+    for (int v = 0; v < 4096; v++) {
+      pairs[v][0] = ALPHABET[v >> 6];
+      pairs[v][1] = ALPHABET[v & 0x3F];
+    }
+  }
+};
+
+static constexpr Base64PairTable PAIRS;
+
+size_t base64Encode(const uint8_t* in, size_t len, char* out) {
+  char* p = out;
+  size_t i = 0;
+
+  // Grupos completos de 3 bytes -> 4 caracteres
+  for (; i + 2 < len; i += 3) {
+    uint32_t v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+    memcpy(p, PAIRS.pairs[v >> 12], 2);
+    memcpy(p + 2, PAIRS.pairs[v & 0xFFF], 2);
+    p += 4;
+  }
+
+  // Resto (1 o 2 bytes) con relleno
+  size_t rest = len - i;
+  if (rest == 1) {
+    uint32_t v = (uint32_t)in[i] << 4;
+    memcpy(p, PAIRS.pairs[v], 2);
+    p[2] = '=';
+    p[3] = '=';
+    p += 4;
+  } else if (rest == 2) {
+    uint32_t v = ((uint32_t)in[i] << 10) | ((uint32_t)in[i + 1] << 2);
+    memcpy(p, PAIRS.pairs[v >> 6], 2);
+    p[2] = ALPHABET[v & 0x3F];
+    p[3] = '=';
+    p += 4;
+  }
+
+  *p = '\0';
+  return (size_t)(p - out);
+}
@@ -0,0 +1,26 @@
+#ifndef BASE64_CODEC_H
+#define BASE64_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Longitud de la codificación base64 (con relleno '=', sin el '\0')
+ */
+inline size_t base64EncodedLength(size_t len) {
+  return ((len + 2) / 3) * 4;
+}
+
+/**
+ * @brief Codifica en base64 estándar (RFC 4648, con relleno)
+ *
+ * Procesa grupos de 3 bytes con una tabla de 4096 entradas (12 bits -> 2
+ * caracteres): dos búsquedas por grupo en lugar de cuatro.
+ * @param in Bytes de entrada
+ * @param len Longitud de la entrada
+ * @param out Destino; debe admitir base64EncodedLength(len) + 1 bytes
+ * @return Caracteres escritos (sin contar el '\0' final)
+ */
+size_t base64Encode(const uint8_t* in, size_t len, char* out);
+
+#endif
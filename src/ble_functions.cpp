@@ -1,50 +1,195 @@
 #include "kroner_config.h"
 #include "ble_functions.h"
+#include "task_functions.h"
+#include "latency_metrics.h"
+#include "system_stats.h"
+#include "load_generator.h"
+#include "input_functions.h"
 
-// Servicios y características BLE
-BLEService pulsadorService("19B10000-E8F2-537E-4F6C-D104768A1214");
-BLECharacteristic pulsadorCharacteristic("b444ea9a-a1b8-11ee-8c90-0242ac120002", BLENotify | BLERead, 40);
-BLECharacteristic firmwareCharacteristic("c555fa9a-a1b8-11ee-8c90-0242ac120003", BLERead | BLEWrite, 50);
+// Servidor y características BLE (se crean en initBLE())
+NimBLEServer* bleServer = nullptr;
+NimBLEService* pulsadorService = nullptr;
+NimBLECharacteristic* pulsadorCharacteristic = nullptr;
+NimBLECharacteristic* firmwareCharacteristic = nullptr;
+NimBLECharacteristic* latencyCharacteristic = nullptr;
+NimBLECharacteristic* systemStatsCharacteristic = nullptr;
+NimBLEService* serialBridgeService = nullptr;
+NimBLECharacteristic* serialBridgeWriteChar = nullptr;
+NimBLECharacteristic* serialBridgeNotifyChar = nullptr;
+NimBLECharacteristic* serialBridgeCreditsChar = nullptr;
 
-BLEService serialBridgeService("12345678-1234-5678-1234-56789abcdef0");
-BLECharacteristic serialBridgeWriteChar("12345678-1234-5678-1234-56789abcdef1", BLEWrite | BLEWriteWithoutResponse, 244);
+// Cola de tramas recibidas por BLE (para enviar al APC220)
+// Productores: callback de escritura (tarea de NimBLE) y generador de carga
+// (tarea BLE), serializados con bleBridgeMux; consumidor: tarea de radio
+BridgeQueue bleBridgeQueue(BRIDGE_QUEUE_DROP_POLICY);
+static portMUX_TYPE bleBridgeMux = portMUX_INITIALIZER_UNLOCKED;
 
-// Buffer para datos recibidos por BLE (para enviar al APC220)
-volatile uint8_t bleMessageBuffer[255];
-volatile int bleMessageLen = 0;
-volatile unsigned long bleMessageTime = 0;
-volatile bool bleMessageReady = false;
+// Créditos que se conceden al teléfono según lo que la radio va vaciando
+BridgeCredits bridgeCredits;
 
-void initBLE() {
-  if (!BLE.begin()) {
-    Serial.println("No se pudo iniciar BLE");
-    while (1);
+// Estado de la conexión (escrito por los callbacks de NimBLE)
+static volatile bool centralConnected = false;
+static volatile uint16_t negotiatedMtu = BLE_DEFAULT_MTU;
+
+// Bytes máximos por escritura en el puente con una MTU dada
+static uint16_t bridgeMaxWrite(uint16_t mtu) {
+  return mtu - 3 < BRIDGE_FRAME_MAX ? mtu - 3 : BRIDGE_FRAME_MAX;
+}
+
+/**
+ * @brief Conexión y desconexión del central
+ * Pide intervalo corto y MTU grande; el trabajo de (des)conexión lo hace la
+ * tarea BLE, a la que solo se despierta
+ */
+class HubServerCallbacks : public NimBLEServerCallbacks {
+  void onConnect(NimBLEServer* server, ble_gap_conn_desc* desc) override {
+    negotiatedMtu = BLE_DEFAULT_MTU;
+    centralConnected = true;
+    bridgeCredits.reset(bridgeMaxWrite(BLE_DEFAULT_MTU));
+    serviceBridgeCredits(false);   // Valor inicial legible antes de suscribirse
+    server->updateConnParams(desc->conn_handle, BLE_CONN_INTERVAL_MIN, BLE_CONN_INTERVAL_MAX,
+                             BLE_CONN_LATENCY, BLE_CONN_TIMEOUT);
+#if !defined(CONFIG_IDF_TARGET_ESP32)
+    // El controlador del ESP32 clásico es BLE 4.2 y no tiene 2M PHY
+    ble_gap_set_prefered_le_phy(desc->conn_handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK,
+                                BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+    DEBUG_PRINT("BLE Connected: ");
+    DEBUG_PRINTLN(NimBLEAddress(desc->peer_ota_addr).toString().c_str());
+    notifyBleTask();
+  }
+
+  void onDisconnect(NimBLEServer* server, ble_gap_conn_desc* desc) override {
+    (void)server;
+    (void)desc;
+    centralConnected = false;
+    negotiatedMtu = BLE_DEFAULT_MTU;
+    notifyBleTask();
+  }
+
+  void onMTUChange(uint16_t mtu, ble_gap_conn_desc* desc) override {
+    (void)desc;
+    negotiatedMtu = mtu;
+    setPulsadorMtu(mtu);
+    bridgeCredits.setMaxWrite(bridgeMaxWrite(mtu));
+    serviceBridgeCredits(true);
+    DEBUG_PRINT("BLE MTU: ");
+    DEBUG_PRINTLN(mtu);
+  }
+};
+
+/**
+ * @brief Comandos escritos en firmwareCharacteristic
+ */
+class FirmwareCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* characteristic) override {
+    NimBLEAttValue value = characteristic->getValue();
+    if (value.length() == 0) return;
+    String command = "";
+    for (size_t i = 0; i < value.length(); i++) {
+      command += (char)value.data()[i];
+    }
+    command.trim();
+    processBLECommand(command);
   }
+};
 
-  // Configurar el nombre del dispositivo BLE
-  BLE.setLocalName("Kroner-Hub");
-  BLE.setDeviceName("Kroner-Hub");
+/**
+ * @brief Tramas escritas en el puente serie: encolar para la tarea de radio
+ */
+class SerialBridgeCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* characteristic) override {
+    NimBLEAttValue value = characteristic->getValue();
+    size_t len = value.length();
+    if (len == 0 || len > BRIDGE_FRAME_MAX) return;
+
+    portENTER_CRITICAL(&bleBridgeMux);
+    bool queued = bleBridgeQueue.push(value.data(), len, millis(), micros());
+    portEXIT_CRITICAL(&bleBridgeMux);
+    if (!queued) {
+      DEBUG_PRINTLN("BLE mensaje descartado: cola llena");
+      return;
+    }
+    bridgeCredits.onReceived(len);
+    notifyRadioTask();
+
+    DEBUG_PRINT("BLE mensaje recibido (bytes): ");
+    DEBUG_PRINTLN(len);
+  }
+};
+
+/**
+ * @brief Al suscribirse a los créditos, el teléfono recibe la concesión actual
+ */
+class CreditsCallbacks : public NimBLECharacteristicCallbacks {
+  void onSubscribe(NimBLECharacteristic* characteristic, ble_gap_conn_desc* desc, uint16_t subValue) override {
+    (void)characteristic;
+    (void)desc;
+    if (subValue != 0) serviceBridgeCredits(true);
+  }
+};
+
+static HubServerCallbacks serverCallbacks;
+static FirmwareCallbacks firmwareCallbacks;
+static SerialBridgeCallbacks serialBridgeCallbacks;
+static CreditsCallbacks creditsCallbacks;
+
+void initBLE() {
+  NimBLEDevice::init("Kroner-Hub");
+  NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+#if !defined(CONFIG_IDF_TARGET_ESP32)
+  ble_gap_set_prefered_default_le_phy(BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK);
+#endif
+
+  bleServer = NimBLEDevice::createServer();
+  bleServer->setCallbacks(&serverCallbacks, false);
 
   // Configurar el servicio BLE de pulsadores
-  pulsadorService.addCharacteristic(pulsadorCharacteristic);
-  pulsadorService.addCharacteristic(firmwareCharacteristic);
-  BLE.addService(pulsadorService);
+  pulsadorService = bleServer->createService("19B10000-E8F2-537E-4F6C-D104768A1214");
+  pulsadorCharacteristic = pulsadorService->createCharacteristic(
+      "b444ea9a-a1b8-11ee-8c90-0242ac120002", NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, PULSADOR_NOTIFY_MAX);
+  firmwareCharacteristic = pulsadorService->createCharacteristic(
+      "c555fa9a-a1b8-11ee-8c90-0242ac120003", NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE, 100);
+  latencyCharacteristic = pulsadorService->createCharacteristic(
+      "d666fa9a-a1b8-11ee-8c90-0242ac120004", NIMBLE_PROPERTY::READ, LATENCY_SUMMARY_LEN);
+  systemStatsCharacteristic = pulsadorService->createCharacteristic(
+      "e777fa9a-a1b8-11ee-8c90-0242ac120005", NIMBLE_PROPERTY::READ, SYSTEM_STATS_BIN_LEN);
+  firmwareCharacteristic->setCallbacks(&firmwareCallbacks);
+  pulsadorService->start();
 
   // Servicio de puente serie
-  serialBridgeService.addCharacteristic(serialBridgeWriteChar);
-  BLE.addService(serialBridgeService);
-  
-  // Configurar callbacks
-  firmwareCharacteristic.setEventHandler(BLEWritten, onFirmwareCharacteristicWritten);
-  serialBridgeWriteChar.setEventHandler(BLEWritten, onSerialBridgeWritten);
+  serialBridgeService = bleServer->createService("12345678-1234-5678-1234-56789abcdef0");
+  serialBridgeWriteChar = serialBridgeService->createCharacteristic(
+      "12345678-1234-5678-1234-56789abcdef1", NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR, BRIDGE_FRAME_MAX);
+  serialBridgeNotifyChar = serialBridgeService->createCharacteristic(
+      "12345678-1234-5678-1234-56789abcdef2", NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, BLE_PREFERRED_MTU - 3);
+  serialBridgeCreditsChar = serialBridgeService->createCharacteristic(
+      "12345678-1234-5678-1234-56789abcdef3", NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, BRIDGE_CREDITS_LEN);
+  serialBridgeWriteChar->setCallbacks(&serialBridgeCallbacks);
+  serialBridgeCreditsChar->setCallbacks(&creditsCallbacks);
+  serialBridgeService->start();
+
+  // El generador de carga inyecta en la misma cola que el callback del puente
+  loadGeneratorInit(bleBridgeQueue, notifyRadioTask, simulateInputEvent, &bleBridgeMux);
 
-  // Iniciar el anuncio BLE
-  BLE.setAdvertisingInterval(320); // 200 * 0.625 ms
-  BLE.advertise();
+  // Iniciar el anuncio BLE (NimBLE lo reanuda solo tras una desconexión)
+  NimBLEAdvertising* advertising = NimBLEDevice::getAdvertising();
+  advertising->setName("Kroner-Hub");
+  advertising->setMinInterval(BLE_ADV_INTERVAL);
+  advertising->setMaxInterval(BLE_ADV_INTERVAL);
+  advertising->start();
 
   DEBUG_PRINTLN("BLE iniciado correctamente");
 }
 
+bool bleIsConnected() {
+  return centralConnected;
+}
+
+uint16_t bleNegotiatedMtu() {
+  return negotiatedMtu;
+}
+
 void sendFirmwareInfo() {
   char firmwareInfo[100];
   snprintf(firmwareInfo, sizeof(firmwareInfo), 
@@ -57,17 +202,83 @@ void sendFirmwareInfo() {
   DEBUG_PRINT("Enviando info firmware: ");
   DEBUG_PRINTLN(firmwareInfo);
   
-  firmwareCharacteristic.writeValue((uint8_t*)firmwareInfo, strlen(firmwareInfo));
+  firmwareCharacteristic->setValue((uint8_t*)firmwareInfo, strlen(firmwareInfo));
 }
 
 void sendHelpInfo() {
   char helperInfo[200];
   snprintf(helperInfo, sizeof(helperInfo), 
-           "Help | FW Version | RESET");
+           "Help | FW Version | RESET | LOAD [k=v|STOP] | EVENTS BIN [mtu]|TEXT");
   
   DEBUG_PRINT("Enviando info ayuda: ");
   DEBUG_PRINTLN(helperInfo);
-  firmwareCharacteristic.writeValue((uint8_t*)helperInfo, strlen(helperInfo));
+  firmwareCharacteristic->setValue((uint8_t*)helperInfo, strlen(helperInfo));
+}
+
+/**
+ * @brief Comando LOAD: arranca (con parámetros), detiene (STOP) o informa (sin nada)
+ * La respuesta es el resumen de una línea de la prueba en curso o de la última
+ */
+static void processLoadCommand(String args) {
+  args.trim();
+  if (args == "STOP") {
+    loadGeneratorStop();
+  } else if (args.length() > 0) {
+    LoadGeneratorConfig config = loadGeneratorDefaults();
+    if (!loadGeneratorParseArgs(config, args.c_str())) {
+      const char* error = "LOAD: parametro no valido";
+      firmwareCharacteristic->setValue((const uint8_t*)error, strlen(error));
+      return;
+    }
+    loadGeneratorStart(config);
+    notifyBleTask();   // El generador corre en la tarea BLE, que puede estar dormida
+  }
+
+  char summary[50];
+  size_t len = formatLoadGeneratorReport(loadGeneratorGetReport(), summary, sizeof(summary));
+  DEBUG_PRINTLN(summary);
+  firmwareCharacteristic->setValue((uint8_t*)summary, len);
+}
+
+/**
+ * @brief Comando EVENTS: formato de pulsadorCharacteristic
+ * "EVENTS BIN [mtu]" pasa a registros binarios por lotes (por defecto con la MTU
+ * negociada; una menor limita el tamaño de los lotes), "EVENTS TEXT" vuelve al
+ * formato anterior y "EVENTS" solo informa. Al pasar a binario se reenvía el
+ * estado de los switches, que al conectar salió en texto.
+ */
+static void processEventsCommand(String args) {
+  args.trim();
+  if (args == "TEXT") {
+    setPulsadorFormat(false, 0);
+  } else if (args == "BIN" || args.startsWith("BIN ")) {
+    long mtu = args.length() > 3 ? args.substring(4).toInt() : 0;
+    if (mtu < 0 || mtu > 517) {
+      const char* error = "EVENTS: mtu no valida";
+      firmwareCharacteristic->setValue((const uint8_t*)error, strlen(error));
+      return;
+    }
+    if (mtu == 0 || mtu > negotiatedMtu) mtu = negotiatedMtu;
+    setPulsadorFormat(true, (uint16_t)mtu);
+    sendInitialSwitchState(0, INPUT7PIN);
+    sendInitialSwitchState(1, INPUT8PIN);
+    sendInitialSwitchState(2, INPUT9PIN);
+  } else if (args.length() > 0) {
+    const char* error = "EVENTS: BIN [mtu] o TEXT";
+    firmwareCharacteristic->setValue((const uint8_t*)error, strlen(error));
+    return;
+  }
+
+  char summary[50];
+  if (pulsadorBinaryEnabled()) {
+    size_t payload = pulsadorPayloadMax();
+    snprintf(summary, sizeof(summary), "EVENTS BIN v%u payload=%u max=%u", PULSADOR_EVENTS_VERSION, (unsigned)payload,
+             (unsigned)((payload - PULSADOR_EVENTS_HEADER_LEN) / PULSADOR_EVENTS_RECORD_LEN));
+  } else {
+    snprintf(summary, sizeof(summary), "EVENTS TEXT");
+  }
+  DEBUG_PRINTLN(summary);
+  firmwareCharacteristic->setValue((uint8_t*)summary, strlen(summary));
 }
 
 void processBLECommand(const String& command) {
@@ -81,10 +292,19 @@ void processBLECommand(const String& command) {
     DEBUG_PRINTLN("Reiniciando dispositivo...");
     ESP.restart();
   }
+  else if (command == "LOAD" || command.startsWith("LOAD ")) {
+    processLoadCommand(command.substring(4));
+  }
+  else if (command == "EVENTS" || command.startsWith("EVENTS ")) {
+    processEventsCommand(command.substring(6));
+  }
   else if (command == "HELP" || command == "Help" || command == "help") {
     DEBUG_PRINTLN("Comandos disponibles:");
     DEBUG_PRINTLN(" - FW Version");
     DEBUG_PRINTLN(" - RESET");
+    DEBUG_PRINTLN(" - LOAD rate=N size=N kind=chrono|text displays=N seconds=N inputs=N");
+    DEBUG_PRINTLN(" - LOAD STOP / LOAD (informe)");
+    DEBUG_PRINTLN(" - EVENTS BIN [mtu] / EVENTS TEXT / EVENTS (informe)");
     DEBUG_PRINTLN(" - HELP");
     sendHelpInfo();
   }
@@ -94,28 +314,59 @@ void processBLECommand(const String& command) {
   }
 }
 
-void onFirmwareCharacteristicWritten(BLEDevice central, BLECharacteristic characteristic) {
-  String command = "";
-  if (characteristic.valueLength() > 0) {
-    for (int i = 0; i < characteristic.valueLength(); i++) {
-      command += (char)characteristic.value()[i];
-    }
-    command.trim();
-    processBLECommand(command);
+/**
+ * @brief Actualiza el resumen de latencias que se lee por BLE
+ */
+void updateLatencyCharacteristic() {
+  uint8_t summary[LATENCY_SUMMARY_LEN];
+  size_t len = packLatencySummary(summary, sizeof(summary));
+  latencyCharacteristic->setValue(summary, len);
+}
+
+/**
+ * @brief Actualiza la instantánea del sistema que se lee por BLE
+ */
+void updateSystemStatsCharacteristic() {
+  uint8_t packed[SYSTEM_STATS_BIN_LEN];
+  size_t len = packSystemStats(getSystemStats(), packed, sizeof(packed));
+  systemStatsCharacteristic->setValue(packed, len);
+}
+
+/**
+ * @brief Notifica por BLE una trama recibida por el APC220
+ * Las tramas mayores que la MTU negociada se envían en varios trozos
+ */
+void notifyBridgeRx(const uint8_t* data, size_t len) {
+  const size_t maxChunk = negotiatedMtu - 3;
+  while (len > 0) {
+    size_t chunk = len > maxChunk ? maxChunk : len;
+    serialBridgeNotifyChar->setValue(data, chunk);
+    serialBridgeNotifyChar->notify();
+    data += chunk;
+    len -= chunk;
   }
 }
 
-void onSerialBridgeWritten(BLEDevice central, BLECharacteristic characteristic) {
-  int len = characteristic.valueLength();
-  if (len <= 0 || len > 255) return;
-  const uint8_t* data = characteristic.value();
+/**
+ * @brief Recalcula los créditos del puente y los notifica si han avanzado lo
+ * suficiente (o siempre, con force). La llama la tarea de radio tras cada trama.
+ */
+void serviceBridgeCredits(bool force) {
+  if (serialBridgeCreditsChar == nullptr) return;
+  BridgeQueueStats queue = bleBridgeQueue.getStats();
+  BridgeCreditGrant grant;
+  if (!bridgeCredits.update(BridgeQueue::CAPACITY - queue.depth, force, grant)) return;
 
-  // Guardar datos en buffer para que la tarea los procese
-  memcpy((void*)bleMessageBuffer, data, len);
-  bleMessageLen = len;
-  bleMessageTime = millis();
-  bleMessageReady = true;
+  uint8_t packed[BRIDGE_CREDITS_LEN];
+  size_t len = packBridgeCredits(grant, packed);
+  serialBridgeCreditsChar->setValue(packed, len);
+  serialBridgeCreditsChar->notify();
+}
 
-  DEBUG_PRINT("BLE mensaje recibido (bytes): ");
-  DEBUG_PRINTLN(len);
+/**
+ * @brief Notifica un evento (o un lote de eventos) en pulsadorCharacteristic
+ */
+void notifyPulsador(const uint8_t* data, size_t len) {
+  pulsadorCharacteristic->setValue(data, len);
+  pulsadorCharacteristic->notify();
 }
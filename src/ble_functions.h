@@ -2,27 +2,39 @@
 #define BLE_FUNCTIONS_H
 
 #include <Arduino.h>
-#include <ArduinoBLE.h>
+#include <NimBLEDevice.h>
+#include "bridge_queue.h"
+#include "bridge_credits.h"
 
-// Declaración de variables globales BLE (definidas en ble_functions.cpp)
-extern BLEService pulsadorService;
-extern BLECharacteristic pulsadorCharacteristic;
-extern BLECharacteristic firmwareCharacteristic;
-extern BLEService serialBridgeService;
-extern BLECharacteristic serialBridgeWriteChar;
+// Servidor y características BLE (definidos en ble_functions.cpp, creados en initBLE())
+extern NimBLEServer* bleServer;
+extern NimBLEService* pulsadorService;
+extern NimBLECharacteristic* pulsadorCharacteristic;
+extern NimBLECharacteristic* firmwareCharacteristic;
+extern NimBLECharacteristic* latencyCharacteristic;
+extern NimBLECharacteristic* systemStatsCharacteristic;
+extern NimBLEService* serialBridgeService;
+extern NimBLECharacteristic* serialBridgeWriteChar;
+extern NimBLECharacteristic* serialBridgeNotifyChar;
+extern NimBLECharacteristic* serialBridgeCreditsChar;
 
-// Buffer para datos recibidos por BLE (para enviar al APC220)
-extern volatile uint8_t bleMessageBuffer[255];
-extern volatile int bleMessageLen;
-extern volatile unsigned long bleMessageTime;
-extern volatile bool bleMessageReady;
+// Cola de tramas recibidas por BLE (para enviar al APC220) y sus créditos
+extern BridgeQueue bleBridgeQueue;
+extern BridgeCredits bridgeCredits;
 
 // Funciones BLE
 void initBLE();
 void sendFirmwareInfo();
 void sendHelpInfo();
 void processBLECommand(const String& command);
-void onFirmwareCharacteristicWritten(BLEDevice central, BLECharacteristic characteristic);
-void onSerialBridgeWritten(BLEDevice central, BLECharacteristic characteristic);
+void notifyBridgeRx(const uint8_t* data, size_t len);
+void notifyPulsador(const uint8_t* data, size_t len);
+void serviceBridgeCredits(bool force);
+void updateLatencyCharacteristic();
+void updateSystemStatsCharacteristic();
+
+// Estado de la conexión (lo actualizan los callbacks de NimBLE)
+bool bleIsConnected();
+uint16_t bleNegotiatedMtu();   // MTU de la conexión actual (23 sin negociar)
 
 #endif
@@ -0,0 +1,98 @@
+#include "bridge_credits.h"
+
+BridgeCredits::BridgeCredits() {
+  reset(BRIDGE_FRAME_MAX);
+}
+
+void BridgeCredits::reset(uint16_t maxWrite) {
+  portENTER_CRITICAL(&mux);
+  memset(&stats, 0, sizeof(stats));
+  stats.grant.maxWrite = maxWrite;
+  sent = stats.grant;
+  pendingFirst = true;
+  portEXIT_CRITICAL(&mux);
+}
+
+void BridgeCredits::setMaxWrite(uint16_t maxWrite) {
+  portENTER_CRITICAL(&mux);
+  stats.grant.maxWrite = maxWrite;
+  portEXIT_CRITICAL(&mux);
+}
+
+void BridgeCredits::onReceived(size_t len) {
+  portENTER_CRITICAL(&mux);
+  stats.receivedBytes += len;
+  stats.receivedFrames++;
+  if ((int32_t)(stats.receivedBytes - sent.byteLimit) > 0 ||
+      (int32_t)(stats.receivedFrames - sent.frameLimit) > 0) {
+    stats.overruns++;
+  }
+  portEXIT_CRITICAL(&mux);
+}
+
+// Las tramas del generador de carga comparten la cola: lo liberado nunca
+// supera lo recibido del teléfono
+void BridgeCredits::releaseLocked(uint32_t len) {
+  uint32_t pending = stats.receivedBytes - stats.drainedBytes;
+  stats.drainedBytes += len < pending ? len : pending;
+}
+
+void BridgeCredits::onDrained(size_t len) {
+  portENTER_CRITICAL(&mux);
+  releaseLocked(len);
+  portEXIT_CRITICAL(&mux);
+}
+
+void BridgeCredits::onDropped(uint32_t bytes) {
+  portENTER_CRITICAL(&mux);
+  stats.droppedBytes += bytes;
+  releaseLocked(bytes);
+  portEXIT_CRITICAL(&mux);
+}
+
+bool BridgeCredits::update(uint32_t freeSlots, bool force, BridgeCreditGrant& out) {
+  portENTER_CRITICAL(&mux);
+  uint32_t pending = stats.receivedBytes - stats.drainedBytes;
+  stats.pendingBytes = pending;
+  uint32_t room = pending < BRIDGE_CREDIT_WINDOW_BYTES ? BRIDGE_CREDIT_WINDOW_BYTES - pending : 0;
+
+  BridgeCreditGrant& grant = stats.grant;
+  uint32_t byteLimit = stats.receivedBytes + room;
+  uint32_t frameLimit = stats.receivedFrames + freeSlots;
+  if ((int32_t)(byteLimit - grant.byteLimit) > 0) grant.byteLimit = byteLimit;
+  if ((int32_t)(frameLimit - grant.frameLimit) > 0) grant.frameLimit = frameLimit;
+
+  // Notificar si el avance merece la pena, si el teléfono está parado
+  // esperando créditos o si ya no queda nada por escribir en la UART
+  bool grew = grant.byteLimit != sent.byteLimit || grant.frameLimit != sent.frameLimit ||
+              grant.maxWrite != sent.maxWrite;
+  // Con signo: si el teléfono se pasó de lo concedido, también está parado
+  bool stalled = (int32_t)(sent.byteLimit - stats.receivedBytes) < (int32_t)grant.maxWrite ||
+                 (int32_t)(sent.frameLimit - stats.receivedFrames) <= 0;
+  bool notify = pendingFirst || force ||
+                (grew && (grant.byteLimit - sent.byteLimit >= BRIDGE_CREDIT_NOTIFY_BYTES || stalled || pending == 0));
+  if (notify) {
+    sent = grant;
+    pendingFirst = false;
+    stats.notifications++;
+  }
+  out = grant;
+  portEXIT_CRITICAL(&mux);
+  return notify;
+}
+
+BridgeCreditStats BridgeCredits::getStats() const {
+  portENTER_CRITICAL(&mux);
+  BridgeCreditStats snapshot = stats;
+  portEXIT_CRITICAL(&mux);
+  return snapshot;
+}
+
+size_t packBridgeCredits(const BridgeCreditGrant& grant, uint8_t* out) {
+  out[0] = BRIDGE_CREDITS_VERSION;
+  out[1] = 0;
+  memcpy(out + 2, &grant.maxWrite, sizeof(grant.maxWrite));
+  memcpy(out + 4, &grant.byteLimit, sizeof(grant.byteLimit));
+  memcpy(out + 8, &grant.frameLimit, sizeof(grant.frameLimit));
+  return BRIDGE_CREDITS_LEN;
+}
@@ -0,0 +1,87 @@
+#ifndef BRIDGE_CREDITS_H
+#define BRIDGE_CREDITS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "kroner_config.h"
+
+// Concesión de créditos del puente serie (notificación, little-endian):
+//   [0] versión  [1] reservado  [2..3] bytes máximos por escritura (uint16)
+//   [4..7] límite de bytes (uint32)  [8..11] límite de escrituras (uint32)
+// Los límites son acumulados desde la conexión: el teléfono puede escribir
+// mientras sus bytes y escrituras enviados estén por debajo de ellos, así una
+// notificación perdida o atrasada nunca concede de más.
+#define BRIDGE_CREDITS_VERSION 1
+#define BRIDGE_CREDITS_LEN 12
+
+struct BridgeCreditGrant {
+  uint32_t byteLimit;      // Bytes acumulados que puede haber escrito el teléfono
+  uint32_t frameLimit;     // Escrituras acumuladas (cada una ocupa un hueco de la cola)
+  uint16_t maxWrite;       // Bytes máximos por escritura
+};
+
+// Contadores (instantánea)
+struct BridgeCreditStats {
+  uint32_t receivedBytes;  // Bytes escritos por el teléfono desde la conexión
+  uint32_t receivedFrames;
+  uint32_t drainedBytes;   // Bytes del puente BLE ya transmitidos por la UART
+  uint32_t droppedBytes;   // Bytes descartados en bleBridgeQueue (no saldrán por la UART)
+  uint32_t pendingBytes;   // Recibidos y aún no transmitidos por la UART
+  uint32_t notifications;  // Concesiones notificadas
+  uint32_t overruns;       // Escrituras por encima de lo concedido
+  BridgeCreditGrant grant; // Última concesión
+};
+
+/**
+ * @brief Control de flujo por créditos del puente serie BLE -> APC220
+ *
+ * La ventana de bytes es BRIDGE_CREDIT_WINDOW_BYTES menos lo que aún no ha
+ * salido por la UART (cola del puente y buffer de transmisión); la de
+ * escrituras, los huecos libres de bleBridgeQueue. Los límites solo crecen.
+ * Escriben el callback BLE (recibido), la tarea de radio (vaciado) y la tarea
+ * BLE (conexión): todo bajo un portMUX.
+ */
+class BridgeCredits {
+public:
+  BridgeCredits();
+
+  // Nueva conexión: contadores a cero y primera concesión pendiente de notificar
+  void reset(uint16_t maxWrite);
+
+  // Cambia el tamaño máximo por escritura (MTU negociada)
+  void setMaxWrite(uint16_t maxWrite);
+
+  // Escritura del teléfono aceptada en la cola
+  void onReceived(size_t len);
+
+  // Trama del puente BLE ya transmitida por la UART
+  void onDrained(size_t len);
+
+  // Tramas descartadas en la cola (BRIDGE_DROP_OLDEST): ya no ocupan la ventana
+  void onDropped(uint32_t bytes);
+
+  /**
+   * @brief Recalcula la concesión con los huecos libres de la cola
+   * @param force Notificar aunque no haya avance (suscripción, MTU)
+   * @return true si hay que notificarla (queda registrada como enviada)
+   */
+  bool update(uint32_t freeSlots, bool force, BridgeCreditGrant& out);
+
+  BridgeCreditStats getStats() const;
+
+private:
+  void releaseLocked(uint32_t len);
+
+  BridgeCreditStats stats;
+  BridgeCreditGrant sent;   // Última concesión notificada
+  bool pendingFirst;
+  mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+/**
+ * @brief Empaqueta una concesión (BRIDGE_CREDITS_LEN bytes)
+ */
+size_t packBridgeCredits(const BridgeCreditGrant& grant, uint8_t* out);
+
+#endif
@@ -0,0 +1,93 @@
+#include "bridge_queue.h"
+#include <string.h>
+
+BridgeQueue::BridgeQueue(BridgeDropPolicy policy)
+    : head(0), tail(0), dropPolicy(policy),
+      pushedCount(0), poppedCount(0), droppedOldestCount(0), droppedOldestBytes(0),
+      droppedNewestCount(0), rejectedCount(0), maxDepth(0) {
+  memset(slots, 0, sizeof(slots));
+}
+
+bool BridgeQueue::push(const uint8_t* data, size_t len, uint32_t time, uint32_t stampUs) {
+  if (data == nullptr || len == 0 || len > BRIDGE_FRAME_MAX) {
+    rejectedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t h = head.load(std::memory_order_relaxed);
+  uint32_t t = tail.load(std::memory_order_acquire);
+
+  // Cola llena: aplicar la política de descarte
+  while (h - t >= CAPACITY) {
+    if (dropPolicy.load(std::memory_order_relaxed) == BRIDGE_DROP_NEWEST) {
+      droppedNewestCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    // Adelantar la cola; si falla es que el consumidor acaba de liberar un hueco.
+    // Solo el productor escribe los huecos: la longitud leída antes es la descartada
+    uint16_t droppedLen = slots[t & MASK].len;
+    if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      droppedOldestCount.fetch_add(1, std::memory_order_relaxed);
+      droppedOldestBytes.fetch_add(droppedLen, std::memory_order_relaxed);
+      t = t + 1;
+    }
+  }
+
+  BridgeFrame& slot = slots[h & MASK];
+  memcpy(slot.data, data, len);
+  slot.len = (uint16_t)len;
+  slot.time = time;
+  slot.stampUs = stampUs;
+  head.store(h + 1, std::memory_order_release);
+
+  pushedCount.fetch_add(1, std::memory_order_relaxed);
+  uint32_t depth = h + 1 - t;
+  if (depth > maxDepth.load(std::memory_order_relaxed)) {
+    maxDepth.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool BridgeQueue::pop(BridgeFrame& out) {
+  uint32_t t = tail.load(std::memory_order_acquire);
+  for (;;) {
+    uint32_t h = head.load(std::memory_order_acquire);
+    if (t == h) {
+      return false;
+    }
+
+    const BridgeFrame& slot = slots[t & MASK];
+    uint16_t len = slot.len;
+    if (len > BRIDGE_FRAME_MAX) len = BRIDGE_FRAME_MAX;
+    out.time = slot.time;
+    out.stampUs = slot.stampUs;
+    out.len = len;
+    memcpy(out.data, slot.data, len);
+
+    // Confirmar la lectura; si el productor descartó esta trama mientras se
+    // copiaba, la copia puede estar corrupta y se reintenta con la siguiente
+    if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      poppedCount.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+}
+
+uint32_t BridgeQueue::size() const {
+  uint32_t t = tail.load(std::memory_order_acquire);
+  uint32_t h = head.load(std::memory_order_acquire);
+  return h - t;
+}
+
+BridgeQueueStats BridgeQueue::getStats() const {
+  BridgeQueueStats stats;
+  stats.pushed = pushedCount.load(std::memory_order_relaxed);
+  stats.popped = poppedCount.load(std::memory_order_relaxed);
+  stats.droppedOldest = droppedOldestCount.load(std::memory_order_relaxed);
+  stats.droppedOldestBytes = droppedOldestBytes.load(std::memory_order_relaxed);
+  stats.droppedNewest = droppedNewestCount.load(std::memory_order_relaxed);
+  stats.rejected = rejectedCount.load(std::memory_order_relaxed);
+  stats.depth = size();
+  stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+  return stats;
+}
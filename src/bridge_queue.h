@@ -0,0 +1,104 @@
+#ifndef BRIDGE_QUEUE_H
+#define BRIDGE_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "kroner_config.h"
+
+static_assert((BRIDGE_QUEUE_SLOTS & (BRIDGE_QUEUE_SLOTS - 1)) == 0,
+              "BRIDGE_QUEUE_SLOTS debe ser potencia de 2");
+
+// Trama del puente serie
+struct BridgeFrame {
+  uint32_t time;                    // millis() de llegada
+  uint32_t stampUs;                 // micros() de llegada (medida de latencia)
+  uint16_t len;                     // Bytes válidos en data
+  uint8_t data[BRIDGE_FRAME_MAX];
+};
+
+// Qué hacer cuando la cola está llena
+enum BridgeDropPolicy : uint8_t {
+  BRIDGE_DROP_OLDEST = 0,  // Se descarta la trama más antigua y se encola la nueva
+  BRIDGE_DROP_NEWEST = 1   // Se rechaza la trama nueva
+};
+
+// Contadores de la cola (instantánea)
+struct BridgeQueueStats {
+  uint32_t pushed;         // Tramas aceptadas
+  uint32_t popped;         // Tramas entregadas al consumidor
+  uint32_t droppedOldest;  // Tramas antiguas sobrescritas por desbordamiento
+  uint32_t droppedOldestBytes; // Bytes de esas tramas (para devolver créditos)
+  uint32_t droppedNewest;  // Tramas nuevas rechazadas por desbordamiento
+  uint32_t rejected;       // Tramas con longitud inválida
+  uint32_t depth;          // Tramas pendientes
+  uint32_t maxDepth;       // Máximo de tramas pendientes observado
+};
+
+/**
+ * @brief Cola circular SPSC (un productor, un consumidor) de tramas, sin locks
+ *
+ * Pensada para el callback BLE (productor) y la tarea de radio (consumidor).
+ * Con BRIDGE_DROP_OLDEST el productor puede adelantar la cola con un CAS; el
+ * consumidor valida su copia con otro CAS y la descarta si fue sobrescrita.
+ */
+class BridgeQueue {
+public:
+  static const uint32_t CAPACITY = BRIDGE_QUEUE_SLOTS;
+
+  explicit BridgeQueue(BridgeDropPolicy policy = BRIDGE_DROP_OLDEST);
+
+  /**
+   * @brief Encola una trama (solo desde el productor)
+   * @param data Bytes de la trama
+   * @param len Longitud (1..BRIDGE_FRAME_MAX)
+   * @param time Marca de tiempo a guardar con la trama (ms)
+   * @param stampUs Marca de tiempo en µs para medir latencia
+   * @return true si la trama quedó encolada
+   */
+  bool push(const uint8_t* data, size_t len, uint32_t time, uint32_t stampUs = 0);
+
+  /**
+   * @brief Extrae la trama más antigua (solo desde el consumidor)
+   * @param out Destino de la copia
+   * @return true si se extrajo una trama
+   */
+  bool pop(BridgeFrame& out);
+
+  /**
+   * @brief Número de tramas pendientes
+   */
+  uint32_t size() const;
+
+  /**
+   * @brief Huecos libres; desde el productor es un mínimo garantizado
+   * (el consumidor solo puede liberar más)
+   */
+  uint32_t freeSlots() const { return CAPACITY - size(); }
+
+  void setDropPolicy(BridgeDropPolicy policy) { dropPolicy.store(policy, std::memory_order_relaxed); }
+  BridgeDropPolicy getDropPolicy() const { return (BridgeDropPolicy)dropPolicy.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Copia los contadores de la cola
+   */
+  BridgeQueueStats getStats() const;
+
+private:
+  static const uint32_t MASK = CAPACITY - 1;
+
+  BridgeFrame slots[CAPACITY];
+  std::atomic<uint32_t> head;   // Próxima posición a escribir (productor)
+  std::atomic<uint32_t> tail;   // Próxima posición a leer (consumidor, o productor al descartar)
+  std::atomic<uint8_t> dropPolicy;
+
+  std::atomic<uint32_t> pushedCount;
+  std::atomic<uint32_t> poppedCount;
+  std::atomic<uint32_t> droppedOldestCount;
+  std::atomic<uint32_t> droppedOldestBytes;
+  std::atomic<uint32_t> droppedNewestCount;
+  std::atomic<uint32_t> rejectedCount;
+  std::atomic<uint32_t> maxDepth;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "captive_dns.h"
+#include <string.h>
+
+// Cabecera DNS (RFC 1035 4.1.1)
+static const size_t DNS_HEADER_LEN = 12;
+static const uint8_t DNS_FLAG_QR = 0x80;
+static const uint8_t DNS_FLAG_AA = 0x04;
+static const uint8_t DNS_FLAG_RD = 0x01;
+static const uint8_t DNS_FLAG_RA = 0x80;
+static const uint8_t DNS_RCODE_NOTIMP = 4;
+static const uint16_t DNS_TYPE_A = 1;
+static const uint16_t DNS_TYPE_ANY = 255;
+static const uint16_t DNS_CLASS_IN = 1;
+
+static uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+  return p + 2;
+}
+
+// Cabecera de respuesta con los contadores indicados (sin autoridad ni adicionales)
+static uint8_t* putHeader(uint8_t* out, const uint8_t* query, uint8_t rcode, uint16_t qd, uint16_t an) {
+  out[0] = query[0];   // Mismo id
+  out[1] = query[1];
+  out[2] = (uint8_t)(DNS_FLAG_QR | (query[2] & 0x78) | DNS_FLAG_AA | (query[2] & DNS_FLAG_RD));
+  out[3] = (uint8_t)(DNS_FLAG_RA | rcode);
+  uint8_t* p = putU16(out + 4, qd);
+  p = putU16(p, an);
+  p = putU16(p, 0);
+  return putU16(p, 0);
+}
+
+size_t captiveDnsReply(const uint8_t* query, size_t len, const uint8_t ip[4], uint32_t ttl,
+                       uint8_t* out, size_t cap) {
+  if (query == nullptr || len < DNS_HEADER_LEN || cap < DNS_HEADER_LEN) return 0;
+  if (query[2] & DNS_FLAG_QR) return 0;   // Es una respuesta: no contestar
+
+  uint8_t opcode = (query[2] >> 3) & 0x0F;
+  if (opcode != 0) {
+    return (size_t)(putHeader(out, query, DNS_RCODE_NOTIMP, 0, 0) - out);
+  }
+  if (getU16(query + 4) != 1) return 0;   // Una sola pregunta, como DNSServer
+
+  // Nombre de la pregunta: etiquetas sin compresión hasta la raíz
+  size_t pos = DNS_HEADER_LEN;
+  while (pos < len && query[pos] != 0) {
+    if (query[pos] & 0xC0) return 0;
+    pos += 1 + query[pos];
+  }
+  size_t questionEnd = pos + 1 + 4;   // Raíz, tipo y clase
+  if (questionEnd > len) return 0;
+  uint16_t qtype = getU16(query + pos + 1);
+  uint16_t qclass = getU16(query + pos + 3);
+  bool answer = (qtype == DNS_TYPE_A || qtype == DNS_TYPE_ANY) && qclass == DNS_CLASS_IN;
+
+  size_t questionLen = questionEnd - DNS_HEADER_LEN;
+  size_t total = DNS_HEADER_LEN + questionLen + (answer ? 16 : 0);
+  if (total > cap) return 0;
+
+  uint8_t* p = putHeader(out, query, 0, 1, answer ? 1 : 0);
+  memcpy(p, query + DNS_HEADER_LEN, questionLen);
+  p += questionLen;
+  if (answer) {
+    p = putU16(p, 0xC000 | DNS_HEADER_LEN);   // Puntero al nombre de la pregunta
+    p = putU16(p, DNS_TYPE_A);
+    p = putU16(p, DNS_CLASS_IN);
+    p = putU16(p, (uint16_t)(ttl >> 16));
+    p = putU16(p, (uint16_t)ttl);
+    p = putU16(p, 4);
+    memcpy(p, ip, 4);
+    p += 4;
+  }
+  return (size_t)(p - out);
+}
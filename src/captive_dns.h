@@ -0,0 +1,30 @@
+#ifndef CAPTIVE_DNS_H
+#define CAPTIVE_DNS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Tamaño máximo de un mensaje DNS sobre UDP sin EDNS
+#define CAPTIVE_DNS_MAX_PACKET 512
+
+/**
+ * @brief Respuesta del portal cautivo a una consulta DNS
+ *
+ * Como DNSServer con dominio "*": cualquier nombre resuelve a la IP del AP.
+ * Las consultas A y ANY reciben un registro A; el resto (AAAA, ...) una
+ * respuesta sin registros, para que el cliente pase a pedir A. Otras
+ * operaciones reciben NOTIMP. Los registros adicionales de la consulta
+ * (EDNS) no se copian.
+ * @param query Paquete recibido
+ * @param len Longitud
+ * @param ip IP del AP (4 bytes)
+ * @param ttl TTL del registro A (s)
+ * @param out Destino (al menos CAPTIVE_DNS_MAX_PACKET bytes)
+ * @param cap Tamaño del destino
+ * @return Longitud de la respuesta, 0 si no hay que responder (paquete
+ *         mal formado o que no es una consulta)
+ */
+size_t captiveDnsReply(const uint8_t* query, size_t len, const uint8_t ip[4], uint32_t ttl,
+                       uint8_t* out, size_t cap);
+
+#endif
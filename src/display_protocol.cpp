@@ -0,0 +1,23 @@
+#include "display_protocol.h"
+
+bool parseDisplayFrame(const uint8_t* data, size_t len, DisplayFrameInfo& info) {
+  info.valid = false;
+  info.type = DISPLAY_TYPE_UNKNOWN;
+  info.address = 0;
+
+  if (data == nullptr || len < DISPLAY_FRAME_MIN_LEN) {
+    return false;
+  }
+
+  uint8_t t = data[4];
+  if (t < '0' || t > '9') {
+    return false;
+  }
+
+  // XXYY se empaqueta en una palabra para comparar direcciones rápido
+  info.address = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                 ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+  info.type = (uint8_t)(t - '0');
+  info.valid = true;
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef DISPLAY_PROTOCOL_H
+#define DISPLAY_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Tipos de trama del protocolo de display (XXYYT F PPTEXT...)
+enum DisplayFrameType : uint8_t {
+  DISPLAY_TYPE_UNKNOWN = 0,
+  DISPLAY_TYPE_CHRONO = 1,      // Crono con puntos
+  DISPLAY_TYPE_TEXT = 2,        // Texto normal
+  DISPLAY_TYPE_CLEAR = 3,       // Limpiar pantalla
+  DISPLAY_TYPE_TEXT_CLEAR = 4   // Texto con limpieza previa
+};
+
+// Longitud mínima de una trama válida: XXYYT
+#define DISPLAY_FRAME_MIN_LEN 5
+
+// Campos de cabecera de una trama de display
+struct DisplayFrameInfo {
+  bool valid;
+  uint8_t type;          // Dígito T (ver DisplayFrameType)
+  uint32_t address;      // Los 4 caracteres XXYY empaquetados (big-endian)
+};
+
+/**
+ * @brief Decodifica la cabecera de una trama de display
+ * Mismo criterio que decodeMessage() en data/index.html: la trama es válida
+ * si tiene al menos XXYYT y T es un dígito.
+ * @param data Bytes de la trama
+ * @param len Longitud
+ * @param info Resultado
+ * @return true si la trama es válida
+ */
+bool parseDisplayFrame(const uint8_t* data, size_t len, DisplayFrameInfo& info);
+
+#endif
@@ -0,0 +1,144 @@
+#include "event_stream.h"
+#include "sse_input_ring.h"
+#include "message_store.h"
+#include "task_functions.h"
+
+static AsyncEventSource events("/api/stream");
+
+// Conexiones abiertas, para el heartbeat. Las altas y bajas llegan desde
+// async_tcp; el mutex evita que se borre un cliente mientras se le escribe
+static AsyncEventSourceClient* clients[SSE_MAX_CLIENTS];
+static SemaphoreHandle_t clientsMutex = nullptr;
+
+// Eventos de entrada (varios productores: tarea de entradas y tarea BLE)
+static SseInputRing inputEvents;
+
+static uint32_t streamedSeq = 0;
+static uint32_t lastHeartbeat = 0;
+static EventStreamStats stats = {0, 0, 0, 0, 0, 0};
+
+static void onStreamConnect(AsyncEventSourceClient* client) {
+  // Secuencia actual y reintento rápido tras un corte
+  uint32_t seq = getLatestMessageSeq();
+  char hello[32];
+  snprintf(hello, sizeof(hello), "{\"seq\":%u}", (unsigned)seq);
+  client->send(hello, "hello", seq, SSE_RETRY_MS);
+
+  xSemaphoreTake(clientsMutex, portMAX_DELAY);
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (clients[i] == nullptr) {
+      clients[i] = client;
+      break;
+    }
+  }
+  xSemaphoreGive(clientsMutex);
+  // Con la tarea web dormida sin plazo, que arranque el heartbeat
+  notifyWebServerTask();
+
+  DEBUG_PRINTLN("SSE client connected");
+}
+
+static void onStreamDisconnect(AsyncEventSourceClient* client) {
+  xSemaphoreTake(clientsMutex, portMAX_DELAY);
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (clients[i] == client) {
+      clients[i] = nullptr;
+    }
+  }
+  xSemaphoreGive(clientsMutex);
+
+  DEBUG_PRINTLN("SSE client disconnected");
+}
+
+/**
+ * @brief Rechaza conexiones por encima de SSE_MAX_CLIENTS
+ */
+static bool acceptStreamClient(AsyncWebServerRequest* request) {
+  (void)request;
+  return events.count() < SSE_MAX_CLIENTS;
+}
+
+void eventStreamInit(AsyncWebServer& server) {
+  clientsMutex = xSemaphoreCreateMutex();
+  streamedSeq = getLatestMessageSeq();
+  events.onConnect(onStreamConnect);
+  events.onDisconnect(onStreamDisconnect);
+  events.setFilter(acceptStreamClient);
+  server.addHandler(&events);
+  DEBUG_PRINTLN("SSE en /api/stream");
+}
+
+void eventStreamPublishInput(const char* text, uint32_t time) {
+  inputEvents.push(text, strlen(text), time);
+  notifyWebServerTask();
+}
+
+static void sendFrames() {
+  uint32_t latest = getLatestMessageSeq();
+  // El histórico ya no tiene las más antiguas: saltar hasta la primera disponible
+  if (latest - streamedSeq > MESSAGE_HISTORY_SLOTS) {
+    stats.missed += latest - streamedSeq - MESSAGE_HISTORY_SLOTS;
+    streamedSeq = latest - MESSAGE_HISTORY_SLOTS;
+  }
+
+  char item[MESSAGE_HISTORY_JSON_MAX];
+  while (streamedSeq != latest) {
+    streamedSeq++;
+    if (copyHistoryMessageJson(streamedSeq, item, sizeof(item)) == 0) {
+      stats.missed++;
+      continue;
+    }
+    events.send(item, "frame", streamedSeq);
+    stats.frames++;
+  }
+}
+
+static void sendInputs() {
+  SseInputRecord event;
+  char json[SSE_INPUT_TEXT_MAX + 48];
+  while (inputEvents.pop(event)) {
+    snprintf(json, sizeof(json), "{\"input\":\"%.*s\",\"time\":%u}",
+             (int)event.len, event.text, (unsigned)event.time);
+    events.send(json, "input");
+    stats.inputs++;
+  }
+}
+
+static void sendHeartbeat() {
+  static const char HEARTBEAT[] = ": ping\n\n";
+  xSemaphoreTake(clientsMutex, portMAX_DELAY);
+  for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+    // Solo a quien no tenga ya datos pendientes: esos ya mantienen viva la conexión
+    if (clients[i] != nullptr && clients[i]->connected() && clients[i]->packetsWaiting() == 0) {
+      clients[i]->write(HEARTBEAT, sizeof(HEARTBEAT) - 1);
+    }
+  }
+  xSemaphoreGive(clientsMutex);
+}
+
+uint32_t eventStreamService() {
+  if (events.count() == 0) {
+    // Sin clientes: no acumular nada para el siguiente que se conecte
+    streamedSeq = getLatestMessageSeq();
+    inputEvents.clear();
+    return UINT32_MAX;
+  }
+
+  sendFrames();
+  sendInputs();
+
+  uint32_t now = millis();
+  if (now - lastHeartbeat >= SSE_HEARTBEAT_MS) {
+    lastHeartbeat = now;
+    sendHeartbeat();
+  }
+  return SSE_HEARTBEAT_MS - (now - lastHeartbeat);
+}
+
+EventStreamStats eventStreamGetStats() {
+  EventStreamStats copy = stats;
+  copy.clients = events.count();
+  copy.avgQueued = events.avgPacketsWaiting();
+  copy.inputDrops = inputEvents.drops();
+  return copy;
+}
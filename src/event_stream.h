@@ -0,0 +1,49 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "kroner_config.h"
+
+// Estadísticas del stream SSE
+struct EventStreamStats {
+  uint32_t clients;          // Conexiones abiertas
+  uint32_t avgQueued;        // Mensajes pendientes por conexión (media)
+  uint32_t frames;           // Tramas enviadas
+  uint32_t inputs;           // Eventos de entrada enviados
+  uint32_t missed;           // Tramas que salieron del histórico antes de enviarse
+  uint32_t inputDrops;       // Eventos de entrada descartados por cola llena
+};
+
+/**
+ * @brief Server-Sent Events en /api/stream (puerto 80)
+ *
+ * Cada trama nueva del histórico se envía como evento "frame" (id = seq,
+ * data = el mismo JSON que /api/messages?since=) y cada pulsación como
+ * evento "input". AsyncEventSource mantiene una cola por conexión, así que
+ * un cliente lento no frena al resto ni al servidor HTTP. Cada
+ * SSE_HEARTBEAT_MS se envía un comentario para que proxies y navegadores
+ * no cierren la conexión.
+ */
+void eventStreamInit(AsyncWebServer& server);
+
+/**
+ * @brief Encola un evento de entrada (teclado, switches, F1-F3)
+ * Seguro desde cualquier tarea (no desde ISR).
+ * @param text Texto del evento, p.ej. "Inicio:12345"
+ * @param time millis() del evento
+ */
+void eventStreamPublishInput(const char* text, uint32_t time);
+
+/**
+ * @brief Envía tramas y eventos pendientes y el heartbeat (solo desde la tarea web)
+ * @return ms hasta el próximo heartbeat (UINT32_MAX sin conexiones)
+ */
+uint32_t eventStreamService();
+
+/**
+ * @brief Copia las estadísticas del stream
+ */
+EventStreamStats eventStreamGetStats();
+
+#endif
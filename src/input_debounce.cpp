@@ -0,0 +1,13 @@
+#include <Arduino.h>
+#include "input_debounce.h"
+
+bool IRAM_ATTR inputDebounceAccept(InputDebounce& state, uint64_t nowUs, uint64_t windowUs) {
+  if (state.seen && nowUs - state.lastUs <= windowUs) return false;
+  inputDebounceMark(state, nowUs);
+  return true;
+}
+
+void IRAM_ATTR inputDebounceMark(InputDebounce& state, uint64_t nowUs) {
+  state.lastUs = nowUs;
+  state.seen = true;
+}
@@ -0,0 +1,30 @@
+#ifndef INPUT_DEBOUNCE_H
+#define INPUT_DEBOUNCE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Antirrebote de una entrada (canal F, switch o tecla)
+ *
+ * Guarda la hora del último evento aceptado. Un evento se acepta si es el
+ * primero o si llega más de la ventana después del último aceptado; los
+ * rechazados no mueven la referencia. Cada instancia la toca un solo
+ * contexto (la ISR de su canal o la tarea de entradas).
+ */
+struct InputDebounce {
+  uint64_t lastUs;    // Hora del último evento aceptado (µs)
+  bool seen;          // Ya se aceptó alguno
+};
+
+/**
+ * @brief Decide si un evento pasa el antirrebote y, si pasa, lo registra
+ * @param nowUs Hora del evento (µs, esp_timer_get_time())
+ * @param windowUs Tiempo mínimo desde el último aceptado
+ * @return true si el evento es válido
+ */
+bool inputDebounceAccept(InputDebounce& state, uint64_t nowUs, uint64_t windowUs);
+
+// Registra nowUs como último evento aceptado sin comprobar (estado inicial)
+void inputDebounceMark(InputDebounce& state, uint64_t nowUs);
+
+#endif
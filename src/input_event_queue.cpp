@@ -0,0 +1,73 @@
+#include <Arduino.h>
+#include "input_event_queue.h"
+
+InputEventQueue::InputEventQueue()
+    : enqueuePos(0), dequeuePos(0), overflowCount(0), maxDepth(0) {
+  for (uint32_t i = 0; i < CAPACITY; i++) {
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+    cells[i].channel = 0;
+    cells[i].timeUs = 0;
+  }
+}
+
+bool IRAM_ATTR InputEventQueue::push(uint8_t channel, uint64_t timeUs) {
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  Cell* cell;
+  for (;;) {
+    cell = &cells[pos & MASK];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff == 0) {
+      // Hueco libre: reservarlo (si otro productor se adelanta, reintentar)
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // El consumidor aún no ha liberado este hueco: cola llena
+      overflowCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->channel = channel;
+  cell->timeUs = timeUs;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+
+  uint32_t depth = pos + 1 - dequeuePos.load(std::memory_order_relaxed);
+  if (depth > maxDepth.load(std::memory_order_relaxed)) {
+    maxDepth.store(depth, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool InputEventQueue::pop(InputEvent& out) {
+  uint32_t pos = dequeuePos.load(std::memory_order_relaxed);
+  Cell& cell = cells[pos & MASK];
+  // Un productor interrumpido a medio escribir retiene los siguientes: el orden se mantiene
+  if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+    return false;
+  }
+
+  out.channel = cell.channel;
+  out.timeUs = cell.timeUs;
+  out.seq = pos;
+  cell.sequence.store(pos + CAPACITY, std::memory_order_release);
+  dequeuePos.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+uint32_t InputEventQueue::size() const {
+  return enqueuePos.load(std::memory_order_acquire) - dequeuePos.load(std::memory_order_acquire);
+}
+
+InputEventQueueStats InputEventQueue::getStats() const {
+  InputEventQueueStats stats;
+  stats.pushed = enqueuePos.load(std::memory_order_relaxed);
+  stats.popped = dequeuePos.load(std::memory_order_relaxed);
+  stats.overflows = overflowCount.load(std::memory_order_relaxed);
+  stats.depth = size();
+  stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+  return stats;
+}
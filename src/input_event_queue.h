@@ -0,0 +1,75 @@
+#ifndef INPUT_EVENT_QUEUE_H
+#define INPUT_EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "kroner_config.h"
+
+static_assert((INPUT_EVENT_QUEUE_SLOTS & (INPUT_EVENT_QUEUE_SLOTS - 1)) == 0,
+              "INPUT_EVENT_QUEUE_SLOTS debe ser potencia de 2");
+
+// Flanco de una entrada F1-F3
+struct InputEvent {
+  uint8_t channel;        // 0..2 = F1..F3
+  uint32_t seq;           // Posición en la cola (los eventos perdidos no la consumen)
+  uint64_t timeUs;        // esp_timer_get_time() en la interrupción
+};
+
+// Contadores de la cola (instantánea)
+struct InputEventQueueStats {
+  uint32_t pushed;        // Eventos encolados
+  uint32_t popped;        // Eventos entregados
+  uint32_t overflows;     // Eventos perdidos por cola llena
+  uint32_t depth;         // Eventos pendientes
+  uint32_t maxDepth;      // Máximo de eventos pendientes observado
+};
+
+/**
+ * @brief Cola de eventos de entrada sin locks, segura desde interrupciones
+ *
+ * Varios productores (las ISR de F1-F3 y las entradas simuladas) reservan
+ * posición con un CAS y publican el hueco con su número de secuencia; un
+ * único consumidor (la tarea de entradas) los saca en orden. Si la cola se
+ * llena, el evento nuevo se descarta y se cuenta: nunca se sobrescriben
+ * eventos pendientes.
+ */
+class InputEventQueue {
+public:
+  static const uint32_t CAPACITY = INPUT_EVENT_QUEUE_SLOTS;
+
+  InputEventQueue();
+
+  /**
+   * @brief Encola un evento (ISR o tarea)
+   * @return false si la cola estaba llena
+   */
+  bool push(uint8_t channel, uint64_t timeUs);
+
+  /**
+   * @brief Extrae el evento más antiguo (solo desde el consumidor)
+   * @return false si no hay eventos completos pendientes
+   */
+  bool pop(InputEvent& out);
+
+  uint32_t size() const;
+
+  InputEventQueueStats getStats() const;
+
+private:
+  static const uint32_t MASK = CAPACITY - 1;
+
+  struct Cell {
+    std::atomic<uint32_t> sequence;   // == posición: libre; == posición + 1: con evento
+    uint8_t channel;
+    uint64_t timeUs;
+  };
+
+  Cell cells[CAPACITY];
+  std::atomic<uint32_t> enqueuePos;
+  std::atomic<uint32_t> dequeuePos;
+  std::atomic<uint32_t> overflowCount;
+  std::atomic<uint32_t> maxDepth;
+};
+
+#endif
@@ -1,18 +1,34 @@
 #include "kroner_config.h"
 #include "input_functions.h"
+#include "input_debounce.h"
 #include "ble_functions.h"
+#include "event_stream.h"
+#include "task_functions.h"
+#include "esp_timer.h"
 
-// Variables globales de interrupciones
-volatile uint32_t F1, F2, F3;
-volatile bool newInputValue = false;
+// Flancos F1-F3
+InputEventQueue inputEdges;
+volatile uint32_t inputDebounced[3] = {0};
+uint32_t F1, F2, F3;
 const uint32_t debounceTime = 500;      // valor previo estable para keypad
 const uint32_t switchDebounceTime = 100;
-volatile uint32_t lastInterruptTimeF1 = 0;
-volatile uint32_t lastInterruptTimeF2 = 0;
-volatile uint32_t lastInterruptTimeF3 = 0;
+
+// Último flanco aceptado por canal (solo lo toca la ISR de ese canal)
+static InputDebounce edgeDebounce[3] = {};
+
+// Despertar por teclado: la ISR de columna solo actúa con el teclado armado
+static volatile bool keypadArmed = false;
+static volatile bool keypadWakePending = false;
+static volatile uint64_t keypadWakeUs = 0;   // esp_timer_get_time() de la interrupción que despertó el barrido
+
+// Eventos del pulsador en binario: productores la tarea de entradas y la tarea
+// BLE (estado inicial de switches); solo la tarea de entradas notifica
+PulsadorEventBatch pulsadorEvents;
+static volatile bool pulsadorBinary = false;
+static volatile uint16_t pulsadorPayload = BLE_DEFAULT_MTU - 3;
 
 // Variables de switches
-uint32_t lastInputTime[3] = {0};
+static InputDebounce switchDebounce[3] = {};
 bool inputState[3] = {false};
 bool lastInputState[3] = {false};
 
@@ -20,49 +36,137 @@ bool lastInputState[3] = {false};
 const byte rowsCount = 3;
 const byte columsCount = 3;
 
-String keyNames[rowsCount][columsCount] = {
-  {"Inicio", "Carrera", "Pausa"},
-  {"Fin", "6 Segundos", "4 Puntos"},
-  {"Reset", "Eliminado", "Perilla"}
+constexpr KeypadKey KEYPAD_KEYS[KEYPAD_KEY_COUNT] = {
+  {'I', "Inicio"}, {'C', "Carrera"},    {'P', "Pausa"},
+  {'F', "Fin"},    {'6', "6 Segundos"}, {'4', "4 Puntos"},
+  {'R', "Reset"},  {'E', "Eliminado"},  {'X', "Perilla"}
+};
+
+// Mapa para la librería (no admite const): código de tecla = índice + 1 (0 es NO_KEY)
+static char keypadCodes[rowsCount][columsCount] = {
+  {1, 2, 3},
+  {4, 5, 6},
+  {7, 8, 9}
 };
 
-char keys[rowsCount][columsCount] = {
-  { 'I','C','P'},
-  { 'F','6','4'},
-  { 'R','E','X'}
+// Eventos de los switches 7/8/9: [switch][estado]
+static constexpr const char* SWITCH_EVENTS[3][2] = {
+  {"Input1 OFF", "Input1 ON"},
+  {"Input2 OFF", "Input2 ON"},
+  {"Input3 OFF", "Input3 ON"}
 };
 
 byte rowPins[rowsCount] = {INPUT4PIN, INPUT5PIN, INPUT6PIN};
 byte colPins[columsCount] = {INPUT1PIN, INPUT2PIN, INPUT3PIN};
-Keypad keypad = Keypad(makeKeymap(keys), rowPins, colPins, rowsCount, columsCount);
+Keypad keypad = Keypad(makeKeymap(keypadCodes), rowPins, colPins, rowsCount, columsCount);
 
-uint32_t lastPressedTime[3][3] = {0};
+static InputDebounce keyDebounce[KEYPAD_KEY_COUNT] = {};
 
-// Funciones de interrupciones
-void handleInterruptF1() {
-  uint32_t currentMillis = millis();
-  if (currentMillis - lastInterruptTimeF1 > debounceTime) {
-    F1 = currentMillis;
-    lastInterruptTimeF1 = currentMillis;
-    newInputValue = true;
+// Funciones de interrupciones: solo marca de tiempo en µs y encolar
+static void IRAM_ATTR pushInputEdge(uint8_t channel) {
+  uint64_t now = esp_timer_get_time();
+  if (!inputDebounceAccept(edgeDebounce[channel], now, INPUT_F_DEBOUNCE_US)) {
+    inputDebounced[channel]++;
+    return;
   }
+  inputEdges.push(channel, now);
+  notifyInputTaskFromISR();
 }
 
-void handleInterruptF2() {
-  uint32_t currentMillis = millis();
-  if (currentMillis - lastInterruptTimeF2 > debounceTime) {
-    F2 = currentMillis;
-    lastInterruptTimeF2 = currentMillis;
-    newInputValue = true;
-  }
+void IRAM_ATTR handleInterruptF1() {
+  pushInputEdge(0);
+}
+
+void IRAM_ATTR handleInterruptF2() {
+  pushInputEdge(1);
 }
 
-void handleInterruptF3() {
-  uint32_t currentMillis = millis();
-  if (currentMillis - lastInterruptTimeF3 > debounceTime) {
-    F3 = currentMillis;
-    lastInterruptTimeF3 = currentMillis;
-    newInputValue = true;
+void IRAM_ATTR handleInterruptF3() {
+  pushInputEdge(2);
+}
+
+// Columna del teclado a nivel bajo con las filas a nivel bajo: hay una tecla pulsada
+static void IRAM_ATTR handleKeypadWake() {
+  if (!keypadArmed) return;
+  keypadArmed = false;
+  keypadWakeUs = esp_timer_get_time();
+  keypadWakePending = true;
+  notifyInputTaskFromISR();
+}
+
+// Cambio en un switch 7/8/9: el antirrebote lo hace scanSwitch() en la tarea
+static void IRAM_ATTR handleSwitchWake() {
+  notifyInputTaskFromISR();
+}
+
+/**
+ * @brief Simula una interrupción F1-F3 (generador de carga), sin antirrebote
+ * @param input 0..2 = F1..F3
+ */
+void simulateInputEvent(uint8_t input) {
+  inputEdges.push(input % 3, esp_timer_get_time());
+  notifyInputTask();
+}
+
+void noteInputEdge(const InputEvent& event) {
+  uint32_t ms = (uint32_t)(event.timeUs / 1000);
+  if (event.channel == 0) F1 = ms;
+  else if (event.channel == 1) F2 = ms;
+  else F3 = ms;
+}
+
+size_t packInputEvent(const InputEvent& event, uint8_t* out) {
+  uint32_t legacy[4] = {F1, F2, F3, 0};
+  uint32_t overflows = inputEdges.getStats().overflows;
+  memcpy(out, legacy, sizeof(legacy));
+  out[16] = event.channel + 1;
+  out[17] = INPUT_EVENT_BLE_VERSION;
+  out[18] = 0;
+  out[19] = 0;
+  memcpy(out + 20, &event.timeUs, sizeof(event.timeUs));
+  memcpy(out + 28, &overflows, sizeof(overflows));
+  return INPUT_EVENT_BLE_LEN;
+}
+
+/**
+ * @brief Cambia el formato de pulsadorCharacteristic
+ * @param binary true: registros binarios por lotes; false: texto y flancos de 32 bytes
+ * @param mtu MTU con la que empaquetar los lotes
+ */
+void setPulsadorFormat(bool binary, uint16_t mtu) {
+  pulsadorBinary = false;
+  pulsadorEvents.clear();
+  setPulsadorMtu(mtu);
+  pulsadorBinary = binary;
+}
+
+/**
+ * @brief Ajusta el tamaño de los lotes a la MTU (al negociarse), sin cambiar de formato
+ */
+void setPulsadorMtu(uint16_t mtu) {
+  if (mtu < BLE_DEFAULT_MTU) mtu = BLE_DEFAULT_MTU;
+  size_t payload = mtu - 3;
+  if (payload > PULSADOR_NOTIFY_MAX) payload = PULSADOR_NOTIFY_MAX;
+  pulsadorPayload = (uint16_t)payload;
+}
+
+bool pulsadorBinaryEnabled() {
+  return pulsadorBinary;
+}
+
+size_t pulsadorPayloadMax() {
+  return pulsadorPayload;
+}
+
+/**
+ * @brief Notifica los eventos binarios pendientes, tantos por notificación como
+ * quepan en la MTU (solo desde la tarea de entradas)
+ */
+void flushPulsadorEvents() {
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  size_t len;
+  while ((len = pulsadorEvents.packNext(packet, pulsadorPayload)) > 0) {
+    notifyPulsador(packet, len);
   }
 }
 
@@ -86,36 +190,114 @@ void initInputs() {
   keypad.setDebounceTime(10);  // ms (valor previo)
   keypad.setHoldTime(200);     // ms
 
-  // Configurar entradas discretas 7/8/9
+  // Configurar entradas discretas 7/8/9 (la interrupción solo despierta a la tarea)
   pinMode(INPUT7PIN, INPUT_PULLDOWN);
   pinMode(INPUT8PIN, INPUT_PULLDOWN);
   pinMode(INPUT9PIN, INPUT_PULLDOWN);
+  attachInterrupt(digitalPinToInterrupt(INPUT7PIN), handleSwitchWake, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(INPUT8PIN), handleSwitchWake, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(INPUT9PIN), handleSwitchWake, CHANGE);
 }
 
-void sendKeypadEvent(const String& name, uint32_t timestamp) {
+/**
+ * @brief Deja el teclado esperando una pulsación por interrupción
+ * Filas a nivel bajo y columnas con pull-up: cualquier tecla baja su columna.
+ * La librería Keypad vuelve a configurar filas y columnas en cada barrido.
+ * @param checkSwitches Comprobar también los switches (solo se escanean con BLE)
+ * @return false si hay algo pendiente (tecla pulsada o switch sin notificar) y
+ *         conviene seguir barriendo
+ */
+bool armInputWake(bool checkSwitches) {
+  for (int i = 0; i < LIST_MAX; i++) {
+    if (keypad.key[i].kstate != IDLE) return false;
+  }
+  if (checkSwitches) {
+    if (digitalRead(INPUT7PIN) != inputState[0] ||
+        digitalRead(INPUT8PIN) != inputState[1] ||
+        digitalRead(INPUT9PIN) != inputState[2]) {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < rowsCount; i++) {
+    pinMode(rowPins[i], OUTPUT);
+    digitalWrite(rowPins[i], LOW);
+  }
+  for (int i = 0; i < columsCount; i++) {
+    pinMode(colPins[i], INPUT_PULLUP);
+  }
+  keypadWakePending = false;
+  keypadArmed = true;
+  for (int i = 0; i < columsCount; i++) {
+    attachInterrupt(digitalPinToInterrupt(colPins[i]), handleKeypadWake, FALLING);
+  }
+
+  // Una tecla que ya estaba pulsada no produce flanco: no dormir
+  for (int i = 0; i < columsCount; i++) {
+    if (digitalRead(colPins[i]) == LOW) {
+      disarmInputWake();
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Quita las interrupciones de columna antes de volver a barrer el teclado
+ */
+void disarmInputWake() {
+  keypadArmed = false;
+  for (int i = 0; i < columsCount; i++) {
+    detachInterrupt(digitalPinToInterrupt(colPins[i]));
+  }
+  for (int i = 0; i < rowsCount; i++) {
+    pinMode(rowPins[i], INPUT_PULLUP);
+  }
+}
+
+/**
+ * @brief Notifica un evento de teclado o switch por BLE y /api/stream
+ * En texto ("nombre:ms") se escribe ya; en binario se añade al lote y sale en
+ * la siguiente notificación de la tarea de entradas.
+ * Se formatea en la pila: el camino de entradas no reserva memoria dinámica
+ */
+void sendKeypadEvent(const char* name, uint8_t eventId, uint8_t value, uint64_t timeUs) {
+  uint32_t timestamp = (uint32_t)(timeUs / 1000);
   char payload[50];
-  snprintf(payload, sizeof(payload), "%s:%lu", name.c_str(), timestamp);
+  snprintf(payload, sizeof(payload), "%s:%lu", name, (unsigned long)timestamp);
 
   DEBUG_PRINTLN(payload);
-  pulsadorCharacteristic.writeValue((uint8_t*)payload, strlen(payload));
+  if (pulsadorBinary) {
+    pulsadorEvents.append(eventId, value, timeUs);
+  } else {
+    notifyPulsador((const uint8_t*)payload, strlen(payload));
+  }
+  eventStreamPublishInput(payload, timestamp);
 }
 
 void scanSwitch(int inputNumber, int inputPin) {
   bool aux = digitalRead(inputPin);
-  uint32_t now = millis();
-  if (aux != inputState[inputNumber] && (now - lastInputTime[inputNumber] > switchDebounceTime)) {
-    lastInputTime[inputNumber] = now;
+  uint64_t nowUs = esp_timer_get_time();
+  if (aux != inputState[inputNumber] &&
+      inputDebounceAccept(switchDebounce[inputNumber], nowUs, (uint64_t)switchDebounceTime * 1000)) {
     inputState[inputNumber] = aux;
-    sendKeypadEvent(aux ? "Input" + String(inputNumber + 1) + " ON" : "Input" + String(inputNumber + 1) + " OFF", now);
+    sendKeypadEvent(SWITCH_EVENTS[inputNumber][aux ? 1 : 0], PULSADOR_EVENT_SWITCH + inputNumber, aux, nowUs);
   }
 }
 
+/**
+ * @brief Envía el estado actual de un switch (al conectar o al pasar a binario)
+ * Se llama desde la tarea BLE: en binario despierta a la de entradas para notificar
+ */
 void sendInitialSwitchState(int inputNumber, int inputPin) {
   bool aux = digitalRead(inputPin);
-  uint32_t now = millis();
+  uint64_t nowUs = esp_timer_get_time();
   inputState[inputNumber] = aux;
-  lastInputTime[inputNumber] = now;
-  sendKeypadEvent(aux ? "Input" + String(inputNumber + 1) + " ON" : "Input" + String(inputNumber + 1) + " OFF", now);
+  inputDebounceMark(switchDebounce[inputNumber], nowUs);
+  sendKeypadEvent(SWITCH_EVENTS[inputNumber][aux ? 1 : 0], PULSADOR_EVENT_SWITCH + inputNumber, aux, nowUs);
+  if (pulsadorBinary) {
+    notifyInputTask();
+  }
   DEBUG_PRINT("Estado inicial Switch ");
   DEBUG_PRINT(inputNumber + 1);
   DEBUG_PRINT(": ");
@@ -123,39 +305,45 @@ void sendInitialSwitchState(int inputNumber, int inputPin) {
 }
 
 void scanKeypad() {
-  char key = keypad.getKey();
+  // getKeys() devuelve todas las teclas que cambian en el barrido (getKey() solo
+  // la primera), así dos teclas casi simultáneas no se pierden
+  if (!keypad.getKeys()) return;
+
+  for (int k = 0; k < LIST_MAX; k++) {
+    const Key& pressed = keypad.key[k];
+    if (!pressed.stateChanged || pressed.kstate != PRESSED) continue;
+    uint8_t index = (uint8_t)pressed.kchar - 1;
+    if (index >= KEYPAD_KEY_COUNT) continue;
+    const KeypadKey& key = KEYPAD_KEYS[index];
+
+    // La primera tecla del barrido lleva la hora de la interrupción que lo despertó
+    uint64_t nowUs = esp_timer_get_time();
+    if (keypadWakePending) {
+      keypadWakePending = false;
+      nowUs = keypadWakeUs;
+    }
+    uint32_t now = (uint32_t)(nowUs / 1000);
 
-  if (key) {
     DEBUG_PRINT("🔘 Keypad detected: ");
-    DEBUG_PRINT(key);
+    DEBUG_PRINT(key.symbol);
     DEBUG_PRINT(" | Millis: ");
-    DEBUG_PRINTLN(millis());
-    
-    uint32_t now = millis();
-
-    for (int i = 0; i < rowsCount; i++) {
-      for (int j = 0; j < columsCount; j++) {
-        if (keys[i][j] == key) {
-          uint32_t timeSinceLastPress = now - lastPressedTime[i][j];
-          
-          // Debug: mostrar tiempo desde última pulsación
-          DEBUG_PRINT("  Time since last press: ");
-          DEBUG_PRINT(timeSinceLastPress);
-          DEBUG_PRINT(" ms (debounce: ");
-          DEBUG_PRINT(debounceTime);
-          DEBUG_PRINTLN(" ms)");
-          
-          if (timeSinceLastPress > debounceTime) {
-            lastPressedTime[i][j] = now;
-            DEBUG_PRINT("  ✓ VALID - Sending: ");
-            DEBUG_PRINTLN(keyNames[i][j]);
-            sendKeypadEvent(keyNames[i][j], now);
-            return;
-          } else {
-            DEBUG_PRINTLN("  ✗ Ignored (debouncing)");
-          }
-        }
-      }
+    DEBUG_PRINTLN(now);
+
+    uint32_t timeSinceLastPress = (uint32_t)((nowUs - keyDebounce[index].lastUs) / 1000);
+
+    // Debug: mostrar tiempo desde última pulsación
+    DEBUG_PRINT("  Time since last press: ");
+    DEBUG_PRINT(timeSinceLastPress);
+    DEBUG_PRINT(" ms (debounce: ");
+    DEBUG_PRINT(debounceTime);
+    DEBUG_PRINTLN(" ms)");
+
+    if (inputDebounceAccept(keyDebounce[index], nowUs, (uint64_t)debounceTime * 1000)) {
+      DEBUG_PRINT("  ✓ VALID - Sending: ");
+      DEBUG_PRINTLN(key.name);
+      sendKeypadEvent(key.name, PULSADOR_EVENT_KEY + index, 0, nowUs);
+    } else {
+      DEBUG_PRINTLN("  ✗ Ignored (debouncing)");
     }
   }
 }
@@ -4,30 +4,54 @@
 #include <Arduino.h>
 #include <Keypad.h>
 #include "kroner_config.h"
+#include "input_event_queue.h"
+#include "pulsador_events.h"
 
-// Variables globales de interrupciones
-extern volatile uint32_t F1, F2, F3;
-extern volatile bool newInputValue;
-extern volatile uint32_t lastInterruptTimeF1;
-extern volatile uint32_t lastInterruptTimeF2;
-extern volatile uint32_t lastInterruptTimeF3;
+// Flancos F1-F3: las ISR encolan, la tarea de entradas los envía uno a uno
+extern InputEventQueue inputEdges;
+extern volatile uint32_t inputDebounced[3];   // Flancos descartados por antirrebote, por canal
+
+// millis() del último flanco enviado de cada canal (formato anterior del pulsador)
+extern uint32_t F1, F2, F3;
+
+// Notificación del pulsador por flanco, little-endian:
+//   [0..11]  F1, F2, F3 (uint32, ms) como hasta ahora   [12..15] 0
+//   [16] canal (1..3)  [17] versión  [18..19] reservado
+//   [20..27] esp_timer_get_time() del flanco (uint64, µs)
+//   [28..31] flancos perdidos por cola llena (acumulado)
+#define INPUT_EVENT_BLE_VERSION 1
+#define INPUT_EVENT_BLE_LEN 32
+
+// Formato binario por lotes del pulsador (ver pulsador_events.h). El cliente lo
+// pide con "EVENTS BIN [mtu]"; al desconectarse se vuelve al formato anterior
+extern PulsadorEventBatch pulsadorEvents;
+void setPulsadorFormat(bool binary, uint16_t mtu);
+void setPulsadorMtu(uint16_t mtu);
+bool pulsadorBinaryEnabled();
+size_t pulsadorPayloadMax();
+void flushPulsadorEvents();
 
 // Variables de switches
-extern uint32_t lastInputTime[3];
 extern bool inputState[3];
 extern bool lastInputState[3];
 
 // Variables de keypad
 extern const byte rowsCount;
 extern const byte columsCount;
-extern String keyNames[3][3];
-extern char keys[3][3];
 extern byte rowPins[3];
 extern byte colPins[3];
 extern Keypad keypad;
-extern uint32_t lastPressedTime[3][3];
 
-// Constantes
+// Teclas del keypad: la librería devuelve el código 1..KEYPAD_KEY_COUNT y
+// KEYPAD_KEYS[código - 1] da su evento sin recorrer la matriz
+#define KEYPAD_KEY_COUNT 9
+struct KeypadKey {
+  char symbol;             // Letra impresa en la tecla
+  const char* name;        // Evento que se envía
+};
+extern const KeypadKey KEYPAD_KEYS[KEYPAD_KEY_COUNT];
+
+// Antirrebote en ms (ver input_debounce.h)
 extern const uint32_t debounceTime;
 extern const uint32_t switchDebounceTime;
 
@@ -35,12 +59,25 @@ extern const uint32_t switchDebounceTime;
 void handleInterruptF1();
 void handleInterruptF2();
 void handleInterruptF3();
+void simulateInputEvent(uint8_t input);
+
+// Actualiza F1/F2/F3 con un flanco sacado de inputEdges
+void noteInputEdge(const InputEvent& event);
+
+/**
+ * @brief Empaqueta un flanco para pulsadorCharacteristic (INPUT_EVENT_BLE_LEN bytes)
+ * Llamar después de noteInputEdge() con el mismo flanco.
+ * @return Bytes escritos
+ */
+size_t packInputEvent(const InputEvent& event, uint8_t* out);
 
 // Funciones de entrada
 void initInputs();
 void scanSwitch(int inputNumber, int inputPin);
 void sendInitialSwitchState(int inputNumber, int inputPin);
 void scanKeypad();
-void sendKeypadEvent(const String& name, uint32_t timestamp);
+bool armInputWake(bool checkSwitches);
+void disarmInputWake();
+void sendKeypadEvent(const char* name, uint8_t eventId, uint8_t value, uint64_t timeUs);
 
 #endif
@@ -0,0 +1,63 @@
+#include "latency_histogram.h"
+
+const uint32_t LatencyHistogram::BUCKET_LIMITS_US[BUCKET_COUNT] = {
+  100, 250, 500, 1000, 2000, 3000, 5000, 7500, 10000, 15000,
+  20000, 30000, 50000, 75000, 100000, 150000, 250000, 500000, 1000000, UINT32_MAX
+};
+
+LatencyHistogram::LatencyHistogram() {
+  reset();
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  int index = 0;
+  while (index < BUCKET_COUNT - 1 && us > BUCKET_LIMITS_US[index]) {
+    index++;
+  }
+  buckets[index].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+
+  // Suma de 64 bits con acarreo manual (sin atómicos de 64 bits)
+  uint32_t old = sumLow.fetch_add(us, std::memory_order_relaxed);
+  if ((uint32_t)(old + us) < old) {
+    sumHigh.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t prev = maxUs.load(std::memory_order_relaxed);
+  while (us > prev && !maxUs.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+  }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+  uint32_t total = getCount();
+  if (total == 0) return 0;
+
+  // Posición (1..total) de la muestra buscada
+  uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+  if (rank == 0) rank = 1;
+
+  uint64_t seen = 0;
+  for (int i = 0; i < BUCKET_COUNT; i++) {
+    seen += getBucket(i);
+    if (seen >= rank) {
+      // La última cubeta no tiene cota: devolver el máximo observado
+      return (i == BUCKET_COUNT - 1) ? getMax() : BUCKET_LIMITS_US[i];
+    }
+  }
+  return getMax();
+}
+
+uint64_t LatencyHistogram::getSum() const {
+  return ((uint64_t)sumHigh.load(std::memory_order_relaxed) << 32) |
+         sumLow.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+  for (int i = 0; i < BUCKET_COUNT; i++) {
+    buckets[i].store(0, std::memory_order_relaxed);
+  }
+  count.store(0, std::memory_order_relaxed);
+  sumLow.store(0, std::memory_order_relaxed);
+  sumHigh.store(0, std::memory_order_relaxed);
+  maxUs.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,54 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Histograma de latencias con cubetas fijas (microsegundos)
+ *
+ * record() solo hace incrementos atómicos, sin locks, por lo que puede
+ * llamarse desde cualquier tarea. Los percentiles se resuelven a la cota
+ * superior de la cubeta correspondiente.
+ */
+class LatencyHistogram {
+public:
+  static const int BUCKET_COUNT = 20;
+
+  // Cota superior (inclusive) de cada cubeta en µs; la última recoge el resto
+  static const uint32_t BUCKET_LIMITS_US[BUCKET_COUNT];
+
+  LatencyHistogram();
+
+  /**
+   * @brief Registra una muestra
+   * @param us Latencia en microsegundos
+   */
+  void record(uint32_t us);
+
+  /**
+   * @brief Percentil aproximado
+   * @param percent Percentil (0-100)
+   * @return Cota superior de la cubeta en µs, 0 si no hay muestras
+   */
+  uint32_t percentile(uint8_t percent) const;
+
+  uint32_t getCount() const { return count.load(std::memory_order_relaxed); }
+  uint32_t getMax() const { return maxUs.load(std::memory_order_relaxed); }
+  uint64_t getSum() const;
+  uint32_t getBucket(int index) const { return buckets[index].load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Pone a cero todas las cubetas
+   */
+  void reset();
+
+private:
+  std::atomic<uint32_t> buckets[BUCKET_COUNT];
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> sumLow;   // Suma en µs, dividida en dos palabras de 32 bits
+  std::atomic<uint32_t> sumHigh;
+  std::atomic<uint32_t> maxUs;
+};
+
+#endif
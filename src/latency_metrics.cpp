@@ -0,0 +1,59 @@
+#include "latency_metrics.h"
+
+LatencyHistogram bridgeLatency;
+LatencyHistogram inputLatency;
+LatencyHistogram broadcastLatency;
+
+static void appendHistogram(String& out, const char* name, const char* help, const LatencyHistogram& h) {
+  char line[128];
+  snprintf(line, sizeof(line), "# HELP %s_seconds %s\n# TYPE %s_seconds histogram\n", name, help, name);
+  out += line;
+
+  uint64_t cumulative = 0;
+  for (int i = 0; i < LatencyHistogram::BUCKET_COUNT - 1; i++) {
+    cumulative += h.getBucket(i);
+    snprintf(line, sizeof(line), "%s_seconds_bucket{le=\"%g\"} %llu\n", name,
+             LatencyHistogram::BUCKET_LIMITS_US[i] / 1e6, (unsigned long long)cumulative);
+    out += line;
+  }
+  cumulative += h.getBucket(LatencyHistogram::BUCKET_COUNT - 1);
+  snprintf(line, sizeof(line), "%s_seconds_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+  out += line;
+
+  // _count a partir de las cubetas, para que cuadre con +Inf
+  snprintf(line, sizeof(line), "%s_seconds_sum %.6f\n%s_seconds_count %llu\n", name,
+           h.getSum() / 1e6, name, (unsigned long long)cumulative);
+  out += line;
+
+  snprintf(line, sizeof(line), "# TYPE %s_max_seconds gauge\n%s_max_seconds %.6f\n", name, name, h.getMax() / 1e6);
+  out += line;
+}
+
+void appendPrometheusMetrics(String& out) {
+  appendHistogram(out, "kroner_bridge_latency", "BLE write or /api/send to UART TX done", bridgeLatency);
+  appendHistogram(out, "kroner_input_latency", "F1-F3 interrupt to BLE pulsador characteristic write", inputLatency);
+  appendHistogram(out, "kroner_broadcast_latency", "Bridge frame arrival to WebSocket send", broadcastLatency);
+}
+
+static uint8_t* putSummary(uint8_t* p, const LatencyHistogram& h) {
+  uint32_t values[4] = {h.getCount(), h.percentile(50), h.percentile(99), h.getMax()};
+  for (int i = 0; i < 4; i++) {
+    p[0] = (uint8_t)values[i];
+    p[1] = (uint8_t)(values[i] >> 8);
+    p[2] = (uint8_t)(values[i] >> 16);
+    p[3] = (uint8_t)(values[i] >> 24);
+    p += 4;
+  }
+  return p;
+}
+
+size_t packLatencySummary(uint8_t* out, size_t cap) {
+  if (cap < LATENCY_SUMMARY_LEN) return 0;
+  uint8_t* p = out;
+  *p++ = LATENCY_SUMMARY_VERSION;
+  *p++ = LATENCY_SUMMARY_COUNT;
+  p = putSummary(p, bridgeLatency);
+  p = putSummary(p, inputLatency);
+  p = putSummary(p, broadcastLatency);
+  return (size_t)(p - out);
+}
@@ -0,0 +1,33 @@
+#ifndef LATENCY_METRICS_H
+#define LATENCY_METRICS_H
+
+#include <Arduino.h>
+#include "latency_histogram.h"
+
+// Histogramas de latencia extremo a extremo (µs)
+extern LatencyHistogram bridgeLatency;     // Escritura BLE / petición HTTP -> último byte en la UART
+extern LatencyHistogram inputLatency;      // ISR F1-F3 -> notifyPulsador()
+extern LatencyHistogram broadcastLatency;  // Trama del puente (TX o RX) -> envío WebSocket
+
+// Resumen binario para BLE, little-endian:
+//   [0] versión  [1] nº de histogramas
+//   por histograma (bridge, input, broadcast): count, p50, p99, max (uint32, µs)
+#define LATENCY_SUMMARY_VERSION 1
+#define LATENCY_SUMMARY_COUNT 3
+#define LATENCY_SUMMARY_LEN (2 + LATENCY_SUMMARY_COUNT * 16)
+
+/**
+ * @brief Añade los histogramas en formato de texto de Prometheus
+ * Cubetas acumuladas en segundos (le="..."), _sum, _count y máximo.
+ */
+void appendPrometheusMetrics(String& out);
+
+/**
+ * @brief Empaqueta el resumen de latencias para la característica BLE
+ * @param out Destino (al menos LATENCY_SUMMARY_LEN bytes)
+ * @param cap Tamaño del destino
+ * @return Bytes escritos, 0 si no cabe
+ */
+size_t packLatencySummary(uint8_t* out, size_t cap);
+
+#endif
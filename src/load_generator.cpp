@@ -0,0 +1,280 @@
+#include "load_generator.h"
+#include "display_protocol.h"
+#include "latency_metrics.h"
+
+// Destinos
+static BridgeQueue* targetQueue = nullptr;
+static portMUX_TYPE* targetLock = nullptr;
+static void (*notifyConsumer)() = nullptr;
+static LoadInputSink inputSink = nullptr;
+
+// Estado de la prueba (protegido por loadMux: se arranca desde HTTP o BLE
+// y se sirve desde el hilo productor)
+static portMUX_TYPE loadMux = portMUX_INITIALIZER_UNLOCKED;
+static LoadGeneratorConfig active;
+static bool running = false;
+static uint32_t runId = 0;          // Distingue lotes de una prueba ya reiniciada
+static uint32_t startUs = 0;
+static uint32_t stopUs = 0;
+static uint32_t generated = 0;
+static uint32_t inputs = 0;
+static uint32_t rejected = 0;
+static uint32_t queueDropsAtStart = 0;
+
+static uint32_t queueDrops() {
+  if (targetQueue == nullptr) return 0;
+  BridgeQueueStats q = targetQueue->getStats();
+  return q.droppedOldest + q.droppedNewest;
+}
+
+/**
+ * @brief Compone la trama número index
+ * Dirección XXYY = display (01..) y fila 01; el crono avanza una décima por trama.
+ */
+static size_t buildFrame(const LoadGeneratorConfig& config, uint32_t index, uint8_t* out) {
+  unsigned display = index % config.displays + 1;
+  int n;
+  if (config.kind == LOAD_FRAME_CHRONO) {
+    n = snprintf((char*)out, BRIDGE_FRAME_MAX + 1, "%02u01%u 0 00 %02u:%02u.%u", display,
+                 (unsigned)DISPLAY_TYPE_CHRONO, (unsigned)(index / 600 % 60), (unsigned)(index / 10 % 60),
+                 (unsigned)(index % 10));
+  } else {
+    n = snprintf((char*)out, BRIDGE_FRAME_MAX + 1, "%02u01%u 0 00 LOAD %lu ", display,
+                 (unsigned)DISPLAY_TYPE_TEXT, (unsigned long)index);
+  }
+
+  size_t len = n > 0 ? (size_t)n : 0;
+  if (len > config.frameLen) {
+    len = config.frameLen;
+  }
+  // Relleno hasta el tamaño pedido: espacios en crono, letras en texto
+  while (len < config.frameLen) {
+    out[len] = config.kind == LOAD_FRAME_CHRONO ? ' ' : (uint8_t)('A' + len % 26);
+    len++;
+  }
+  return len;
+}
+
+// =============================
+// Configuración
+// =============================
+void loadGeneratorInit(BridgeQueue& queue, void (*notify)(), LoadInputSink sink, portMUX_TYPE* producerLock) {
+  targetQueue = &queue;
+  targetLock = producerLock;
+  notifyConsumer = notify;
+  inputSink = sink;
+  active = loadGeneratorDefaults();
+}
+
+LoadGeneratorConfig loadGeneratorDefaults() {
+  LoadGeneratorConfig config;
+  config.rateHz = LOAD_GEN_DEFAULT_RATE_HZ;
+  config.frameLen = LOAD_GEN_DEFAULT_FRAME_LEN;
+  config.kind = LOAD_FRAME_CHRONO;
+  config.displays = LOAD_GEN_DEFAULT_DISPLAYS;
+  config.durationMs = LOAD_GEN_DEFAULT_SECONDS * 1000UL;
+  config.inputRateHz = 0;
+  return config;
+}
+
+static bool parseNumber(const char* value, uint32_t minValue, uint32_t maxValue, uint32_t& out) {
+  if (value == nullptr || *value == '\0') return false;
+  char* end = nullptr;
+  unsigned long n = strtoul(value, &end, 10);
+  if (*end != '\0' || n < minValue || n > maxValue) return false;
+  out = (uint32_t)n;
+  return true;
+}
+
+bool loadGeneratorApplyArg(LoadGeneratorConfig& config, const char* key, const char* value) {
+  uint32_t n;
+  if (strcmp(key, "rate") == 0) {
+    if (!parseNumber(value, 1, LOAD_GEN_MAX_RATE_HZ, n)) return false;
+    config.rateHz = n;
+  } else if (strcmp(key, "size") == 0) {
+    if (!parseNumber(value, DISPLAY_FRAME_MIN_LEN, BRIDGE_FRAME_MAX, n)) return false;
+    config.frameLen = (uint16_t)n;
+  } else if (strcmp(key, "kind") == 0) {
+    if (strcmp(value, "chrono") == 0) {
+      config.kind = LOAD_FRAME_CHRONO;
+    } else if (strcmp(value, "text") == 0) {
+      config.kind = LOAD_FRAME_TEXT;
+    } else {
+      return false;
+    }
+  } else if (strcmp(key, "displays") == 0) {
+    if (!parseNumber(value, 1, 99, n)) return false;
+    config.displays = (uint8_t)n;
+  } else if (strcmp(key, "seconds") == 0) {
+    if (!parseNumber(value, 1, LOAD_GEN_MAX_SECONDS, n)) return false;
+    config.durationMs = n * 1000;
+  } else if (strcmp(key, "inputs") == 0) {
+    if (!parseNumber(value, 0, LOAD_GEN_MAX_INPUT_HZ, n)) return false;
+    config.inputRateHz = n;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool loadGeneratorParseArgs(LoadGeneratorConfig& config, const char* args) {
+  char token[32];
+  const char* p = args;
+  while (*p != '\0') {
+    while (*p == ' ' || *p == ',' || *p == '&') p++;
+    if (*p == '\0') break;
+
+    size_t len = 0;
+    while (p[len] != '\0' && p[len] != ' ' && p[len] != ',' && p[len] != '&') len++;
+    if (len >= sizeof(token)) return false;
+    memcpy(token, p, len);
+    token[len] = '\0';
+    p += len;
+
+    char* eq = strchr(token, '=');
+    if (eq == nullptr) return false;
+    *eq = '\0';
+    if (!loadGeneratorApplyArg(config, token, eq + 1)) return false;
+  }
+  return true;
+}
+
+// =============================
+// Control
+// =============================
+void loadGeneratorStart(const LoadGeneratorConfig& config) {
+  bridgeLatency.reset();
+  broadcastLatency.reset();
+  uint32_t drops = queueDrops();
+
+  portENTER_CRITICAL(&loadMux);
+  active = config;
+  runId++;
+  generated = 0;
+  inputs = 0;
+  rejected = 0;
+  queueDropsAtStart = drops;
+  startUs = micros();
+  stopUs = startUs;
+  running = true;
+  portEXIT_CRITICAL(&loadMux);
+}
+
+void loadGeneratorStop() {
+  portENTER_CRITICAL(&loadMux);
+  if (running) {
+    running = false;
+    stopUs = micros();
+  }
+  portEXIT_CRITICAL(&loadMux);
+}
+
+bool loadGeneratorRunning() {
+  return running;
+}
+
+uint32_t loadGeneratorService() {
+  if (targetQueue == nullptr) return UINT32_MAX;
+
+  // Decidir bajo el lock cuántas tramas y entradas tocan; generarlas fuera
+  portENTER_CRITICAL(&loadMux);
+  if (!running) {
+    portEXIT_CRITICAL(&loadMux);
+    return UINT32_MAX;
+  }
+  LoadGeneratorConfig config = active;
+  uint32_t id = runId;
+  uint32_t durationUs = config.durationMs * 1000;
+  uint32_t elapsedUs = micros() - startUs;
+  bool finished = elapsedUs >= durationUs;
+  if (finished) {
+    elapsedUs = durationUs;
+    running = false;
+    stopUs = startUs + durationUs;
+  }
+
+  uint32_t due = (uint32_t)((uint64_t)elapsedUs * config.rateHz / 1000000);
+  uint32_t first = generated;
+  uint32_t frameCount = due - generated;
+  if (frameCount > LOAD_GEN_MAX_BURST) frameCount = LOAD_GEN_MAX_BURST;
+  generated += frameCount;
+
+  uint32_t inputsDue = (uint32_t)((uint64_t)elapsedUs * config.inputRateHz / 1000000);
+  uint32_t firstInput = inputs;
+  uint32_t inputCount = inputsDue - inputs;
+  inputs = inputsDue;
+  uint32_t nextIndex = generated;
+  portEXIT_CRITICAL(&loadMux);
+
+  // Mismo camino que el callback del puente serie: encolar y despertar al consumidor
+  uint32_t lost = 0;
+  uint8_t data[BRIDGE_FRAME_MAX + 1];
+  for (uint32_t i = 0; i < frameCount; i++) {
+    size_t len = buildFrame(config, first + i, data);
+    if (targetLock != nullptr) portENTER_CRITICAL(targetLock);
+    bool queued = targetQueue->push(data, len, millis(), micros());
+    if (targetLock != nullptr) portEXIT_CRITICAL(targetLock);
+    if (!queued) lost++;
+  }
+  if (frameCount > 0 && notifyConsumer != nullptr) notifyConsumer();
+
+  if (inputSink != nullptr) {
+    for (uint32_t i = 0; i < inputCount; i++) {
+      inputSink((uint8_t)((firstInput + i) % 3));
+    }
+  }
+
+  if (lost > 0) {
+    portENTER_CRITICAL(&loadMux);
+    if (runId == id) rejected += lost;
+    portEXIT_CRITICAL(&loadMux);
+  }
+
+  if (finished) return UINT32_MAX;
+
+  // Cuándo toca la siguiente trama (0 si ya hay atrasadas)
+  uint64_t nextDueUs = ((uint64_t)nextIndex + 1) * 1000000 / config.rateHz;
+  return nextDueUs > elapsedUs ? (uint32_t)(nextDueUs - elapsedUs) : 0;
+}
+
+// =============================
+// Informe
+// =============================
+LoadGeneratorReport loadGeneratorGetReport() {
+  LoadGeneratorReport report;
+  memset(&report, 0, sizeof(report));
+  uint32_t drops = queueDrops();
+
+  portENTER_CRITICAL(&loadMux);
+  report.running = running;
+  report.config = active;
+  report.elapsedMs = ((running ? micros() : stopUs) - startUs) / 1000;
+  report.generated = generated;
+  report.inputs = inputs;
+  report.rejected = rejected;
+  report.dropped = drops - queueDropsAtStart;
+  portEXIT_CRITICAL(&loadMux);
+
+  report.delivered = bridgeLatency.getCount();
+  if (report.elapsedMs > 0) {
+    report.offeredFps = (uint32_t)((uint64_t)report.generated * 1000 / report.elapsedMs);
+    report.sustainedFps = (uint32_t)((uint64_t)report.delivered * 1000 / report.elapsedMs);
+  }
+  report.bridgeP50Us = bridgeLatency.percentile(50);
+  report.bridgeP99Us = bridgeLatency.percentile(99);
+  report.bridgeMaxUs = bridgeLatency.getMax();
+  report.broadcastP50Us = broadcastLatency.percentile(50);
+  report.broadcastP99Us = broadcastLatency.percentile(99);
+  report.broadcastMaxUs = broadcastLatency.getMax();
+  return report;
+}
+
+size_t formatLoadGeneratorReport(const LoadGeneratorReport& report, char* out, size_t cap) {
+  int n = snprintf(out, cap, "%s %lus %lu/%lufps drop=%lu p99us=%lu/%lu",
+                   report.running ? "RUN" : "END", (unsigned long)(report.elapsedMs / 1000),
+                   (unsigned long)report.sustainedFps, (unsigned long)report.offeredFps,
+                   (unsigned long)report.dropped, (unsigned long)report.bridgeP99Us,
+                   (unsigned long)report.broadcastP99Us);
+  if (n < 0) return 0;
+  return (size_t)n < cap ? (size_t)n : cap - 1;
+}
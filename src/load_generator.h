@@ -0,0 +1,104 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include <Arduino.h>
+#include "kroner_config.h"
+#include "bridge_queue.h"
+
+// Tipo de trama sintética
+enum LoadFrameKind : uint8_t {
+  LOAD_FRAME_CHRONO = 0,   // XXYY1 con el tiempo en curso (se sustituyen por display)
+  LOAD_FRAME_TEXT = 1      // XXYY2 con texto de relleno
+};
+
+// Parámetros de una prueba de carga
+struct LoadGeneratorConfig {
+  uint32_t rateHz;         // Tramas por segundo
+  uint16_t frameLen;       // Bytes por trama (se rellena con espacios/texto)
+  LoadFrameKind kind;
+  uint8_t displays;        // Direcciones XXYY distintas que se reparten las tramas
+  uint32_t durationMs;     // Duración de la prueba
+  uint32_t inputRateHz;    // Entradas F1-F3 simuladas por segundo (0 = ninguna)
+};
+
+// Resultado (en curso o de la última prueba)
+struct LoadGeneratorReport {
+  bool running;
+  LoadGeneratorConfig config;
+  uint32_t elapsedMs;
+  uint32_t generated;      // Tramas generadas
+  uint32_t rejected;       // Tramas que la cola no aceptó (BRIDGE_DROP_NEWEST)
+  uint32_t dropped;        // Tramas perdidas en la cola (rechazadas o sobrescritas)
+  uint32_t delivered;      // Tramas transmitidas por la UART
+  uint32_t inputs;         // Entradas simuladas
+  uint32_t offeredFps;     // generated / elapsed
+  uint32_t sustainedFps;   // delivered / elapsed
+  uint32_t bridgeP50Us, bridgeP99Us, bridgeMaxUs;        // Generación -> último byte en la UART
+  uint32_t broadcastP50Us, broadcastP99Us, broadcastMaxUs; // Generación -> envío WebSocket
+};
+
+// Destino de las entradas simuladas (0..2 = F1..F3)
+typedef void (*LoadInputSink)(uint8_t input);
+
+/**
+ * @brief Prepara el generador
+ * @param queue Cola a la que se inyectan las tramas (la del callback del puente serie)
+ * @param notify Se llama tras encolar (despertar al consumidor); puede ser nullptr
+ * @param inputSink Destino de las entradas simuladas; puede ser nullptr
+ * @param producerLock Lock que comparten los productores de queue si hay más de
+ *        uno (la cola es SPSC); nullptr si el generador es el único
+ */
+void loadGeneratorInit(BridgeQueue& queue, void (*notify)(), LoadInputSink inputSink,
+                       portMUX_TYPE* producerLock = nullptr);
+
+/**
+ * @brief Configuración por defecto (LOAD_GEN_DEFAULT_*)
+ */
+LoadGeneratorConfig loadGeneratorDefaults();
+
+/**
+ * @brief Aplica un parámetro "clave=valor" a la configuración
+ * Claves: rate, size, kind (chrono|text), displays, seconds, inputs
+ * @return false si la clave o el valor no son válidos
+ */
+bool loadGeneratorApplyArg(LoadGeneratorConfig& config, const char* key, const char* value);
+
+/**
+ * @brief Aplica una lista "rate=200 size=40 kind=text" (separada por espacios, ',' o '&')
+ * @return false si algún parámetro no es válido
+ */
+bool loadGeneratorParseArgs(LoadGeneratorConfig& config, const char* args);
+
+/**
+ * @brief Arranca una prueba (detiene la anterior)
+ * Reinicia los histogramas bridge y broadcast para que el informe solo cubra la prueba.
+ */
+void loadGeneratorStart(const LoadGeneratorConfig& config);
+
+/**
+ * @brief Detiene la prueba en curso; el informe queda congelado
+ */
+void loadGeneratorStop();
+
+bool loadGeneratorRunning();
+
+/**
+ * @brief Genera las tramas y entradas que tocan (solo desde el hilo productor de la cola)
+ * Si el hilo se retrasa, genera de golpe las atrasadas (hasta LOAD_GEN_MAX_BURST por
+ * llamada) para mantener la tasa media.
+ * @return µs hasta la próxima trama (UINT32_MAX si no hay prueba en curso)
+ */
+uint32_t loadGeneratorService();
+
+/**
+ * @brief Informe de la prueba en curso o de la última
+ */
+LoadGeneratorReport loadGeneratorGetReport();
+
+/**
+ * @brief Resumen en una línea (para BLE y el puerto serie)
+ * @return Longitud escrita
+ */
+size_t formatLoadGeneratorReport(const LoadGeneratorReport& report, char* out, size_t cap);
+
+#endif
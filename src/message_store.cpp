@@ -0,0 +1,176 @@
+#include "message_store.h"
+#include <Arduino.h>
+#include <string.h>
+#include <atomic>
+
+// Última trama publicada y histórico comparten un portMUX: las secciones
+// críticas son solo la copia de un JSON ya codificado (< 450 bytes), así un
+// lector que interrumpe al escritor en el mismo núcleo nunca queda esperando
+// a que termine (un seqlock giraría para siempre con el escritor parado)
+static portMUX_TYPE storeMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Última trama publicada
+static char publishedJson[MESSAGE_JSON_MAX] = "{\"len\":0,\"time\":0,\"data\":\"\"}";
+static size_t publishedLen = strlen("{\"len\":0,\"time\":0,\"data\":\"\"}");
+
+// Buffers propios del escritor
+static char scratchJson[MESSAGE_JSON_MAX];
+static uint8_t scratchBin[MESSAGE_BIN_MAX];
+static char scratchHistory[MESSAGE_HISTORY_JSON_MAX];
+static EncodedMessage scratchMessage = {0, 0, scratchJson, 0, scratchBin, 0};
+
+// Secuencia compartida por tramas TX y RX
+static uint32_t nextSeq = 1;
+
+// Histórico de las últimas tramas
+struct HistorySlot {
+  uint32_t seq;
+  uint16_t jsonLen;
+  char json[MESSAGE_HISTORY_JSON_MAX];
+};
+
+static HistorySlot history[MESSAGE_HISTORY_SLOTS];
+static std::atomic<uint32_t> historyLatestSeq(0);
+
+static char* appendText(char* p, const char* text) {
+  while (*text) *p++ = *text++;
+  return p;
+}
+
+static char* appendUInt(char* p, uint32_t value) {
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (n > 0) *p++ = digits[--n];
+  return p;
+}
+
+size_t encodeFrameJson(const BridgeFrame& frame, const char* dir, char* out, size_t cap) {
+  size_t dirLen = dir ? strlen(dir) : 0;
+  if (cap < 64 + base64EncodedLength(frame.len) + dirLen) {
+    return 0;
+  }
+
+  char* p = out;
+  p = appendText(p, "{\"len\":");
+  p = appendUInt(p, frame.len);
+  p = appendText(p, ",\"time\":");
+  p = appendUInt(p, frame.time);
+  p = appendText(p, ",\"data\":\"");
+  p += base64Encode(frame.data, frame.len, p);
+  *p++ = '"';
+  if (dir != nullptr) {
+    p = appendText(p, ",\"dir\":\"");
+    p = appendText(p, dir);
+    *p++ = '"';
+  }
+  *p++ = '}';
+  *p = '\0';
+  return (size_t)(p - out);
+}
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+size_t encodeFrameBinary(const BridgeFrame& frame, uint32_t seq, uint8_t flags, uint8_t* out, size_t cap) {
+  size_t total = MESSAGE_BIN_HEADER_LEN + frame.len;
+  if (cap < total) {
+    return 0;
+  }
+  out[0] = MESSAGE_BIN_VERSION;
+  out[1] = flags;
+  putU16(out + 2, frame.len);
+  putU32(out + 4, seq);
+  putU32(out + 8, frame.time);
+  memcpy(out + MESSAGE_BIN_HEADER_LEN, frame.data, frame.len);
+  return total;
+}
+
+// Guarda el JSON recién codificado como {"seq":N,<resto>}
+static void appendHistory(uint32_t seq, const char* json, size_t jsonLen) {
+  if (jsonLen < 2) return;
+  char* p = appendText(scratchHistory, "{\"seq\":");
+  p = appendUInt(p, seq);
+  *p++ = ',';
+  memcpy(p, json + 1, jsonLen - 1);  // Sin la '{' inicial
+  p += jsonLen - 1;
+  size_t len = (size_t)(p - scratchHistory);
+
+  HistorySlot& slot = history[seq % MESSAGE_HISTORY_SLOTS];
+  portENTER_CRITICAL(&storeMux);
+  memcpy(slot.json, scratchHistory, len);
+  slot.seq = seq;
+  slot.jsonLen = (uint16_t)len;
+  portEXIT_CRITICAL(&storeMux);
+
+  historyLatestSeq.store(seq, std::memory_order_release);
+}
+
+static const EncodedMessage& encodeMessage(const BridgeFrame& frame, bool rx) {
+  scratchMessage.seq = nextSeq++;
+  scratchMessage.stampUs = frame.stampUs;
+  scratchMessage.jsonLen = encodeFrameJson(frame, rx ? "rx" : nullptr, scratchJson, sizeof(scratchJson));
+  scratchMessage.binLen = encodeFrameBinary(frame, scratchMessage.seq, rx ? MESSAGE_BIN_FLAG_RX : 0,
+                                            scratchBin, sizeof(scratchBin));
+  appendHistory(scratchMessage.seq, scratchJson, scratchMessage.jsonLen);
+  return scratchMessage;
+}
+
+const EncodedMessage& encodeRadioMessage(const BridgeFrame& frame) {
+  return encodeMessage(frame, true);
+}
+
+const EncodedMessage& publishLatestMessage(const BridgeFrame& frame) {
+  const EncodedMessage& message = encodeMessage(frame, false);
+  size_t len = message.jsonLen;
+
+  portENTER_CRITICAL(&storeMux);
+  memcpy(publishedJson, scratchJson, len + 1);
+  publishedLen = len;
+  portEXIT_CRITICAL(&storeMux);
+
+  return message;
+}
+
+size_t copyLatestMessageJson(char* out, size_t cap) {
+  if (cap == 0) return 0;
+  portENTER_CRITICAL(&storeMux);
+  size_t len = publishedLen;
+  if (len >= cap) len = cap - 1;
+  memcpy(out, publishedJson, len);
+  portEXIT_CRITICAL(&storeMux);
+  out[len] = '\0';
+  return len;
+}
+
+uint32_t getLatestMessageSeq() {
+  return historyLatestSeq.load(std::memory_order_acquire);
+}
+
+size_t copyHistoryMessageJson(uint32_t seq, char* out, size_t cap) {
+  if (cap == 0 || seq == 0) return 0;
+  const HistorySlot& slot = history[seq % MESSAGE_HISTORY_SLOTS];
+  size_t len = 0;
+  portENTER_CRITICAL(&storeMux);
+  // Si no coincide, la sobrescribió una trama más reciente (o aún no se escribió)
+  if (slot.seq == seq) {
+    len = slot.jsonLen;
+    if (len >= cap) len = cap - 1;
+    memcpy(out, slot.json, len);
+  }
+  portEXIT_CRITICAL(&storeMux);
+  out[len] = '\0';
+  return len;
+}
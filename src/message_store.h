@@ -0,0 +1,96 @@
+#ifndef MESSAGE_STORE_H
+#define MESSAGE_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bridge_queue.h"
+#include "base64_codec.h"
+
+// Tamaño máximo del JSON de una trama: {"len":N,"time":N,"data":"<base64>","dir":"xx"}
+#define MESSAGE_JSON_MAX (64 + ((BRIDGE_FRAME_MAX + 2) / 3) * 4)
+
+// Entrada del histórico: el JSON anterior con "seq" delante
+#define MESSAGE_HISTORY_JSON_MAX (MESSAGE_JSON_MAX + 16)
+
+// Trama binaria (mensaje WebSocket binario), little-endian:
+//   [0] versión  [1] flags  [2..3] len  [4..7] seq  [8..11] time (ms)  [12..] datos
+#define MESSAGE_BIN_VERSION 1
+#define MESSAGE_BIN_HEADER_LEN 12
+#define MESSAGE_BIN_MAX (MESSAGE_BIN_HEADER_LEN + BRIDGE_FRAME_MAX)
+#define MESSAGE_BIN_FLAG_RX 0x01   // Trama recibida por el APC220
+
+// Trama codificada en ambos formatos (JSON y binario)
+struct EncodedMessage {
+  uint32_t seq;
+  uint32_t stampUs;         // micros() de llegada de la trama (0 = desconocido)
+  const char* json;
+  size_t jsonLen;
+  const uint8_t* bin;
+  size_t binLen;
+};
+
+/**
+ * @brief Serializa una trama como {"len":..,"time":..,"data":"<base64>"}
+ * @param frame Trama
+ * @param dir Valor del campo "dir" o nullptr para omitirlo
+ * @param out Destino (al menos MESSAGE_JSON_MAX bytes)
+ * @param cap Tamaño del destino
+ * @return Longitud del JSON (sin '\0'), 0 si no cabe
+ */
+size_t encodeFrameJson(const BridgeFrame& frame, const char* dir, char* out, size_t cap);
+
+/**
+ * @brief Serializa una trama en el formato binario de WebSocket
+ * @param frame Trama
+ * @param seq Número de secuencia
+ * @param flags MESSAGE_BIN_FLAG_*
+ * @param out Destino (al menos MESSAGE_BIN_MAX bytes)
+ * @param cap Tamaño del destino
+ * @return Longitud de la trama binaria, 0 si no cabe
+ */
+size_t encodeFrameBinary(const BridgeFrame& frame, uint32_t seq, uint8_t flags, uint8_t* out, size_t cap);
+
+/**
+ * @brief Publica la última trama del puente, codificándola una sola vez
+ * Solo debe llamarse desde un único escritor (la tarea de radio).
+ * @param frame Trama
+ * @return Codificaciones, válidas para el escritor hasta la siguiente llamada
+ */
+const EncodedMessage& publishLatestMessage(const BridgeFrame& frame);
+
+/**
+ * @brief Codifica una trama recibida por el APC220 ("dir":"rx")
+ * Mismo escritor que publishLatestMessage(); no modifica la última trama.
+ * @param frame Trama
+ * @return Codificaciones, válidas para el escritor hasta la siguiente llamada
+ */
+const EncodedMessage& encodeRadioMessage(const BridgeFrame& frame);
+
+/**
+ * @brief Copia el JSON de la última trama publicada
+ * Seguro desde cualquier tarea; no vuelve a codificar.
+ * @param out Destino (al menos MESSAGE_JSON_MAX bytes)
+ * @param cap Tamaño del destino
+ * @return Longitud copiada (sin '\0')
+ */
+size_t copyLatestMessageJson(char* out, size_t cap);
+
+/**
+ * @brief Secuencia de la última trama (TX o RX) guardada en el histórico
+ * Seguro desde cualquier tarea.
+ * @return 0 si aún no hay tramas
+ */
+uint32_t getLatestMessageSeq();
+
+/**
+ * @brief Copia del histórico el JSON {"seq":..,"len":..,...} de una trama
+ * Seguro desde cualquier tarea. El histórico guarda las últimas
+ * MESSAGE_HISTORY_SLOTS tramas; las anteriores ya no están disponibles.
+ * @param seq Secuencia de la trama
+ * @param out Destino (al menos MESSAGE_HISTORY_JSON_MAX bytes)
+ * @param cap Tamaño del destino
+ * @return Longitud copiada (sin '\0'), 0 si la trama no está en el histórico
+ */
+size_t copyHistoryMessageJson(uint32_t seq, char* out, size_t cap);
+
+#endif
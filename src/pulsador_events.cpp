@@ -0,0 +1,86 @@
+#include "pulsador_events.h"
+
+PulsadorEventBatch::PulsadorEventBatch()
+    : head(0), count(0), nextSeq(0), stats{0, 0, 0, 0} {
+}
+
+bool PulsadorEventBatch::append(uint8_t id, uint8_t value, uint64_t timeUs) {
+  bool stored = false;
+  portENTER_CRITICAL(&mux);
+  uint32_t seq = nextSeq++;
+  if (count < CAPACITY) {
+    Record& record = records[(head + count) % CAPACITY];
+    record.seq = seq;
+    record.id = id;
+    record.value = value;
+    record.timeUs = timeUs;
+    count++;
+    stats.records++;
+    stored = true;
+  } else {
+    stats.lost++;
+  }
+  portEXIT_CRITICAL(&mux);
+  return stored;
+}
+
+void PulsadorEventBatch::skip(uint32_t lost) {
+  if (lost == 0) return;
+  portENTER_CRITICAL(&mux);
+  nextSeq += lost;
+  stats.lost += lost;
+  portEXIT_CRITICAL(&mux);
+}
+
+size_t PulsadorEventBatch::packNext(uint8_t* out, size_t maxLen) {
+  if (maxLen < PULSADOR_EVENTS_MIN_PAYLOAD) return 0;
+  size_t room = (maxLen - PULSADOR_EVENTS_HEADER_LEN) / PULSADOR_EVENTS_RECORD_LEN;
+  if (room > 255) room = 255;
+
+  portENTER_CRITICAL(&mux);
+  if (count == 0) {
+    portEXIT_CRITICAL(&mux);
+    return 0;
+  }
+
+  const Record& first = records[head];
+  out[0] = PULSADOR_EVENTS_VERSION;
+  memcpy(out + 2, &first.seq, sizeof(first.seq));
+  memcpy(out + 6, &first.timeUs, sizeof(first.timeUs));
+
+  uint8_t* p = out + PULSADOR_EVENTS_HEADER_LEN;
+  uint32_t packed = 0;
+  while (packed < count && packed < room) {
+    const Record& record = records[(head + packed) % CAPACITY];
+    if (record.seq != first.seq + packed) break;   // Hueco: sigue en otra notificación
+    int32_t offsetUs = (int32_t)(int64_t)(record.timeUs - first.timeUs);
+    p[0] = record.id;
+    p[1] = record.value;
+    memcpy(p + 2, &offsetUs, sizeof(offsetUs));
+    p += PULSADOR_EVENTS_RECORD_LEN;
+    packed++;
+  }
+  out[1] = (uint8_t)packed;
+
+  head = (head + packed) % CAPACITY;
+  count -= packed;
+  stats.notifications++;
+  portEXIT_CRITICAL(&mux);
+
+  return PULSADOR_EVENTS_HEADER_LEN + packed * PULSADOR_EVENTS_RECORD_LEN;
+}
+
+void PulsadorEventBatch::clear() {
+  portENTER_CRITICAL(&mux);
+  head = 0;
+  count = 0;
+  portEXIT_CRITICAL(&mux);
+}
+
+PulsadorEventStats PulsadorEventBatch::getStats() const {
+  portENTER_CRITICAL(&mux);
+  PulsadorEventStats snapshot = stats;
+  snapshot.pending = count;
+  portEXIT_CRITICAL(&mux);
+  return snapshot;
+}
@@ -0,0 +1,90 @@
+#ifndef PULSADOR_EVENTS_H
+#define PULSADOR_EVENTS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "kroner_config.h"
+
+// Formato binario de pulsadorCharacteristic (little-endian), varios eventos
+// por notificación:
+//   [0] versión  [1] registros  [2..5] secuencia del primer registro (uint32)
+//   [6..13] esp_timer_get_time() del primer registro (uint64, µs)
+//   y por registro (6 bytes):
+//   [0] evento  [1] valor  [2..5] µs respecto al primer registro (int32)
+// Los registros de una notificación tienen secuencias consecutivas (un hueco
+// abre otra notificación); un salto entre notificaciones indica eventos perdidos.
+#define PULSADOR_EVENTS_VERSION 1
+#define PULSADOR_EVENTS_HEADER_LEN 14
+#define PULSADOR_EVENTS_RECORD_LEN 6
+#define PULSADOR_EVENTS_MIN_PAYLOAD (PULSADOR_EVENTS_HEADER_LEN + PULSADOR_EVENTS_RECORD_LEN)
+
+// Identificadores de evento
+enum PulsadorEventId : uint8_t {
+  PULSADOR_EVENT_F1 = 0x01,          // F1..F3 = 0x01..0x03, valor 0
+  PULSADOR_EVENT_KEY = 0x10,         // + índice en KEYPAD_KEYS, valor 0
+  PULSADOR_EVENT_SWITCH = 0x20       // + switch (0..2), valor = estado (0/1)
+};
+
+// Contadores del lote (instantánea)
+struct PulsadorEventStats {
+  uint32_t records;        // Registros aceptados
+  uint32_t notifications;  // Notificaciones empaquetadas
+  uint32_t lost;           // Secuencias saltadas (lote lleno o cola de flancos llena)
+  uint32_t pending;        // Registros a la espera de notificarse
+};
+
+/**
+ * @brief Acumula eventos de entrada y los empaqueta en notificaciones
+ *
+ * Varios productores (tarea de entradas y tarea BLE) añaden registros; solo la
+ * tarea de entradas empaqueta. Cada registro recibe su número de secuencia al
+ * añadirse; si no cabe, la secuencia se consume igualmente para que el cliente
+ * vea el hueco.
+ */
+class PulsadorEventBatch {
+public:
+  static const uint32_t CAPACITY = PULSADOR_EVENT_SLOTS;
+
+  PulsadorEventBatch();
+
+  /**
+   * @brief Añade un evento (cualquier tarea, no desde ISR)
+   * @return false si el lote estaba lleno y el evento se perdió
+   */
+  bool append(uint8_t id, uint8_t value, uint64_t timeUs);
+
+  /**
+   * @brief Consume secuencias de eventos perdidos antes de llegar al lote
+   */
+  void skip(uint32_t count);
+
+  /**
+   * @brief Empaqueta en out tantos registros pendientes como quepan
+   * @param maxLen Carga útil de una notificación (MTU - 3)
+   * @return Bytes escritos; 0 si no hay nada pendiente o maxLen es muy pequeño
+   */
+  size_t packNext(uint8_t* out, size_t maxLen);
+
+  // Descarta lo pendiente (cambio de formato o desconexión)
+  void clear();
+
+  PulsadorEventStats getStats() const;
+
+private:
+  struct Record {
+    uint32_t seq;
+    uint8_t id;
+    uint8_t value;
+    uint64_t timeUs;
+  };
+
+  Record records[CAPACITY];
+  uint32_t head;             // Primer registro pendiente
+  uint32_t count;            // Registros pendientes
+  uint32_t nextSeq;          // Secuencia del próximo registro añadido
+  PulsadorEventStats stats;
+  mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif
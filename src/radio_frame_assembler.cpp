@@ -0,0 +1,61 @@
+#include "radio_frame_assembler.h"
+#include "display_protocol.h"
+#include <string.h>
+
+RadioFrameAssembler::RadioFrameAssembler(BridgeQueue& out)
+    : out(out), length(0), startMs(0), startUs(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t RadioFrameAssembler::feed(const uint8_t* data, size_t len, uint32_t nowMs, uint32_t nowUs) {
+  uint32_t completed = 0;
+  stats.bytes += len;
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = data[i];
+
+    // Fin de línea: cerrar la trama (los CR/LF sueltos se ignoran)
+    if (b == '\r' || b == '\n') {
+      if (emit()) completed++;
+      continue;
+    }
+
+    if (length == 0) {
+      startMs = nowMs;
+      startUs = nowUs;
+    }
+
+    // Trama demasiado larga: entregar lo acumulado y seguir
+    if (length >= BRIDGE_FRAME_MAX) {
+      stats.truncated++;
+      if (emit()) completed++;
+      startMs = nowMs;
+      startUs = nowUs;
+    }
+
+    buffer[length++] = b;
+  }
+  return completed;
+}
+
+bool RadioFrameAssembler::endOfBurst() {
+  return emit();
+}
+
+bool RadioFrameAssembler::emit() {
+  if (length == 0) return false;
+
+  DisplayFrameInfo info;
+  if (!parseDisplayFrame(buffer, length, info)) {
+    stats.malformed++;
+  }
+
+  bool queued = out.push(buffer, length, startMs, startUs);
+  if (queued) {
+    stats.frames++;
+  } else {
+    stats.queueDrops++;
+  }
+  length = 0;
+  return queued;
+}
@@ -0,0 +1,56 @@
+#ifndef RADIO_FRAME_ASSEMBLER_H
+#define RADIO_FRAME_ASSEMBLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "bridge_queue.h"
+
+// Contadores del ensamblador de recepción
+struct RadioRxStats {
+  uint32_t bytes;       // Bytes recibidos
+  uint32_t frames;      // Tramas completas entregadas
+  uint32_t malformed;   // Tramas que no cumplen XXYYT (se entregan igualmente)
+  uint32_t truncated;   // Tramas cortadas por superar BRIDGE_FRAME_MAX
+  uint32_t queueDrops;  // Tramas rechazadas por la cola de salida
+};
+
+/**
+ * @brief Reensambla tramas del protocolo de display recibidas por el APC220
+ *
+ * Una trama termina con '\r' o '\n', o cuando la UART detecta un hueco sin
+ * datos (endOfBurst()). Cada trama lleva la marca de tiempo de su primer byte.
+ */
+class RadioFrameAssembler {
+public:
+  explicit RadioFrameAssembler(BridgeQueue& out);
+
+  /**
+   * @brief Procesa bytes recibidos
+   * @param data Bytes
+   * @param len Longitud
+   * @param nowMs millis() de llegada
+   * @param nowUs micros() de llegada
+   * @return Número de tramas completadas
+   */
+  uint32_t feed(const uint8_t* data, size_t len, uint32_t nowMs, uint32_t nowUs);
+
+  /**
+   * @brief Cierra la trama en curso (hueco en la línea)
+   * @return true si se entregó una trama
+   */
+  bool endOfBurst();
+
+  RadioRxStats getStats() const { return stats; }
+
+private:
+  BridgeQueue& out;
+  uint8_t buffer[BRIDGE_FRAME_MAX];
+  uint16_t length;
+  uint32_t startMs;
+  uint32_t startUs;
+  RadioRxStats stats;
+
+  bool emit();
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "radio_tx_pacer.h"
+
+/**
+ * @brief Vacía el cubo durante elapsedUs
+ * @param levelMilli Ocupación en milésimas de byte (se actualiza)
+ * @return Microsegundos de ese intervalo con datos en el buffer
+ */
+static uint32_t drainLevel(uint32_t& levelMilli, uint32_t elapsedUs, uint32_t drainRate) {
+  // bytes/s * µs / 1e6 * 1000 = milésimas de byte
+  uint64_t drained = (uint64_t)elapsedUs * drainRate / 1000;
+  if (drained >= levelMilli) {
+    uint32_t busyUs = (uint32_t)((uint64_t)levelMilli * 1000 / drainRate);
+    levelMilli = 0;
+    return busyUs;
+  }
+  levelMilli -= (uint32_t)drained;
+  return elapsedUs;
+}
+
+static uint8_t percentOf(uint64_t part, uint64_t whole) {
+  if (whole == 0) return 0;
+  uint64_t percent = part * 100 / whole;
+  return percent > 100 ? 100 : (uint8_t)percent;
+}
+
+RadioTxPacer::RadioTxPacer() {
+  configure(RADIO_UART_BAUD, RADIO_UART_BAUD, RADIO_MODULE_BUFFER_BYTES, 0);
+}
+
+void RadioTxPacer::configure(uint32_t airBps, uint32_t uartBps, uint16_t bufferBytes, uint32_t nowUs) {
+  portENTER_CRITICAL(&mux);
+  this->airBps = airBps;
+  this->uartBps = uartBps;
+  drainRate = (uint32_t)((uint64_t)airBps * RADIO_TX_AIR_EFFICIENCY_PCT / 800);
+  // Con la UART más lenta que el aire, lo que limita es la UART (8N1: 10 bits por byte)
+  if (uartBps / 10 < drainRate) drainRate = uartBps / 10;
+  if (drainRate == 0) drainRate = 1;
+  bufferLimit = (uint16_t)((uint32_t)bufferBytes * RADIO_TX_BUFFER_FILL_PCT / 100);
+  if (bufferLimit == 0) bufferLimit = 1;
+  levelMilli = 0;
+  lastUs = nowUs;
+  memset(&stats, 0, sizeof(stats));
+  portEXIT_CRITICAL(&mux);
+}
+
+void RadioTxPacer::advance(uint32_t nowUs) {
+  uint32_t elapsed = nowUs - lastUs;
+  lastUs = nowUs;
+  stats.elapsedUs += elapsed;
+  stats.activeUs += drainLevel(levelMilli, elapsed, drainRate);
+}
+
+uint32_t RadioTxPacer::reserve(size_t len, uint32_t nowUs) {
+  if (len > bufferLimit) len = bufferLimit;
+  portENTER_CRITICAL(&mux);
+  advance(nowUs);
+  uint32_t needMilli = levelMilli + (uint32_t)len * 1000;
+  uint32_t limitMilli = (uint32_t)bufferLimit * 1000;
+  uint32_t waitUs = 0;
+  if (needMilli > limitMilli) {
+    // Redondeo hacia arriba: al despertar ya cabe
+    waitUs = (uint32_t)(((uint64_t)(needMilli - limitMilli) * 1000 + drainRate - 1) / drainRate);
+  }
+  portEXIT_CRITICAL(&mux);
+  return waitUs;
+}
+
+void RadioTxPacer::commit(size_t len, uint32_t nowUs, uint32_t waitedUs) {
+  portENTER_CRITICAL(&mux);
+  advance(nowUs);
+  levelMilli += (uint32_t)len * 1000;
+  uint16_t level = (uint16_t)((levelMilli + 999) / 1000);
+  if (level > stats.peakLevel) stats.peakLevel = level;
+  stats.bytes += len;
+  stats.chunks++;
+  if (waitedUs > 0) {
+    stats.throttled++;
+    stats.throttledUs += waitedUs;
+  }
+  stats.airBusyUs += (uint64_t)len * 8000000 / airBps;
+  portEXIT_CRITICAL(&mux);
+}
+
+RadioTxPacerStats RadioTxPacer::getStats(uint32_t nowUs) const {
+  portENTER_CRITICAL(&mux);
+  RadioTxPacerStats snapshot = stats;
+  uint32_t level = levelMilli;
+  uint32_t elapsed = nowUs - lastUs;
+  snapshot.airBps = airBps;
+  snapshot.uartBps = uartBps;
+  snapshot.drainBytesPerSec = drainRate;
+  snapshot.bufferLimit = bufferLimit;
+  portEXIT_CRITICAL(&mux);
+
+  // Avanzar la copia hasta ahora sin tocar el estado
+  snapshot.elapsedUs += elapsed;
+  snapshot.activeUs += drainLevel(level, elapsed, snapshot.drainBytesPerSec);
+  snapshot.level = (uint16_t)((level + 999) / 1000);
+  snapshot.utilization = percentOf(snapshot.airBusyUs, snapshot.elapsedUs);
+  snapshot.burstUtilization = percentOf(snapshot.airBusyUs, snapshot.activeUs);
+  return snapshot;
+}
@@ -0,0 +1,84 @@
+#ifndef RADIO_TX_PACER_H
+#define RADIO_TX_PACER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "kroner_config.h"
+
+// Contadores del dosificador de transmisión (instantánea)
+struct RadioTxPacerStats {
+  uint32_t airBps;          // Velocidad RF configurada en el módulo
+  uint32_t uartBps;         // Velocidad de la UART hacia el módulo
+  uint32_t drainBytesPerSec; // Vaciado supuesto del buffer del módulo por el aire
+  uint16_t bufferLimit;     // Bytes que se dejan ocupar del buffer del módulo
+  uint16_t level;           // Ocupación estimada ahora
+  uint16_t peakLevel;       // Ocupación estimada máxima
+  uint32_t bytes;           // Bytes escritos en la UART
+  uint32_t chunks;          // Escrituras
+  uint32_t throttled;       // Escrituras que tuvieron que esperar
+  uint64_t throttledUs;     // Tiempo total de espera
+  uint64_t airBusyUs;       // Tiempo de aire de lo escrito (a la velocidad RF nominal)
+  uint64_t activeUs;        // Tiempo con datos en el buffer del módulo
+  uint64_t elapsedUs;       // Tiempo desde configure()
+  uint8_t utilization;      // airBusyUs / elapsedUs (%): ocupación del canal
+  uint8_t burstUtilization; // airBusyUs / activeUs (%): aprovechamiento del aire con datos pendientes
+};
+
+/**
+ * @brief Dosifica los bytes hacia el APC220 según su velocidad RF
+ *
+ * Modela el buffer interno del módulo como un cubo que se llena con cada
+ * escritura y se vacía al RADIO_TX_AIR_EFFICIENCY_PCT de la velocidad RF (el
+ * resto se va en cabeceras de paquete del módulo), o a la de la UART si es
+ * menor. Antes de escribir, reserve() dice cuánto esperar para que la
+ * ocupación no pase de RADIO_TX_BUFFER_FILL_PCT del buffer. Lo escrito cuenta
+ * entero desde commit(), aunque aún esté en el buffer TX del driver: el cubo
+ * acota lo que hay entre el driver y el módulo, que así nunca se desborda.
+ * Escribe la tarea de radio; getStats() se lee desde otras tareas bajo portMUX.
+ */
+class RadioTxPacer {
+public:
+  RadioTxPacer();
+
+  /**
+   * @brief Fija las velocidades y el buffer del módulo y reinicia contadores
+   * @param airBps Velocidad RF (bps)
+   * @param uartBps Velocidad de la UART (bps)
+   * @param bufferBytes Tamaño del buffer interno del módulo
+   * @param nowUs micros() actual
+   */
+  void configure(uint32_t airBps, uint32_t uartBps, uint16_t bufferBytes, uint32_t nowUs);
+
+  // Bytes máximos de una escritura (lo que cabe con el buffer vacío)
+  size_t maxChunk() const { return bufferLimit; }
+
+  /**
+   * @brief Microsegundos que hay que esperar para poder escribir len bytes
+   * @return 0 si caben ya
+   */
+  uint32_t reserve(size_t len, uint32_t nowUs);
+
+  /**
+   * @brief Registra len bytes ya entregados al módulo
+   * @param waitedUs Espera que precedió a la escritura (estadística)
+   */
+  void commit(size_t len, uint32_t nowUs, uint32_t waitedUs);
+
+  RadioTxPacerStats getStats(uint32_t nowUs) const;
+
+private:
+  uint32_t airBps;
+  uint32_t uartBps;
+  uint32_t drainRate;       // Bytes por segundo que salen por el aire
+  uint16_t bufferLimit;
+  uint32_t levelMilli;      // Ocupación estimada en milésimas de byte
+  uint32_t lastUs;
+  RadioTxPacerStats stats;
+  mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+  // Vacía el cubo hasta nowUs y acumula tiempo activo y transcurrido
+  void advance(uint32_t nowUs);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "radio_tx_staging.h"
+#include "display_protocol.h"
+#include <string.h>
+
+RadioTxStaging::RadioTxStaging() : head(0), count(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool RadioTxStaging::commit(uint8_t tag, uint16_t& supersededLen, uint8_t& supersededTag) {
+  const uint32_t mask = RADIO_TX_STAGING_SLOTS - 1;
+  Entry& incoming = entries[(head + count) & mask];
+  DisplayFrameInfo info;
+  parseDisplayFrame(incoming.frame.data, incoming.frame.len, info);
+  incoming.address = info.valid ? info.address : 0;
+  incoming.type = info.type;
+  incoming.tag = tag;
+  stats.staged++;
+
+  if (incoming.type == DISPLAY_TYPE_CHRONO) {
+    // De la más nueva a la más antigua, hasta la primera barrera de ese display
+    for (uint32_t i = count; i-- > 0;) {
+      Entry& queued = entries[(head + i) & mask];
+      if (queued.address != incoming.address && queued.address != 0) continue;
+      if (queued.type != DISPLAY_TYPE_CHRONO || queued.address == 0) break;
+
+      supersededLen = queued.frame.len;
+      supersededTag = queued.tag;
+      memcpy(&queued.frame, &incoming.frame, offsetof(BridgeFrame, data) + incoming.frame.len);
+      queued.tag = tag;
+      stats.coalesced++;
+      return true;
+    }
+  }
+
+  count++;
+  stats.depth = count;
+  if (count > stats.maxDepth) stats.maxDepth = count;
+  return false;
+}
+
+bool RadioTxStaging::pop(BridgeFrame& out, uint8_t& tag) {
+  if (count == 0) return false;
+  const Entry& e = entries[head];
+  memcpy(&out, &e.frame, offsetof(BridgeFrame, data) + e.frame.len);
+  tag = e.tag;
+  head = (head + 1) & (RADIO_TX_STAGING_SLOTS - 1);
+  count--;
+  stats.depth = count;
+  stats.sent++;
+  return true;
+}
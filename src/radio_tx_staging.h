@@ -0,0 +1,72 @@
+#ifndef RADIO_TX_STAGING_H
+#define RADIO_TX_STAGING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kroner_config.h"
+#include "bridge_queue.h"
+
+static_assert((RADIO_TX_STAGING_SLOTS & (RADIO_TX_STAGING_SLOTS - 1)) == 0,
+              "RADIO_TX_STAGING_SLOTS debe ser potencia de 2");
+
+// Contadores (instantánea)
+struct RadioTxStagingStats {
+  uint32_t staged;      // Tramas aceptadas
+  uint32_t sent;        // Tramas entregadas a la UART
+  uint32_t coalesced;   // Cronos sustituidos por uno más reciente del mismo display
+  uint32_t depth;
+  uint32_t maxDepth;
+};
+
+/**
+ * @brief Tramas listas para el APC220, con el crono más reciente de cada display
+ *
+ * Una trama crono (tipo 1) sustituye en su sitio a la crono pendiente del
+ * mismo XXYY, salvo que detrás de ella haya otra trama para ese display
+ * (texto, limpiar, control) o una que no se pueda decodificar: esas mantienen
+ * su orden estricto. Así un crono atrasado nunca sale tras uno más nuevo y la
+ * cola no crece con valores obsoletos aunque el teléfono envíe más rápido que
+ * la radio. Solo la usa la tarea de radio.
+ */
+class RadioTxStaging {
+public:
+  RadioTxStaging();
+
+  bool full() const { return count >= RADIO_TX_STAGING_SLOTS; }
+  bool empty() const { return count == 0; }
+
+  // Hueco donde copiar la próxima trama (válido si !full()); se acepta con commit()
+  BridgeFrame& back() { return entries[(head + count) & (RADIO_TX_STAGING_SLOTS - 1)].frame; }
+
+  /**
+   * @brief Acepta la trama copiada en back()
+   * @param tag Origen de la trama (se devuelve en pop())
+   * @param supersededLen Longitud de la trama sustituida, si la hubo
+   * @param supersededTag Origen de la trama sustituida, si la hubo
+   * @return true si sustituyó a un crono pendiente (la sustituida no saldrá)
+   */
+  bool commit(uint8_t tag, uint16_t& supersededLen, uint8_t& supersededTag);
+
+  /**
+   * @brief Extrae la trama más antigua
+   * @return false si no hay ninguna
+   */
+  bool pop(BridgeFrame& out, uint8_t& tag);
+
+  RadioTxStagingStats getStats() const { return stats; }
+
+private:
+  struct Entry {
+    BridgeFrame frame;
+    uint32_t address;   // XXYY empaquetado (0 si no se pudo decodificar)
+    uint8_t type;       // DisplayFrameType
+    uint8_t tag;
+  };
+
+  Entry entries[RADIO_TX_STAGING_SLOTS];
+  uint32_t head;
+  uint32_t count;
+  RadioTxStagingStats stats;
+};
+
+#endif
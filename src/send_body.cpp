@@ -0,0 +1,20 @@
+#include <string.h>
+#include "send_body.h"
+
+bool appendSendBodyParam(const char* name, const char* value, uint8_t* out, size_t cap, size_t& len) {
+  bool plain = strcmp(name, "body") == 0;
+  size_t nameLen = plain ? 0 : strlen(name);
+  size_t valueLen = strlen(value);
+  size_t needed = (len > 0 ? 1 : 0) + (plain ? 0 : nameLen + 1) + valueLen;
+  if (len > cap || needed > cap - len) return false;
+
+  if (len > 0) out[len++] = '&';
+  if (!plain) {
+    memcpy(out + len, name, nameLen);
+    len += nameLen;
+    out[len++] = '=';
+  }
+  memcpy(out + len, value, valueLen);
+  len += valueLen;
+  return true;
+}
@@ -0,0 +1,25 @@
+#ifndef SEND_BODY_H
+#define SEND_BODY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Recompone el cuerpo de /api/send a partir de un parámetro de formulario
+ *
+ * ESPAsyncWebServer trata como formulario un cuerpo text/plain que empieza
+ * por "nombre=": lo separa por '&' en parámetros y no llama al manejador de
+ * cuerpo. Llamando a esta función con cada parámetro POST, en orden, se
+ * vuelve a unir como "a=b&c"; los trozos sin '=' llegan con nombre "body" y
+ * se copian tal cual. La librería ya decodificó '+' y %xx: solo un cuerpo
+ * application/octet-stream llega byte a byte.
+ * @param name Nombre del parámetro
+ * @param value Valor del parámetro
+ * @param out Destino
+ * @param cap Tamaño del destino
+ * @param len Bytes ya escritos en out; se actualiza
+ * @return false si no cabe (out queda como estaba)
+ */
+bool appendSendBodyParam(const char* name, const char* value, uint8_t* out, size_t cap, size_t& len);
+
+#endif
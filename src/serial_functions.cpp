@@ -1,11 +1,148 @@
 #include "kroner_config.h"
 #include "serial_functions.h"
+#include "task_functions.h"
+#include "driver/uart.h"
 
 // Instancia del módulo APC220
 APCModule radio(Serial2, APC_SETPIN, APC_RXPIN, APC_TXPIN);
 
+// Recepción: cola de tramas y ensamblador
+BridgeQueue radioRxQueue(BRIDGE_DROP_OLDEST);
+static RadioFrameAssembler radioRxAssembler(radioRxQueue);
+static volatile uint32_t radioRxUartErrors = 0;
+
+// Transmisión: dosificada según la velocidad RF del módulo y seguida hasta
+// que sale por la línea (Serial2 es la UART 2)
+static const uart_port_t RADIO_UART_PORT = UART_NUM_2;
+RadioTxPacer radioTxPacer;
+static UartTxTracker radioTxTracker;
+static uint32_t radioTxThrottledSinceUs = 0;   // Desde cuándo espera el dosificador (0 = no espera)
+
+/**
+ * @brief Callback de recepción del APC220
+ * Se ejecuta en la tarea de eventos UART cuando la línea queda en reposo
+ * (RADIO_RX_TIMEOUT_SYMBOLS), por lo que cada llamada cierra una ráfaga.
+ */
+static void onRadioReceive() {
+  uint8_t chunk[64];
+  uint32_t nowMs = millis();
+  uint32_t nowUs = micros();
+  uint32_t frames = 0;
+
+  int available;
+  while ((available = Serial2.available()) > 0) {
+    size_t n = Serial2.read(chunk, available > (int)sizeof(chunk) ? sizeof(chunk) : available);
+    frames += radioRxAssembler.feed(chunk, n, nowMs, nowUs);
+  }
+  if (radioRxAssembler.endOfBurst()) frames++;
+
+  if (frames > 0) {
+    notifyRadioTask();
+  }
+}
+
+static void onRadioReceiveError(hardwareSerial_error_t error) {
+  (void)error;
+  radioRxUartErrors++;
+}
+
+RadioRxStats getRadioRxStats() {
+  return radioRxAssembler.getStats();
+}
+
+uint32_t getRadioRxUartErrors() {
+  return radioRxUartErrors;
+}
+
+/**
+ * @brief Configura el dosificador con los parámetros que aceptó el APC220
+ * Si el módulo no confirmó la configuración se usa RADIO_SETTINGS_STRING.
+ */
+static void configureRadioTxPacer() {
+  APCSettings settings;
+  uint32_t airBps = RADIO_UART_BAUD;
+  if (radio.getParsedSettings(settings) || APCModule::parseSettings(RADIO_SETTINGS_STRING, settings)) {
+    airBps = APCModule::rfRateBps(settings.rfRate);
+    if (APCModule::uartRateBps(settings.uartRate) != RADIO_UART_BAUD) {
+      DEBUG_PRINT("APC220: UART del módulo distinta de RADIO_UART_BAUD: ");
+      DEBUG_PRINTLN(APCModule::uartRateBps(settings.uartRate));
+    }
+  }
+  radioTxPacer.configure(airBps, RADIO_UART_BAUD, RADIO_MODULE_BUFFER_BYTES, micros());
+
+  DEBUG_PRINT("APC220 TX: RF ");
+  DEBUG_PRINT(airBps);
+  DEBUG_PRINT(" bps, buffer ");
+  DEBUG_PRINT(radioTxPacer.maxChunk());
+  DEBUG_PRINTLN(" bytes");
+}
+
+/**
+ * @brief Bytes que quedan en el driver de la UART del APC220
+ * El buffer TX se consulta al driver; la FIFO se da por llena hasta que la
+ * línea queda en reposo, así una trama nunca se da por enviada antes de tiempo.
+ */
+static uint32_t radioTxDriverPending() {
+  size_t ringFree = RADIO_TX_BUFFER_SIZE;
+  uart_get_tx_buffer_free_size(RADIO_UART_PORT, &ringFree);
+  uint32_t pending = ringFree < RADIO_TX_BUFFER_SIZE ? RADIO_TX_BUFFER_SIZE - ringFree : 0;
+  if (uart_wait_tx_done(RADIO_UART_PORT, 0) != ESP_OK) {
+    pending += UART_FIFO_LEN;
+  }
+  return pending;
+}
+
+bool radioTxSubmit(const BridgeFrame& frame, uint16_t& offset, uint8_t tag, uint32_t& waitUs) {
+  waitUs = 0;
+  if (offset == 0 && radioTxTracker.full()) {
+    waitUs = radioTxNextDoneUs();
+    return false;
+  }
+
+  while (offset < frame.len) {
+    // Las tramas que caben enteras esperan antes del primer byte, así no se
+    // parten con huecos en la UART
+    size_t chunk = frame.len - offset;
+    if (chunk > radioTxPacer.maxChunk()) chunk = radioTxPacer.maxChunk();
+    uint32_t nowUs = micros();
+    waitUs = radioTxPacer.reserve(chunk, nowUs);
+    if (waitUs > 0) {
+      if (radioTxThrottledSinceUs == 0) radioTxThrottledSinceUs = nowUs | 1;
+      return false;
+    }
+
+    // Con el buffer TX del driver, write() copia y vuelve sin esperar a la línea
+    Serial2.write(frame.data + offset, chunk);
+    radioTxTracker.wrote(chunk);
+    radioTxPacer.commit(chunk, nowUs, radioTxThrottledSinceUs ? nowUs - radioTxThrottledSinceUs : 0);
+    radioTxThrottledSinceUs = 0;
+    offset += chunk;
+  }
+  radioTxTracker.mark(frame.stampUs, frame.len, tag);
+  return true;
+}
+
+bool radioTxPoll(UartTxDone& done) {
+  return radioTxTracker.popDone(radioTxDriverPending(), done);
+}
+
+uint32_t radioTxNextDoneUs() {
+  if (radioTxTracker.getStats().inFlight == 0) return 0;
+  uint32_t bytes = radioTxTracker.bytesUntilNext(radioTxDriverPending());
+  // 8N1: 10 bits por byte; como mínimo un byte para que la línea quede en reposo
+  return (uint32_t)((uint64_t)(bytes > 0 ? bytes : 1) * 10000000 / RADIO_UART_BAUD);
+}
+
+UartTxTrackerStats getRadioTxTrackerStats() {
+  return radioTxTracker.getStats();
+}
+
 void initAPC220() {
   pinMode(APC_SETPIN, OUTPUT);
+
+  // Los buffers del driver solo pueden fijarse antes de begin()
+  Serial2.setRxBufferSize(RADIO_RX_BUFFER_SIZE);
+  Serial2.setTxBufferSize(RADIO_TX_BUFFER_SIZE);
   
   // Inicializar APC220 con baudios configurables
   radio.init(RADIO_UART_BAUD, RADIO_AIR_BAUD);
@@ -16,6 +153,12 @@ void initAPC220() {
   // Leer configuración para verificar
   String resp = radio.getSettings();
   DEBUG_PRINTLN(resp);
+  configureRadioTxPacer();
+
+  // Recepción por eventos de la UART (tras la configuración, que lee Serial2 directamente)
+  Serial2.setRxTimeout(RADIO_RX_TIMEOUT_SYMBOLS);
+  Serial2.onReceiveError(onRadioReceiveError);
+  Serial2.onReceive(onRadioReceive, true);
 }
 
 void printBootBanner() {
@@ -4,13 +4,47 @@
 #include <Arduino.h>
 #include <APCModule.h>
 #include "kroner_config.h"
+#include "bridge_queue.h"
+#include "radio_frame_assembler.h"
+#include "radio_tx_pacer.h"
+#include "uart_tx_tracker.h"
 
 // Variable global del módulo APC220
 extern APCModule radio;
 
+// Tramas recibidas por el APC220 (productor: evento UART, consumidor: tarea de radio)
+extern BridgeQueue radioRxQueue;
+
+// Dosificador de la transmisión al APC220 (solo escribe la tarea de radio)
+extern RadioTxPacer radioTxPacer;
+
 // Funciones de comunicación serial
 void initAPC220();
 
+/**
+ * @brief Entrega una trama a la UART del APC220 sin esperar a que salga
+ * Escribe lo que el dosificador permite y vuelve enseguida; solo la tarea de radio.
+ * @param offset Bytes ya entregados de la trama (se actualiza)
+ * @param tag Se devuelve en radioTxPoll() cuando la trama termina de salir
+ * @param waitUs Si no se entregó entera, µs hasta poder seguir
+ * @return true si la trama quedó entregada entera
+ */
+bool radioTxSubmit(const BridgeFrame& frame, uint16_t& offset, uint8_t tag, uint32_t& waitUs);
+
+/**
+ * @brief Recoge la trama más antigua si su último byte ya salió por la línea
+ */
+bool radioTxPoll(UartTxDone& done);
+
+// µs hasta que previsiblemente termine la trama en vuelo más antigua (0 si no hay)
+uint32_t radioTxNextDoneUs();
+
+UartTxTrackerStats getRadioTxTrackerStats();
+
+// Contadores de la recepción del APC220
+RadioRxStats getRadioRxStats();
+uint32_t getRadioRxUartErrors();
+
 // Imprime el banner de arranque con información de firmware
 void printBootBanner();
 
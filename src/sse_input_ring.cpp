@@ -0,0 +1,60 @@
+#include "sse_input_ring.h"
+
+SseInputRing::SseInputRing()
+    : head(0), tail(0), dropCount(0) {
+  memset(records, 0, sizeof(records));
+}
+
+bool SseInputRing::push(const char* text, size_t len, uint32_t time) {
+  if (len > SSE_INPUT_TEXT_MAX) len = SSE_INPUT_TEXT_MAX;
+
+  portENTER_CRITICAL(&mux);
+  bool dropped = head - tail >= CAPACITY;
+  if (dropped) {
+    tail++;
+    dropCount++;
+  }
+  SseInputRecord& record = records[head & MASK];
+  record.time = time;
+  record.len = (uint8_t)len;
+  memcpy(record.text, text, len);
+  head++;
+  portEXIT_CRITICAL(&mux);
+  return !dropped;
+}
+
+bool SseInputRing::pop(SseInputRecord& out) {
+  portENTER_CRITICAL(&mux);
+  if (head == tail) {
+    portEXIT_CRITICAL(&mux);
+    return false;
+  }
+  // Copia dentro de la sección crítica: un productor puede pisar el hueco al desbordar
+  const SseInputRecord& record = records[tail & MASK];
+  out.time = record.time;
+  out.len = record.len;
+  memcpy(out.text, record.text, record.len);
+  tail++;
+  portEXIT_CRITICAL(&mux);
+  return true;
+}
+
+void SseInputRing::clear() {
+  portENTER_CRITICAL(&mux);
+  tail = head;
+  portEXIT_CRITICAL(&mux);
+}
+
+uint32_t SseInputRing::size() {
+  portENTER_CRITICAL(&mux);
+  uint32_t depth = head - tail;
+  portEXIT_CRITICAL(&mux);
+  return depth;
+}
+
+uint32_t SseInputRing::drops() {
+  portENTER_CRITICAL(&mux);
+  uint32_t count = dropCount;
+  portEXIT_CRITICAL(&mux);
+  return count;
+}
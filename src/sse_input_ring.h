@@ -0,0 +1,76 @@
+#ifndef SSE_INPUT_RING_H
+#define SSE_INPUT_RING_H
+
+#include <Arduino.h>
+#include "kroner_config.h"
+
+static_assert((SSE_INPUT_SLOTS & (SSE_INPUT_SLOTS - 1)) == 0,
+              "SSE_INPUT_SLOTS debe ser potencia de 2");
+
+// Texto de un flanco F1-F3 en /api/stream: F1-F3 en ms (uint32) y el flanco en µs
+// (uint64), que crecen con el tiempo encendido. El caso más largo debe caber entero
+#define SSE_EDGE_TEXT_FORMAT "F1=%u,F2=%u,F3=%u,F%u@%lluus"
+#define SSE_EDGE_TEXT_LONGEST "F1=4294967295,F2=4294967295,F3=4294967295,F3@18446744073709551615us"
+static_assert(sizeof(SSE_EDGE_TEXT_LONGEST) - 1 <= SSE_INPUT_TEXT_MAX,
+              "SSE_INPUT_TEXT_MAX no cabe el flanco F1-F3 más largo");
+
+// Evento de entrada pendiente de enviar por /api/stream
+struct SseInputRecord {
+  uint32_t time;                    // millis() del evento
+  uint8_t len;                      // Bytes válidos en text
+  char text[SSE_INPUT_TEXT_MAX];
+};
+
+/**
+ * @brief Anillo fijo de eventos de entrada para el stream SSE
+ *
+ * Varios productores (tarea de entradas y tarea BLE, con las entradas
+ * simuladas) y un consumidor (la tarea web). Cada registro ocupa
+ * SSE_INPUT_TEXT_MAX bytes de texto, no una trama completa del puente, y la
+ * sección crítica solo copia un registro. Si está lleno se descarta el evento
+ * más antiguo: al monitor le interesan los últimos.
+ */
+class SseInputRing {
+public:
+  static const uint32_t CAPACITY = SSE_INPUT_SLOTS;
+
+  SseInputRing();
+
+  /**
+   * @brief Encola un evento (cualquier tarea, no desde ISR)
+   * @param text Texto del evento; se trunca a SSE_INPUT_TEXT_MAX bytes
+   * @param len Longitud del texto
+   * @param time millis() del evento
+   * @return false si se descartó el evento más antiguo para hacer sitio
+   */
+  bool push(const char* text, size_t len, uint32_t time);
+
+  /**
+   * @brief Extrae el evento más antiguo (solo desde el consumidor)
+   * @return false si no hay eventos
+   */
+  bool pop(SseInputRecord& out);
+
+  /**
+   * @brief Descarta todos los eventos pendientes
+   */
+  void clear();
+
+  uint32_t size();
+
+  /**
+   * @brief Eventos descartados por anillo lleno
+   */
+  uint32_t drops();
+
+private:
+  static const uint32_t MASK = CAPACITY - 1;
+
+  SseInputRecord records[CAPACITY];
+  uint32_t head;                    // Contadores que solo crecen: head - tail = pendientes
+  uint32_t tail;
+  uint32_t dropCount;
+  portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif
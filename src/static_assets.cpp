@@ -0,0 +1,314 @@
+#include "kroner_config.h"
+#include "static_assets.h"
+
+// Tabla de tipos MIME para los ficheros de data/
+struct MimeEntry {
+  const char* extension;
+  const char* contentType;
+};
+
+static const MimeEntry MIME_TYPES[] = {
+  {".html", "text/html"},
+  {".htm", "text/html"},
+  {".css", "text/css"},
+  {".js", "application/javascript"},
+  {".json", "application/json"},
+  {".txt", "text/plain"},
+  {".png", "image/png"},
+  {".jpg", "image/jpeg"},
+  {".jpeg", "image/jpeg"},
+  {".gif", "image/gif"},
+  {".ico", "image/x-icon"},
+  {".svg", "image/svg+xml"},
+  {".webp", "image/webp"},
+  {".woff", "font/woff"},
+  {".woff2", "font/woff2"},
+};
+
+// Caché de ETags: evita releer el fichero para recalcular el hash
+struct EtagEntry {
+  String path;
+  size_t size;
+  time_t mtime;
+  char etag[24];
+};
+
+static const int ETAG_CACHE_SIZE = 8;
+static EtagEntry etagCache[ETAG_CACHE_SIZE];
+static int etagNext = 0;
+
+// Caché en RAM de ficheros pequeños y frecuentes (p.ej. index.html)
+struct HotFileEntry {
+  String uriPath;           // Ruta pedida
+  bool acceptsGzip;         // Clave: la variante depende de Accept-Encoding
+  String path;              // Fichero servido
+  bool gzip;
+  size_t size;
+  time_t mtime;
+  uint32_t checkedAt;       // millis() de la última comprobación contra LittleFS
+  uint32_t lastUse;
+  uint8_t refs;             // Respuestas en curso que leen data
+  bool stale;               // Invalidada; se libera al terminar la última respuesta
+  uint8_t* data;
+  char etag[24];
+};
+
+static const int HOT_CACHE_ENTRIES = 8;
+static HotFileEntry hotCache[HOT_CACHE_ENTRIES];
+static size_t hotCacheBytes = 0;
+static StaticCacheStats hotStats = {0, 0, 0, 0, 0};
+
+const char* getContentType(const String& path) {
+  for (size_t i = 0; i < sizeof(MIME_TYPES) / sizeof(MIME_TYPES[0]); i++) {
+    if (path.endsWith(MIME_TYPES[i].extension)) {
+      return MIME_TYPES[i].contentType;
+    }
+  }
+  return "application/octet-stream";
+}
+
+static uint32_t fnv1a(uint32_t hash, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static void formatEtag(uint32_t hash, size_t size, char* out, size_t cap) {
+  snprintf(out, cap, "\"%08x-%x\"", (unsigned)hash, (unsigned)size);
+}
+
+/**
+ * @brief ETag fuerte "<fnv1a32>-<tamaño>" del contenido del fichero
+ */
+static void computeEtag(File& file, char* out, size_t cap) {
+  uint32_t hash = 2166136261u;
+  uint8_t buffer[512];
+  size_t n;
+  while ((n = file.read(buffer, sizeof(buffer))) > 0) {
+    hash = fnv1a(hash, buffer, n);
+  }
+  formatEtag(hash, file.size(), out, cap);
+}
+
+static void lookupEtag(const String& path, File& file, char* out, size_t cap) {
+  size_t size = file.size();
+  time_t mtime = file.getLastWrite();
+
+  for (int i = 0; i < ETAG_CACHE_SIZE; i++) {
+    EtagEntry& e = etagCache[i];
+    if (e.path == path && e.size == size && e.mtime == mtime) {
+      strlcpy(out, e.etag, cap);
+      return;
+    }
+  }
+
+  computeEtag(file, out, cap);
+
+  EtagEntry& e = etagCache[etagNext];
+  etagNext = (etagNext + 1) % ETAG_CACHE_SIZE;
+  e.path = path;
+  e.size = size;
+  e.mtime = mtime;
+  strlcpy(e.etag, out, sizeof(e.etag));
+}
+
+// =============================
+// Caché en RAM
+// =============================
+static void freeHotEntry(HotFileEntry& e) {
+  if (e.data != nullptr) {
+    hotCacheBytes -= e.size;
+    free(e.data);
+    e.data = nullptr;
+  }
+  e.uriPath = "";
+  e.path = "";
+  e.stale = false;
+}
+
+// Saca la entrada de la caché sin liberar un buffer que aún se está enviando
+static void dropHotEntry(HotFileEntry& e) {
+  if (e.refs > 0) {
+    e.stale = true;
+    e.uriPath = "";
+  } else {
+    freeHotEntry(e);
+  }
+}
+
+static HotFileEntry* findHotEntry(const String& uriPath, bool acceptsGzip) {
+  for (int i = 0; i < HOT_CACHE_ENTRIES; i++) {
+    HotFileEntry& e = hotCache[i];
+    if (e.data != nullptr && !e.stale && e.acceptsGzip == acceptsGzip && e.uriPath == uriPath) {
+      return &e;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Comprueba (como mucho cada STATIC_CACHE_REVALIDATE_MS) que el fichero no cambió
+ */
+static bool hotEntryFresh(HotFileEntry& e) {
+  uint32_t now = millis();
+  if (now - e.checkedAt < STATIC_CACHE_REVALIDATE_MS) {
+    return true;
+  }
+  File file = LittleFS.open(e.path, "r");
+  bool fresh = file && file.size() == e.size && file.getLastWrite() == e.mtime;
+  if (file) file.close();
+  if (fresh) {
+    e.checkedAt = now;
+  } else {
+    dropHotEntry(e);
+  }
+  return fresh;
+}
+
+/**
+ * @brief Hace sitio para `size` bytes expulsando las entradas menos usadas
+ * @return Entrada libre, o nullptr si no cabe
+ */
+static HotFileEntry* reserveHotEntry(size_t size) {
+  if (size > STATIC_CACHE_MAX_FILE || size > STATIC_CACHE_MAX_BYTES) {
+    return nullptr;
+  }
+  for (;;) {
+    HotFileEntry* freeSlot = nullptr;
+    HotFileEntry* oldest = nullptr;
+    for (int i = 0; i < HOT_CACHE_ENTRIES; i++) {
+      HotFileEntry& e = hotCache[i];
+      if (e.data == nullptr) {
+        if (freeSlot == nullptr) freeSlot = &e;
+      } else if (e.refs > 0 || e.stale) {
+        continue;
+      } else if (oldest == nullptr || (int32_t)(e.lastUse - oldest->lastUse) < 0) {
+        oldest = &e;
+      }
+    }
+    if (freeSlot != nullptr && hotCacheBytes + size <= STATIC_CACHE_MAX_BYTES) {
+      return freeSlot;
+    }
+    if (oldest == nullptr) {
+      return nullptr;
+    }
+    freeHotEntry(*oldest);
+    hotStats.evictions++;
+  }
+}
+
+/**
+ * @brief Carga el fichero ya abierto en la caché, calculando su ETag
+ */
+static HotFileEntry* loadHotEntry(const String& uriPath, bool acceptsGzip, const StaticAsset& asset, File& file) {
+  HotFileEntry* e = reserveHotEntry(asset.size);
+  if (e == nullptr) return nullptr;
+
+  uint8_t* data = (uint8_t*)malloc(asset.size > 0 ? asset.size : 1);
+  if (data == nullptr) return nullptr;
+
+  file.seek(0);
+  if (file.read(data, asset.size) != asset.size) {
+    free(data);
+    return nullptr;
+  }
+
+  e->uriPath = uriPath;
+  e->acceptsGzip = acceptsGzip;
+  e->path = asset.path;
+  e->gzip = asset.gzip;
+  e->size = asset.size;
+  e->mtime = file.getLastWrite();
+  e->checkedAt = millis();
+  e->lastUse = e->checkedAt;
+  e->data = data;
+  formatEtag(fnv1a(2166136261u, data, asset.size), asset.size, e->etag, sizeof(e->etag));
+  hotCacheBytes += asset.size;
+  return e;
+}
+
+static void fillFromHotEntry(HotFileEntry& e, StaticAsset& asset) {
+  asset.path = e.path;
+  asset.gzip = e.gzip;
+  asset.size = e.size;
+  asset.data = e.data;
+  asset.cacheSlot = (int8_t)(&e - hotCache);
+  e.refs++;
+  strlcpy(asset.etag, e.etag, sizeof(asset.etag));
+}
+
+bool resolveStaticAsset(const String& uriPath, bool acceptsGzip, StaticAsset& asset) {
+  asset.contentType = getContentType(uriPath);
+  // HTML siempre se revalida (cambia con cada uploadfs); el resto se cachea
+  asset.cacheControl = strcmp(asset.contentType, "text/html") == 0
+                           ? STATIC_CACHE_CONTROL_HTML
+                           : STATIC_CACHE_CONTROL_ASSETS;
+  asset.data = nullptr;
+  asset.cacheSlot = -1;
+
+  // Acierto en RAM: sin tocar LittleFS
+  HotFileEntry* hot = findHotEntry(uriPath, acceptsGzip);
+  if (hot != nullptr && hotEntryFresh(*hot)) {
+    hot->lastUse = millis();
+    hotStats.hits++;
+    fillFromHotEntry(*hot, asset);
+    return true;
+  }
+  hotStats.misses++;
+
+  String gzPath = uriPath + ".gz";
+  if (acceptsGzip && LittleFS.exists(gzPath)) {
+    asset.path = gzPath;
+    asset.gzip = true;
+  } else if (LittleFS.exists(uriPath)) {
+    asset.path = uriPath;
+    asset.gzip = false;
+  } else {
+    return false;
+  }
+
+  File file = LittleFS.open(asset.path, "r");
+  if (!file || file.isDirectory()) {
+    return false;
+  }
+  asset.size = file.size();
+
+  // Ficheros pequeños: a la caché en RAM (el ETag se calcula sobre el buffer)
+  hot = loadHotEntry(uriPath, acceptsGzip, asset, file);
+  if (hot != nullptr) {
+    fillFromHotEntry(*hot, asset);
+  } else {
+    lookupEtag(asset.path, file, asset.etag, sizeof(asset.etag));
+  }
+  file.close();
+  return true;
+}
+
+void releaseStaticAsset(StaticAsset& asset) {
+  if (asset.cacheSlot < 0 || asset.cacheSlot >= HOT_CACHE_ENTRIES) return;
+  HotFileEntry& e = hotCache[asset.cacheSlot];
+  if (e.refs > 0) e.refs--;
+  if (e.stale && e.refs == 0) {
+    freeHotEntry(e);
+  }
+  asset.cacheSlot = -1;
+  asset.data = nullptr;
+}
+
+void preloadStaticAsset(const String& uriPath) {
+  StaticAsset asset;
+  if (resolveStaticAsset(uriPath, true, asset)) releaseStaticAsset(asset);
+  if (resolveStaticAsset(uriPath, false, asset)) releaseStaticAsset(asset);
+}
+
+void recordStaticCacheServed(size_t bytes) {
+  hotStats.bytesServed += bytes;
+}
+
+StaticCacheStats getStaticCacheStats() {
+  StaticCacheStats stats = hotStats;
+  stats.bytesUsed = hotCacheBytes;
+  return stats;
+}
@@ -0,0 +1,70 @@
+#ifndef STATIC_ASSETS_H
+#define STATIC_ASSETS_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// Fichero estático resuelto para una petición
+struct StaticAsset {
+  String path;              // Fichero a servir (puede ser la variante .gz)
+  const char* contentType;  // MIME del fichero original
+  const char* cacheControl;
+  bool gzip;                // Se sirve la variante precomprimida
+  size_t size;
+  const uint8_t* data;      // Contenido en la caché en RAM, o nullptr si hay que leer LittleFS
+  int8_t cacheSlot;         // Entrada de la caché retenida (ver releaseStaticAsset), -1 si ninguna
+  char etag[24];            // ETag fuerte, con comillas
+};
+
+// Contadores de la caché de ficheros en RAM
+struct StaticCacheStats {
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint64_t bytesServed;     // Bytes enviados desde RAM
+  uint32_t bytesUsed;       // Bytes ocupados por la caché
+};
+
+/**
+ * @brief Tipo MIME según la extensión (application/octet-stream si no se conoce)
+ */
+const char* getContentType(const String& path);
+
+/**
+ * @brief Resuelve qué fichero de LittleFS servir para una ruta
+ * Si el cliente acepta gzip y existe "<ruta>.gz", se elige esa variante.
+ * El ETag se calcula sobre el contenido servido y se guarda mientras no
+ * cambien el tamaño ni la fecha del fichero. Los ficheros de hasta
+ * STATIC_CACHE_MAX_FILE bytes se guardan en RAM (asset.data) y se
+ * comprueban contra LittleFS como mucho cada STATIC_CACHE_REVALIDATE_MS.
+ * Solo debe llamarse desde la tarea del servidor HTTP (async_tcp). Si
+ * asset.data no es nulo, el buffer queda retenido hasta releaseStaticAsset().
+ * @param uriPath Ruta pedida (p.ej. "/index.html")
+ * @param acceptsGzip El cliente envió Accept-Encoding: gzip
+ * @param asset Resultado
+ * @return true si el fichero existe
+ */
+bool resolveStaticAsset(const String& uriPath, bool acceptsGzip, StaticAsset& asset);
+
+/**
+ * @brief Suelta la entrada de la caché retenida por resolveStaticAsset()
+ * Llamar cuando la respuesta termina de enviarse (o se aborta)
+ */
+void releaseStaticAsset(StaticAsset& asset);
+
+/**
+ * @brief Carga en la caché las variantes de un fichero (llamar al arrancar)
+ */
+void preloadStaticAsset(const String& uriPath);
+
+/**
+ * @brief Contabiliza bytes enviados desde la caché en RAM
+ */
+void recordStaticCacheServed(size_t bytes);
+
+/**
+ * @brief Copia los contadores de la caché en RAM
+ */
+StaticCacheStats getStaticCacheStats();
+
+#endif
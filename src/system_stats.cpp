@@ -0,0 +1,188 @@
+#include "system_stats.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ble_functions.h"
+#include "webserver_functions.h"
+#include "serial_functions.h"
+#include "ws_fanout.h"
+
+// Tareas registradas y su runtime en la muestra anterior
+struct TrackedTask {
+  TaskHandle_t handle;
+  const char* name;
+  uint8_t core;
+  uint32_t lastRunTime;
+};
+
+static TrackedTask tracked[SYSTEM_STATS_TASKS];
+static uint8_t trackedCount = 0;
+
+static SystemStats snapshot;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Reservas de heap por tarea registrada (cada contador solo lo incrementa su tarea)
+static volatile uint32_t taskAllocs[SYSTEM_STATS_TASKS];
+
+#ifdef SYSTEM_STATS_COUNT_ALLOCS
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static inline void countAlloc() {
+  if (xPortInIsrContext() || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return;
+  TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0; i < trackedCount; i++) {
+    if (tracked[i].handle == current) {
+      taskAllocs[i]++;
+      return;
+    }
+  }
+}
+
+void* __wrap_malloc(size_t size) {
+  countAlloc();
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  countAlloc();
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  countAlloc();
+  return __real_realloc(ptr, size);
+}
+}
+#endif
+
+#if (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+#define SYSTEM_STATS_RUNTIME 1
+static const int MAX_SYSTEM_TASKS = 32;
+static TaskStatus_t taskStatus[MAX_SYSTEM_TASKS];
+static uint32_t lastTotalRunTime = 0;
+static uint32_t lastIdleRunTime[2] = {0, 0};
+#endif
+
+static uint8_t percentOf(uint32_t part, uint32_t total) {
+  if (total == 0) return 0;
+  uint32_t pct = (uint32_t)(((uint64_t)part * 100) / total);
+  return pct > 100 ? 100 : (uint8_t)pct;
+}
+
+void systemStatsRegisterTask(TaskHandle_t handle, const char* name, uint8_t core) {
+  if (handle == nullptr || trackedCount >= SYSTEM_STATS_TASKS) return;
+  tracked[trackedCount].handle = handle;
+  tracked[trackedCount].name = name;
+  tracked[trackedCount].core = core;
+  tracked[trackedCount].lastRunTime = 0;
+  trackedCount++;
+}
+
+void systemStatsSample() {
+  uint32_t start = micros();
+  SystemStats s;
+  memset(&s, 0, sizeof(s));
+
+  s.uptimeMs = millis();
+  s.heapFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  s.heapMin = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  s.heapLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  s.heapFragPercent = s.heapFree ? 100 - percentOf(s.heapLargest, s.heapFree) : 0;
+#ifdef SYSTEM_STATS_COUNT_ALLOCS
+  s.allocsCounted = true;
+#endif
+  s.bleQueueDepth = (uint8_t)bleBridgeQueue.size();
+  s.webQueueDepth = (uint8_t)webBridgeQueue.size();
+  s.radioRxDepth = (uint8_t)radioRxQueue.size();
+  s.wsPoolFree = (uint8_t)wsFanoutPoolFree();
+  s.idlePercent[0] = 0xFF;
+  s.idlePercent[1] = 0xFF;
+
+  s.taskCount = trackedCount;
+  for (uint8_t i = 0; i < trackedCount; i++) {
+    s.tasks[i].name = tracked[i].name;
+    s.tasks[i].core = tracked[i].core;
+    s.tasks[i].cpuPercent = 0xFF;
+    // En ESP-IDF la marca de agua ya viene en bytes
+    s.tasks[i].stackFree = (uint16_t)uxTaskGetStackHighWaterMark(tracked[i].handle);
+    s.tasks[i].allocs = taskAllocs[i];
+  }
+
+#ifdef SYSTEM_STATS_RUNTIME
+  // Una sola pasada por la lista de tareas; el planificador se suspende
+  // solo mientras se copia, las interrupciones siguen activas
+  uint32_t totalRunTime = 0;
+  UBaseType_t count = uxTaskGetSystemState(taskStatus, MAX_SYSTEM_TASKS, &totalRunTime);
+  uint32_t elapsed = totalRunTime - lastTotalRunTime;
+
+  for (UBaseType_t n = 0; n < count; n++) {
+    const TaskStatus_t& status = taskStatus[n];
+    for (int core = 0; core < 2; core++) {
+      if (status.xHandle == xTaskGetIdleTaskHandleForCPU(core)) {
+        s.idlePercent[core] = percentOf(status.ulRunTimeCounter - lastIdleRunTime[core], elapsed);
+        lastIdleRunTime[core] = status.ulRunTimeCounter;
+      }
+    }
+    for (uint8_t i = 0; i < trackedCount; i++) {
+      if (status.xHandle == tracked[i].handle) {
+        s.tasks[i].cpuPercent = percentOf(status.ulRunTimeCounter - tracked[i].lastRunTime, elapsed);
+        tracked[i].lastRunTime = status.ulRunTimeCounter;
+      }
+    }
+  }
+  lastTotalRunTime = totalRunTime;
+#endif
+
+  s.sampleUs = micros() - start;
+
+  portENTER_CRITICAL(&statsMux);
+  snapshot = s;
+  portEXIT_CRITICAL(&statsMux);
+}
+
+SystemStats getSystemStats() {
+  SystemStats copy;
+  portENTER_CRITICAL(&statsMux);
+  copy = snapshot;
+  portEXIT_CRITICAL(&statsMux);
+  return copy;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+  return p + 4;
+}
+
+size_t packSystemStats(const SystemStats& stats, uint8_t* out, size_t cap) {
+  if (cap < SYSTEM_STATS_BIN_LEN) return 0;
+  uint8_t* p = out;
+  *p++ = SYSTEM_STATS_VERSION;
+  *p++ = SYSTEM_STATS_TASKS;
+  *p++ = stats.idlePercent[0];
+  *p++ = stats.idlePercent[1];
+  p = putU32(p, stats.uptimeMs);
+  p = putU32(p, stats.heapFree);
+  p = putU32(p, stats.heapMin);
+  p = putU32(p, stats.heapLargest);
+  *p++ = stats.bleQueueDepth;
+  *p++ = stats.webQueueDepth;
+  *p++ = stats.radioRxDepth;
+  *p++ = stats.wsPoolFree;
+  // Huecos de tareas no registradas a cero, para que el tamaño sea fijo
+  for (uint8_t i = 0; i < SYSTEM_STATS_TASKS; i++) {
+    const TaskSample& t = stats.tasks[i];
+    bool used = i < stats.taskCount;
+    *p++ = used ? t.cpuPercent : 0;
+    *p++ = used ? t.core : 0;
+    uint16_t stack = used ? t.stackFree : 0;
+    *p++ = (uint8_t)stack;
+    *p++ = (uint8_t)(stack >> 8);
+  }
+  return (size_t)(p - out);
+}
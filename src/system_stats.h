@@ -0,0 +1,77 @@
+#ifndef SYSTEM_STATS_H
+#define SYSTEM_STATS_H
+
+#include <Arduino.h>
+#include "kroner_config.h"
+
+// Tareas del sistema que se miden, en el orden de startSystemTasks()
+#define SYSTEM_STATS_TASKS 5
+
+// Muestra de una tarea
+struct TaskSample {
+  const char* name;
+  uint8_t core;
+  uint8_t cpuPercent;        // Desde la muestra anterior (0xFF = sin contadores de runtime)
+  uint16_t stackFree;        // Mínimo de pila libre desde el arranque (bytes)
+  uint32_t allocs;           // malloc/calloc/realloc hechos por la tarea desde el arranque
+};
+
+// Instantánea del sistema
+struct SystemStats {
+  uint32_t uptimeMs;
+  uint32_t sampleUs;         // Coste de la última muestra
+  uint8_t idlePercent[2];    // Tiempo de la tarea IDLE de cada núcleo (0xFF = desconocido)
+  uint32_t heapFree;
+  uint32_t heapMin;          // Mínimo de heap libre desde el arranque
+  uint32_t heapLargest;      // Mayor bloque reservable
+  uint8_t heapFragPercent;   // 100 - mayor bloque / libre (0 = sin fragmentar)
+  bool allocsCounted;        // false si el firmware se enlazó sin SYSTEM_STATS_COUNT_ALLOCS
+  uint8_t bleQueueDepth;     // Tramas en bleBridgeQueue
+  uint8_t webQueueDepth;     // Tramas en webBridgeQueue
+  uint8_t radioRxDepth;      // Tramas en radioRxQueue
+  uint8_t wsPoolFree;        // Tramas libres del pool WebSocket
+  uint8_t taskCount;
+  TaskSample tasks[SYSTEM_STATS_TASKS];
+};
+
+// Formato binario para BLE, little-endian:
+//   [0] versión  [1] nº de tareas  [2] idle núcleo 0 (%)  [3] idle núcleo 1 (%)
+//   [4..7] uptime (ms)  [8..11] heap libre  [12..15] heap mínimo  [16..19] mayor bloque
+//   [20] cola BLE  [21] cola HTTP  [22] cola RX radio  [23] pool WebSocket libre
+//   por tarea: [cpu %] [núcleo] [pila libre uint16]
+#define SYSTEM_STATS_VERSION 1
+#define SYSTEM_STATS_HEADER_LEN 24
+#define SYSTEM_STATS_BIN_LEN (SYSTEM_STATS_HEADER_LEN + SYSTEM_STATS_TASKS * 4)
+
+/**
+ * @brief Registra una tarea para medirla (llamar tras crearla)
+ *
+ * Con SYSTEM_STATS_COUNT_ALLOCS (y malloc/calloc/realloc envueltos con
+ * -Wl,--wrap, ver platformio.ini) también se cuentan sus reservas de heap:
+ * una tarea que no reserva en régimen permanente debe mantener el contador fijo.
+ */
+void systemStatsRegisterTask(TaskHandle_t handle, const char* name, uint8_t core);
+
+/**
+ * @brief Toma una muestra (una vez por segundo, desde la tarea de estadísticas)
+ *
+ * Usa los contadores de runtime de FreeRTOS si el framework los incluye
+ * (configGENERATE_RUN_TIME_STATS); si no, los porcentajes quedan a 0xFF.
+ */
+void systemStatsSample();
+
+/**
+ * @brief Copia la última instantánea
+ * Seguro desde cualquier tarea.
+ */
+SystemStats getSystemStats();
+
+/**
+ * @brief Empaqueta una instantánea para la característica BLE
+ * @param out Destino (al menos SYSTEM_STATS_BIN_LEN bytes)
+ * @param cap Tamaño del destino
+ * @return Bytes escritos, 0 si no cabe
+ */
+size_t packSystemStats(const SystemStats& stats, uint8_t* out, size_t cap);
+
+#endif
@@ -4,6 +4,13 @@
 #include "webserver_functions.h"
 #include "input_functions.h"
 #include "serial_functions.h"
+#include "ws_fanout.h"
+#include "event_stream.h"
+#include "sse_input_ring.h"
+#include "system_stats.h"
+#include "task_scheduler.h"
+#include "load_generator.h"
+#include "radio_tx_staging.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -12,67 +19,137 @@ static volatile bool bleConnected = false;
 static volatile unsigned long bleConnectionTime = 0;
 
 // Intervalos de tareas (ticks)
-static constexpr TickType_t WEB_SERVER_DELAY = pdMS_TO_TICKS(50);   // 20 Hz
-static constexpr TickType_t BLE_DELAY = pdMS_TO_TICKS(20);          // 50 Hz
-static constexpr TickType_t INPUT_DELAY = pdMS_TO_TICKS(10);        // 100 Hz para keypad
-static constexpr TickType_t RADIO_DELAY = pdMS_TO_TICKS(200);       // 5 Hz
-static constexpr TickType_t DEBUG_DELAY = pdMS_TO_TICKS(5000);      // 0.2 Hz
+static constexpr TickType_t INPUT_DELAY = pdMS_TO_TICKS(10);        // 100 Hz mientras hay actividad
+static constexpr unsigned long STATS_INTERVAL_MS = 1000;            // 1 Hz
+static constexpr unsigned long DEBUG_INTERVAL_MS = 5000;            // 0.2 Hz
 
 // Handles de tareas FreeRTOS
 static TaskHandle_t webServerTaskHandle = nullptr;
 static TaskHandle_t bleTaskHandle = nullptr;
 static TaskHandle_t inputTaskHandle = nullptr;
 static TaskHandle_t radioTaskHandle = nullptr;
-static TaskHandle_t debugTaskHandle = nullptr;
+static TaskHandle_t statsTaskHandle = nullptr;
+
+// Trabajos de baja frecuencia: comparten la tarea Stats en lugar de tener
+// cada uno su tarea FreeRTOS y su pila
+static TaskScheduler lowRateJobs;
+
+// Flancos perdidos por cola llena ya reflejados en la secuencia binaria del pulsador
+static uint32_t reportedEdgeOverflows = 0;
+
+// Bytes descartados en bleBridgeQueue ya devueltos a los créditos (solo la tarea de radio)
+static uint32_t reportedDroppedBytes = 0;
 
 // Declaraciones de tareas FreeRTOS
 static void webServerTask(void* pvParameters);
 static void bleTask(void* pvParameters);
 static void inputTask(void* pvParameters);
 static void radioTask(void* pvParameters);
-static void debugTask(void* pvParameters);
+static void statsTask(void* pvParameters);
+
+static void sendInputEvents();
+static void refreshBleSummaries();
 
 void startSystemTasks() {
   // Núcleo 0: WiFi/Red y radio para convivir con tareas del stack WiFi
-  xTaskCreatePinnedToCore(webServerTask, "WebServer", 4096, nullptr, 2, &webServerTaskHandle, 0);
+  xTaskCreatePinnedToCore(webServerTask, "WebServer", 6144, nullptr, 2, &webServerTaskHandle, 0);
   xTaskCreatePinnedToCore(radioTask, "Radio", 4096, nullptr, 2, &radioTaskHandle, 0);
 
-  // Núcleo 1: BLE, entradas y debug ligero
+  // Núcleo 1: BLE, entradas y estadísticas
   xTaskCreatePinnedToCore(bleTask, "BLE", 4096, nullptr, 3, &bleTaskHandle, 1);
   xTaskCreatePinnedToCore(inputTask, "Inputs", 4096, nullptr, 3, &inputTaskHandle, 1);
-  xTaskCreatePinnedToCore(debugTask, "Debug", 3072, nullptr, 1, &debugTaskHandle, 1);
+  xTaskCreatePinnedToCore(statsTask, "Stats", 4096, nullptr, 1, &statsTaskHandle, 1);
+
+  // Mismo orden que documenta SYSTEM_STATS_BIN_LEN
+  systemStatsRegisterTask(webServerTaskHandle, "WebServer", 0);
+  systemStatsRegisterTask(radioTaskHandle, "Radio", 0);
+  systemStatsRegisterTask(bleTaskHandle, "BLE", 1);
+  systemStatsRegisterTask(inputTaskHandle, "Inputs", 1);
+  systemStatsRegisterTask(statsTaskHandle, "Stats", 1);
 }
 
 /**
- * @brief Tarea: Maneja las peticiones HTTP y DNS
- * Intervalo: 50ms
+ * @brief Despierta a la tarea de radio
+ * Los productores del puente (BLE y /api/send) la llaman tras encolar
  */
-void taskHandleWebServer() {
-  webServer.handleClient();
-  dnsServer.processNextRequest();
-  webSocket.loop();  // Procesar eventos WebSocket
+void notifyRadioTask() {
+  if (radioTaskHandle != nullptr) {
+    xTaskNotifyGive(radioTaskHandle);
+  }
 }
 
 /**
- * @brief Tarea: Maneja la conexión BLE
- * Intervalo: 100ms
+ * @brief Despierta a la tarea web para que envíe las colas WebSocket
  */
-void taskHandleBLE() {
-  // Mantener la pila BLE viva
-  BLE.poll();
+void notifyWebServerTask() {
+  if (webServerTaskHandle != nullptr) {
+    xTaskNotifyGive(webServerTaskHandle);
+  }
+}
 
-  BLEDevice central = BLE.central();
-  
-  if (central) {
+/**
+ * @brief Despierta a la tarea BLE (callbacks de conexión de NimBLE)
+ */
+void notifyBleTask() {
+  if (bleTaskHandle != nullptr) {
+    xTaskNotifyGive(bleTaskHandle);
+  }
+}
+
+/**
+ * @brief Despierta a la tarea de entradas (desde otra tarea)
+ */
+void notifyInputTask() {
+  if (inputTaskHandle != nullptr) {
+    xTaskNotifyGive(inputTaskHandle);
+  }
+}
+
+/**
+ * @brief Despierta a la tarea de entradas desde una interrupción
+ */
+void IRAM_ATTR notifyInputTaskFromISR() {
+  if (inputTaskHandle == nullptr) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(inputTaskHandle, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+/**
+ * @brief Tarea: Maneja las colas WebSocket y las esperas de /api/messages y /api/stream
+ * HTTP, DNS y los eventos WebSocket los atienden async_tcp y AsyncUDP, al llegar los datos.
+ * Se ejecuta al notificarla (tramas nuevas, long-poll o cliente SSE nuevo) y, si no,
+ * solo cuando vence un plazo: reintento de un cliente WebSocket sin hueco
+ * (WS_BUSY_RETRY_MS), fin de un long-poll o heartbeat SSE.
+ * @return ms hasta volver a llamarla (UINT32_MAX = al notificarla)
+ */
+uint32_t taskHandleWebServer() {
+  uint32_t waitMs = wsFanoutService(); // Pasar las colas de cada cliente WebSocket a AsyncWebSocket
+  uint32_t longPollMs = serviceLongPolls(); // Responder /api/messages?since= en espera
+  uint32_t streamMs = eventStreamService(); // Tramas y entradas a /api/stream (SSE)
+  if (longPollMs < waitMs) waitMs = longPollMs;
+  if (streamMs < waitMs) waitMs = streamMs;
+  return waitMs;
+}
+
+/**
+ * @brief Tarea: Atiende los cambios de conexión BLE y refresca los resúmenes
+ * NimBLE entrega escrituras y conexiones por callbacks en su propia tarea: aquí
+ * no se sondea la pila, solo se actúa cuando los callbacks despiertan a la tarea
+ * o vence el refresco de resúmenes.
+ */
+void taskHandleBLE() {
+  if (bleIsConnected()) {
     // Hay un cliente BLE conectado
     if (!bleConnected) {
       // Acaba de conectarse
       bleConnected = true;
+      updateLatencyCharacteristic();
+      updateSystemStatsCharacteristic();
       bleConnectionTime = millis();
-      
-      DEBUG_PRINT("BLE Connected: ");
-      DEBUG_PRINTLN(central.address());
-      
+
       // Enviar información de firmware
       sendFirmwareInfo();
       delay(200);
@@ -88,13 +165,14 @@ void taskHandleBLE() {
     if (bleConnected) {
       DEBUG_PRINTLN("BLE Disconnected");
       bleConnected = false;
+      setPulsadorFormat(false, 0);
     }
   }
 }
 
 /**
  * @brief Tarea: Escanea entradas (keypad, switches, interrupts)
- * Intervalo: ~10ms
+ * Intervalo: ~10ms mientras hay actividad; en reposo duerme hasta una interrupción
  */
 void taskScanInputs() {
   // Keypad siempre se escanea
@@ -105,61 +183,239 @@ void taskScanInputs() {
     scanSwitch(0, INPUT7PIN);
     scanSwitch(1, INPUT8PIN);
     scanSwitch(2, INPUT9PIN);
+  }
 
-    // Enviar valores de F1, F2, F3 si hay cambios
-    if (newInputValue) {
-      uint32_t message[4] = {F1, F2, F3, 0};
-      
-      DEBUG_PRINT("Inputs: F1=");
-      DEBUG_PRINT(F1);
-      DEBUG_PRINT(" F2=");
-      DEBUG_PRINT(F2);
-      DEBUG_PRINT(" F3=");
-      DEBUG_PRINTLN(F3);
-
-      pulsadorCharacteristic.writeValue((uint8_t*)message, sizeof(message));
-      newInputValue = false;
+  // Flancos F1-F3 y, en binario, el lote con los eventos de este barrido
+  sendInputEvents();
+}
+
+/**
+ * @brief Envía los flancos F1-F3 pendientes, en orden
+ * En el formato anterior cada flanco es una notificación; en binario se suman
+ * al lote con los eventos de teclado y switches del barrido y salen juntos.
+ * Sin BLE se vacía igualmente la cola (los flancos siguen llegando a /api/stream)
+ */
+static void sendInputEvents() {
+  const bool binary = pulsadorBinaryEnabled();
+
+  // Los flancos perdidos por cola llena consumen secuencia: el cliente ve el hueco
+  uint32_t overflows = inputEdges.getStats().overflows;
+  if (binary) {
+    pulsadorEvents.skip(overflows - reportedEdgeOverflows);
+  }
+  reportedEdgeOverflows = overflows;
+
+  uint32_t batchedUs[INPUT_EVENT_QUEUE_SLOTS];   // Para medir la latencia tras notificar
+  uint32_t popped;
+  do {
+    uint32_t batched = 0;
+    popped = 0;
+    InputEvent event;
+    while (popped < INPUT_EVENT_QUEUE_SLOTS && inputEdges.pop(event)) {
+      popped++;
+      noteInputEdge(event);
+
+      DEBUG_PRINT("Input F");
+      DEBUG_PRINT(event.channel + 1);
+      DEBUG_PRINT(" @ ");
+      DEBUG_PRINT((uint32_t)event.timeUs);
+      DEBUG_PRINTLN(" us");
+
+      if (binary) {
+        if (pulsadorEvents.append(PULSADOR_EVENT_F1 + event.channel, 0, event.timeUs)) {
+          batchedUs[batched++] = (uint32_t)event.timeUs;
+        }
+      } else if (bleConnected) {
+        uint8_t packed[INPUT_EVENT_BLE_LEN];
+        size_t len = packInputEvent(event, packed);
+        notifyPulsador(packed, len);
+        inputLatency.record(micros() - (uint32_t)event.timeUs);
+      }
+
+      char text[SSE_INPUT_TEXT_MAX + 1];
+      snprintf(text, sizeof(text), SSE_EDGE_TEXT_FORMAT, (unsigned)F1, (unsigned)F2, (unsigned)F3,
+               (unsigned)event.channel + 1, (unsigned long long)event.timeUs);
+      eventStreamPublishInput(text, (uint32_t)(event.timeUs / 1000));
+    }
+
+    if (binary) {
+      flushPulsadorEvents();
+      uint32_t nowUs = micros();
+      for (uint32_t i = 0; i < batched; i++) {
+        inputLatency.record(nowUs - batchedUs[i]);
+      }
+    }
+  } while (popped == INPUT_EVENT_QUEUE_SLOTS);
+}
+
+// Tramas del puente listas para la UART (solo la tarea de radio)
+static RadioTxStaging radioTxStaging;
+
+// Origen de la trama entregada a la UART (tag de radioTxSubmit())
+enum RadioTxSource : uint8_t {
+  RADIO_TX_NONE = 0,
+  RADIO_TX_BLE = 1,
+  RADIO_TX_WEB = 2
+};
+
+/**
+ * @brief Cierra las tramas que ya salieron por la UART
+ * Registra su latencia (llegada -> último byte en la línea) y, las del puente
+ * BLE, liberan créditos para el teléfono.
+ */
+static void completeRadioTx() {
+  UartTxDone done;
+  bool drained = false;
+  while (radioTxPoll(done)) {
+    bridgeLatency.record(micros() - done.stampUs);
+    if (done.tag == RADIO_TX_BLE) {
+      bridgeCredits.onDrained(done.len);
+      drained = true;
+    }
+  }
+  if (drained && bleConnected) {
+    serviceBridgeCredits(false);
+  }
+}
+
+RadioTxStagingStats getRadioTxStagingStats() {
+  return radioTxStaging.getStats();
+}
+
+/**
+ * @brief Pasa las tramas de las colas del puente (BLE primero, luego HTTP) a
+ * radioTxStaging mientras quepan y publica todas en el histórico y WebSocket
+ * Un crono que sustituye a otro del puente BLE, o una trama descartada en
+ * bleBridgeQueue al desbordar, libera los créditos de este.
+ */
+static void stageBridgeFrames() {
+  bool drained = false;
+
+  // Tramas que un productor sacó de la cola al desbordar: nunca se vaciarán
+  uint32_t droppedBytes = bleBridgeQueue.getStats().droppedOldestBytes;
+  if (droppedBytes != reportedDroppedBytes) {
+    bridgeCredits.onDropped(droppedBytes - reportedDroppedBytes);
+    reportedDroppedBytes = droppedBytes;
+    drained = true;
+  }
+  while (!radioTxStaging.full()) {
+    BridgeFrame& slot = radioTxStaging.back();
+    uint8_t source;
+    if (bleBridgeQueue.pop(slot)) {
+      source = RADIO_TX_BLE;
+      DEBUG_PRINT("BLE->APC220 (bytes): ");
+      DEBUG_PRINTLN(slot.len);
+    } else if (webBridgeQueue.pop(slot)) {
+      source = RADIO_TX_WEB;
+      DEBUG_PRINT("HTTP->APC220 (bytes): ");
+      DEBUG_PRINTLN(slot.len);
+    } else {
+      break;
+    }
+
+    // Antes de commit(): un crono puede sustituir a otro en la cola de salida,
+    // pero /api/messages y los clientes ven todas las tramas
+    broadcastBridgeMessage(slot);
+
+    uint16_t supersededLen;
+    uint8_t supersededSource;
+    if (radioTxStaging.commit(source, supersededLen, supersededSource) && supersededSource == RADIO_TX_BLE) {
+      bridgeCredits.onDrained(supersededLen);
+      drained = true;
+    }
+  }
+  if (drained && bleConnected) {
+    serviceBridgeCredits(false);
+  }
+}
+
+/**
+ * @brief Reparte las tramas recibidas por el APC220 a WebSocket y BLE
+ */
+static void forwardRadioRx() {
+  static BridgeFrame frame;
+  while (radioRxQueue.pop(frame)) {
+    DEBUG_PRINT("APC220->Hub (bytes): ");
+    DEBUG_PRINTLN(frame.len);
+
+    broadcastRadioMessage(frame);
+    if (bleConnected) {
+      notifyBridgeRx(frame.data, frame.len);
     }
   }
 }
 
 /**
  * @brief Tarea: Procesa datos del módulo APC220
- * Intervalo: 200ms
+ * Se ejecuta al ser notificada por un productor del puente o al vencer la
+ * espera que devolvió la iteración anterior
  * 
- * Envía datos que llegaron por BLE al APC220 y notifica a WebSocket
+ * Pasa las tramas de las colas (BLE primero, luego HTTP) a radioTxStaging, que
+ * se queda con el último crono de cada display, y las entrega al buffer TX de
+ * la UART al ritmo del aire, sin esperar a la línea.
+ * Cierra las tramas ya transmitidas y reparte las recibidas por el APC220.
+ * @return µs hasta la próxima tarea pendiente (dosificador o fin de una
+ *         trama en vuelo); 0 si solo queda esperar a un productor
  */
-void taskProcessRadio() {
-  // Si hay un nuevo mensaje BLE listo
-  if (bleMessageReady) {
-    bleMessageReady = false;
-    
-    // Reenviar al APC220 por Serial2
-    // Necesitamos hacer una copia temporal para evitar problemas con volatile
-    uint8_t tempBuffer[255];
-    int tempLen = bleMessageLen;
-    memcpy(tempBuffer, (const void*)bleMessageBuffer, tempLen);
-    
-    Serial2.write(tempBuffer, tempLen);
-    Serial2.flush();
-    
-    DEBUG_PRINT("BLE->APC220 (bytes): ");
-    DEBUG_PRINTLN(tempLen);
-    
-    // Notificar a todos los clientes WebSocket
-    broadcastBLEMessage();
+uint32_t taskProcessRadio() {
+  static BridgeFrame frame;
+  static uint16_t offset = 0;
+  static uint8_t source = RADIO_TX_NONE;   // Trama a medio entregar
+  uint32_t waitUs = 0;
+
+  completeRadioTx();
+  forwardRadioRx();
+
+  for (;;) {
+    stageBridgeFrames();
+    if (source == RADIO_TX_NONE) {
+      if (!radioTxStaging.pop(frame, source)) break;
+      offset = 0;
+    }
+
+    // La trama sigue en curso si el dosificador o los huecos en vuelo no dan más
+    if (!radioTxSubmit(frame, offset, source, waitUs)) break;
+    source = RADIO_TX_NONE;
   }
+
+  completeRadioTx();
+  uint32_t doneUs = radioTxNextDoneUs();
+  if (doneUs > 0 && (waitUs == 0 || doneUs < waitUs)) {
+    waitUs = doneUs;
+  }
+  return waitUs;
 }
 
 /**
  * @brief Tarea: Imprime estado del sistema para debugging
- * Intervalo: 5000ms (5 segundos)
+ * Intervalo: 5000ms, en la tarea Stats (TaskScheduler)
  */
 void taskDebugStatus() {
+  SystemStats sys = getSystemStats();
   DEBUG_PRINTLN("\n=== System Status ===");
   DEBUG_PRINT("Free Heap: ");
-  DEBUG_PRINT(ESP.getFreeHeap());
-  DEBUG_PRINTLN(" bytes");
+  DEBUG_PRINT(sys.heapFree);
+  DEBUG_PRINT(" bytes (min ");
+  DEBUG_PRINT(sys.heapMin);
+  DEBUG_PRINT(", largest ");
+  DEBUG_PRINT(sys.heapLargest);
+  DEBUG_PRINT(", fragmentation ");
+  DEBUG_PRINT(sys.heapFragPercent);
+  DEBUG_PRINTLN("%)");
+  if (sys.allocsCounted) {
+    DEBUG_PRINT("Heap allocations per task:");
+    for (uint8_t i = 0; i < sys.taskCount; i++) {
+      DEBUG_PRINT(" ");
+      DEBUG_PRINT(sys.tasks[i].name);
+      DEBUG_PRINT("=");
+      DEBUG_PRINT(sys.tasks[i].allocs);
+    }
+    DEBUG_PRINTLN("");
+  }
+  DEBUG_PRINT("Idle %: core0=");
+  DEBUG_PRINT(sys.idlePercent[0]);
+  DEBUG_PRINT(" core1=");
+  DEBUG_PRINTLN(sys.idlePercent[1]);
   
   DEBUG_PRINT("BLE Connected: ");
   if (bleConnected) {
@@ -171,9 +427,107 @@ void taskDebugStatus() {
     DEBUG_PRINTLN("NO");
   }
   
+  BridgeQueueStats q = bleBridgeQueue.getStats();
+  DEBUG_PRINT("Bridge queue: ");
+  DEBUG_PRINT(q.depth);
+  DEBUG_PRINT("/");
+  DEBUG_PRINT(BridgeQueue::CAPACITY);
+  DEBUG_PRINT(" (max ");
+  DEBUG_PRINT(q.maxDepth);
+  DEBUG_PRINT(") | in: ");
+  DEBUG_PRINT(q.pushed);
+  DEBUG_PRINT(" out: ");
+  DEBUG_PRINT(q.popped);
+  DEBUG_PRINT(" | drop oldest: ");
+  DEBUG_PRINT(q.droppedOldest);
+  DEBUG_PRINT(" drop newest: ");
+  DEBUG_PRINTLN(q.droppedNewest);
+
+  DEBUG_PRINT("Bridge latency (us): p50=");
+  DEBUG_PRINT(bridgeLatency.percentile(50));
+  DEBUG_PRINT(" p99=");
+  DEBUG_PRINT(bridgeLatency.percentile(99));
+  DEBUG_PRINT(" max=");
+  DEBUG_PRINT(bridgeLatency.getMax());
+  DEBUG_PRINT(" n=");
+  DEBUG_PRINTLN(bridgeLatency.getCount());
+
+  InputEventQueueStats edges = inputEdges.getStats();
+  DEBUG_PRINT("F1-F3 edges: ");
+  DEBUG_PRINT(edges.pushed);
+  DEBUG_PRINT(" (max depth ");
+  DEBUG_PRINT(edges.maxDepth);
+  DEBUG_PRINT(") | overflows: ");
+  DEBUG_PRINT(edges.overflows);
+  DEBUG_PRINT(" debounced: ");
+  DEBUG_PRINT(inputDebounced[0]);
+  DEBUG_PRINT("/");
+  DEBUG_PRINT(inputDebounced[1]);
+  DEBUG_PRINT("/");
+  DEBUG_PRINTLN(inputDebounced[2]);
+
+  if (pulsadorBinaryEnabled()) {
+    PulsadorEventStats batch = pulsadorEvents.getStats();
+    DEBUG_PRINT("Pulsador (bin): ");
+    DEBUG_PRINT(batch.records);
+    DEBUG_PRINT(" events in ");
+    DEBUG_PRINT(batch.notifications);
+    DEBUG_PRINT(" notifications | lost: ");
+    DEBUG_PRINTLN(batch.lost);
+  }
+
+  RadioRxStats rx = getRadioRxStats();
+  DEBUG_PRINT("Radio RX: ");
+  DEBUG_PRINT(rx.frames);
+  DEBUG_PRINT(" frames, ");
+  DEBUG_PRINT(rx.bytes);
+  DEBUG_PRINT(" bytes | malformed: ");
+  DEBUG_PRINT(rx.malformed);
+  DEBUG_PRINT(" dropped: ");
+  DEBUG_PRINT(rx.queueDrops);
+  DEBUG_PRINT(" uart errors: ");
+  DEBUG_PRINTLN(getRadioRxUartErrors());
+
+  RadioTxPacerStats tx = radioTxPacer.getStats(micros());
+  DEBUG_PRINT("Radio TX: ");
+  DEBUG_PRINT(tx.bytes);
+  DEBUG_PRINT(" bytes @ RF ");
+  DEBUG_PRINT(tx.airBps);
+  DEBUG_PRINT(" bps | air ");
+  DEBUG_PRINT(tx.utilization);
+  DEBUG_PRINT("% (busy ");
+  DEBUG_PRINT(tx.burstUtilization);
+  DEBUG_PRINT("%) | throttled: ");
+  DEBUG_PRINT(tx.throttled);
+  DEBUG_PRINT(" peak buffer: ");
+  DEBUG_PRINT(tx.peakLevel);
+  DEBUG_PRINT("/");
+  DEBUG_PRINT(tx.bufferLimit);
+  RadioTxStagingStats staging = radioTxStaging.getStats();
+  DEBUG_PRINT(" | staged: ");
+  DEBUG_PRINT(staging.depth);
+  DEBUG_PRINT(" (max ");
+  DEBUG_PRINT(staging.maxDepth);
+  DEBUG_PRINT(") coalesced: ");
+  DEBUG_PRINTLN(staging.coalesced);
+
   DEBUG_PRINT("WiFi SSID: ");
   DEBUG_PRINTLN(WIFI_AP_SSID);
   DEBUG_PRINTLN("===================\n");
+
+#if DEBUG
+  lowRateJobs.printTasks();
+#endif
+}
+
+/**
+ * @brief Trabajo: refresca los resúmenes de latencias y del sistema legibles por BLE
+ * Intervalo: BLE_STATS_UPDATE_MS, solo hace algo con una central conectada
+ */
+static void refreshBleSummaries() {
+  if (!bleConnected) return;
+  updateLatencyCharacteristic();
+  updateSystemStatsCharacteristic();
 }
 
 // =============================
@@ -182,8 +536,14 @@ void taskDebugStatus() {
 static void webServerTask(void* pvParameters) {
   (void)pvParameters;
   for (;;) {
-    taskHandleWebServer();
-    vTaskDelay(WEB_SERVER_DELAY);
+    // Dormir hasta que haya algo que enviar o venza el plazo más cercano
+    uint32_t waitMs = taskHandleWebServer();
+    TickType_t wait = portMAX_DELAY;
+    if (waitMs != UINT32_MAX) {
+      wait = pdMS_TO_TICKS(waitMs);
+      if (wait == 0) wait = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
   }
 }
 
@@ -191,31 +551,62 @@ static void bleTask(void* pvParameters) {
   (void)pvParameters;
   for (;;) {
     taskHandleBLE();
-    vTaskDelay(BLE_DELAY);
+
+    // Dormir hasta un callback de conexión o la próxima trama del generador
+    // de carga, lo que llegue antes
+    uint32_t waitUs = loadGeneratorService();
+
+    TickType_t wait = portMAX_DELAY;
+    if (waitUs != UINT32_MAX) {
+      // Redondeo hacia arriba: despertar antes de tiempo solo daría otra vuelta vacía
+      wait = pdMS_TO_TICKS((waitUs + 999) / 1000);
+      if (wait == 0) wait = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
   }
 }
 
 static void inputTask(void* pvParameters) {
   (void)pvParameters;
+  uint32_t lastWake = millis();
   for (;;) {
     taskScanInputs();
-    vTaskDelay(INPUT_DELAY);
+
+    // Tras INPUT_IDLE_AFTER_MS sin interrupciones y sin teclas pulsadas, armar
+    // las columnas del teclado y dormir hasta la próxima tecla, flanco o switch
+    if (millis() - lastWake >= INPUT_IDLE_AFTER_MS && armInputWake(bleConnected)) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      disarmInputWake();
+      lastWake = millis();
+    } else if (ulTaskNotifyTake(pdTRUE, INPUT_DELAY) > 0) {
+      lastWake = millis();
+    }
   }
 }
 
 static void radioTask(void* pvParameters) {
   (void)pvParameters;
   for (;;) {
-    taskProcessRadio();
-    vTaskDelay(RADIO_DELAY);
+    // Entregar lo pendiente y dormir hasta la próxima trama, o hasta que el
+    // dosificador deje seguir o termine de salir una trama en vuelo
+    uint32_t waitUs = taskProcessRadio();
+    TickType_t wait = portMAX_DELAY;
+    if (waitUs > 0) {
+      wait = pdMS_TO_TICKS((waitUs + 999) / 1000);
+      if (wait == 0) wait = 1;
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
   }
 }
 
-static void debugTask(void* pvParameters) {
+static void statsTask(void* pvParameters) {
   (void)pvParameters;
+  lowRateJobs.addTask("stats", systemStatsSample, STATS_INTERVAL_MS);
+  lowRateJobs.addTask("debug", taskDebugStatus, DEBUG_INTERVAL_MS);
+  lowRateJobs.addTask("bleStats", refreshBleSummaries, BLE_STATS_UPDATE_MS);
   for (;;) {
-    taskDebugStatus();
-    vTaskDelay(DEBUG_DELAY);
+    lowRateJobs.update();
+    lowRateJobs.sleepUntilNext();
   }
 }
 
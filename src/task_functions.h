@@ -2,16 +2,34 @@
 #define TASK_FUNCTIONS_H
 
 #include <Arduino.h>
+#include "latency_metrics.h"
+#include "radio_tx_staging.h"
 
 // Funciones de tarea (una iteración) reutilizadas por los hilos FreeRTOS
 // Todas son no-bloqueantes
-void taskHandleWebServer();
+uint32_t taskHandleWebServer();   // Devuelve ms hasta volver a llamarla (UINT32_MAX = al notificarla)
 void taskHandleBLE();
 void taskScanInputs();
-void taskProcessRadio();
+uint32_t taskProcessRadio();   // Devuelve µs hasta volver a llamarla (0 = al notificarla)
 void taskDebugStatus();
 
 // Inicializa y arranca las tareas FreeRTOS fijadas a cada núcleo
 void startSystemTasks();
 
+// Despierta a la tarea de radio (llamar tras encolar en el puente)
+void notifyRadioTask();
+
+// Tramas del puente pendientes de la UART y cronos sustituidos
+RadioTxStagingStats getRadioTxStagingStats();
+
+// Despierta a la tarea web (llamar tras encolar tramas WebSocket)
+void notifyWebServerTask();
+
+// Despierta a la tarea BLE (conexión/desconexión desde los callbacks de NimBLE)
+void notifyBleTask();
+
+// Despierta a la tarea de entradas (flancos F1-F3, teclado, switches)
+void notifyInputTask();
+void notifyInputTaskFromISR();
+
 #endif
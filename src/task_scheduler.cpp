@@ -1,115 +1,218 @@
 #include "task_scheduler.h"
 
-TaskScheduler::TaskScheduler() : taskCount(0) {
+TaskScheduler::TaskScheduler() : heapSize(0), taskCount(0) {
   for (int i = 0; i < MAX_TASKS; i++) {
     tasks[i].function = nullptr;
+    tasks[i].used = false;
     tasks[i].enabled = false;
+    heap[i] = INVALID_TASK;
   }
 }
 
-bool TaskScheduler::addTask(const char* name, TaskFunction function, unsigned long interval) {
-  if (taskCount >= MAX_TASKS) {
-    Serial.printf("[TaskScheduler] ERROR: Max tasks (%d) reached!\n", MAX_TASKS);
-    return false;
+// =============================
+// Montículo de mínimos por nextDueUs (comparación tolerante al desborde)
+// =============================
+bool TaskScheduler::dueBefore(TaskId a, TaskId b) const {
+  return (int32_t)(tasks[a].nextDueUs - tasks[b].nextDueUs) < 0;
+}
+
+void TaskScheduler::siftUp(int pos) {
+  while (pos > 0) {
+    int parent = (pos - 1) / 2;
+    if (!dueBefore(heap[pos], heap[parent])) break;
+    TaskId tmp = heap[pos];
+    heap[pos] = heap[parent];
+    heap[parent] = tmp;
+    pos = parent;
+  }
+}
+
+void TaskScheduler::siftDown(int pos) {
+  for (;;) {
+    int left = pos * 2 + 1;
+    int right = left + 1;
+    int smallest = pos;
+    if (left < heapSize && dueBefore(heap[left], heap[smallest])) smallest = left;
+    if (right < heapSize && dueBefore(heap[right], heap[smallest])) smallest = right;
+    if (smallest == pos) break;
+    TaskId tmp = heap[pos];
+    heap[pos] = heap[smallest];
+    heap[smallest] = tmp;
+    pos = smallest;
+  }
+}
+
+void TaskScheduler::heapPush(TaskId id) {
+  heap[heapSize] = id;
+  siftUp(heapSize);
+  heapSize++;
+}
+
+void TaskScheduler::heapRemove(TaskId id) {
+  for (int i = 0; i < heapSize; i++) {
+    if (heap[i] == id) {
+      heapSize--;
+      heap[i] = heap[heapSize];
+      if (i < heapSize) {
+        siftDown(i);
+        siftUp(i);
+      }
+      return;
+    }
   }
+}
+
+bool TaskScheduler::validTask(TaskId id) const {
+  return id >= 0 && id < MAX_TASKS && tasks[id].used;
+}
 
-  // Verificar que no exista una tarea con el mismo nombre
-  for (int i = 0; i < taskCount; i++) {
-    if (strcmp(tasks[i].name, name) == 0) {
-      Serial.printf("[TaskScheduler] ERROR: Task '%s' already exists!\n", name);
-      return false;
+// =============================
+// API
+// =============================
+TaskId TaskScheduler::addTask(const char* name, TaskFunction function, unsigned long interval) {
+  TaskId id = INVALID_TASK;
+  for (int i = 0; i < MAX_TASKS; i++) {
+    if (!tasks[i].used) {
+      id = (TaskId)i;
+      break;
     }
   }
+  if (id == INVALID_TASK || function == nullptr) {
+    Serial.printf("[TaskScheduler] ERROR: Max tasks (%d) reached!\n", MAX_TASKS);
+    return INVALID_TASK;
+  }
 
-  tasks[taskCount].name = name;
-  tasks[taskCount].function = function;
-  tasks[taskCount].interval = interval;
-  tasks[taskCount].lastExecution = 0;
-  tasks[taskCount].enabled = true;
-  tasks[taskCount].executionCount = 0;
+  Task& task = tasks[id];
+  task.name = name;
+  task.function = function;
+  task.intervalUs = (uint32_t)interval * 1000;
+  task.nextDueUs = micros();
+  task.used = true;
+  task.enabled = true;
+  memset(&task.stats, 0, sizeof(task.stats));
+  heapPush(id);
 
   Serial.printf("[TaskScheduler] Task '%s' added (interval: %lu ms)\n", name, interval);
   taskCount++;
 
-  return true;
+  return id;
 }
 
-bool TaskScheduler::removeTask(const char* name) {
-  for (int i = 0; i < taskCount; i++) {
-    if (strcmp(tasks[i].name, name) == 0) {
-      // Desplazar tareas posteriores
-      for (int j = i; j < taskCount - 1; j++) {
-        tasks[j] = tasks[j + 1];
-      }
-      taskCount--;
-      Serial.printf("[TaskScheduler] Task '%s' removed\n", name);
-      return true;
-    }
+bool TaskScheduler::removeTask(TaskId id) {
+  if (!validTask(id)) {
+    Serial.printf("[TaskScheduler] ERROR: Task %d not found!\n", id);
+    return false;
   }
-  Serial.printf("[TaskScheduler] ERROR: Task '%s' not found!\n", name);
-  return false;
+  if (tasks[id].enabled) heapRemove(id);
+  tasks[id].used = false;
+  tasks[id].enabled = false;
+  tasks[id].function = nullptr;
+  taskCount--;
+  Serial.printf("[TaskScheduler] Task '%s' removed\n", tasks[id].name);
+  return true;
 }
 
 void TaskScheduler::update() {
-  unsigned long currentTime = millis();
+  // Como mucho una pasada por tarea, para que una de periodo 0 no acapare el bucle
+  uint32_t ran = 0;   // Bit por TaskId ejecutado en esta llamada
+  while (heapSize > 0) {
+    TaskId id = heap[0];
+    if (ran & (1UL << id)) break;
+    Task& task = tasks[id];
+    uint32_t now = micros();
+    int32_t late = (int32_t)(now - task.nextDueUs);
+    if (late < 0) break;
 
-  for (int i = 0; i < taskCount; i++) {
-    if (!tasks[i].enabled || tasks[i].function == nullptr) {
-      continue;
-    }
+    ran |= 1UL << id;
+    uint32_t start = now;
+    task.function();
+    uint32_t runUs = micros() - start;
+
+    TaskRunStats& s = task.stats;
+    s.executionCount++;
+    s.lastRunUs = runUs;
+    s.totalRunUs += runUs;
+    if (runUs > s.maxRunUs) s.maxRunUs = runUs;
+    s.totalLateUs += (uint32_t)late;
+    if ((uint32_t)late > s.maxLateUs) s.maxLateUs = (uint32_t)late;
 
-    // Verificar si es tiempo de ejecutar
-    if (tasks[i].interval == 0 || (currentTime - tasks[i].lastExecution) >= tasks[i].interval) {
-      // Ejecutar tarea
-      tasks[i].function();
-      tasks[i].lastExecution = currentTime;
-      tasks[i].executionCount++;
+    // Periodo fijo; si ya se ha perdido un periodo completo, resincronizar
+    task.nextDueUs += task.intervalUs;
+    uint32_t end = start + runUs;
+    if (task.intervalUs > 0 && (int32_t)(end - task.nextDueUs) >= (int32_t)task.intervalUs) {
+      s.overruns++;
+      task.nextDueUs = end + task.intervalUs;
+    } else if (task.intervalUs == 0) {
+      task.nextDueUs = end;
     }
+    siftDown(0);
   }
 }
 
-void TaskScheduler::enableTask(const char* name) {
-  for (int i = 0; i < taskCount; i++) {
-    if (strcmp(tasks[i].name, name) == 0) {
-      tasks[i].enabled = true;
-      Serial.printf("[TaskScheduler] Task '%s' enabled\n", name);
-      return;
-    }
-  }
-  Serial.printf("[TaskScheduler] ERROR: Task '%s' not found!\n", name);
+uint32_t TaskScheduler::timeUntilNextUs() const {
+  if (heapSize == 0) return UINT32_MAX;
+  int32_t remaining = (int32_t)(tasks[heap[0]].nextDueUs - micros());
+  return remaining > 0 ? (uint32_t)remaining : 0;
 }
 
-void TaskScheduler::disableTask(const char* name) {
-  for (int i = 0; i < taskCount; i++) {
-    if (strcmp(tasks[i].name, name) == 0) {
-      tasks[i].enabled = false;
-      Serial.printf("[TaskScheduler] Task '%s' disabled\n", name);
-      return;
-    }
+void TaskScheduler::sleepUntilNext(uint32_t maxWaitMs) {
+  uint32_t waitUs = timeUntilNextUs();
+  if (waitUs == 0) return;
+
+  // Redondear hacia arriba al tick, para no despertar justo antes del plazo
+  uint64_t limitUs = (uint64_t)maxWaitMs * 1000;
+  if (waitUs > limitUs) waitUs = (uint32_t)limitUs;
+  TickType_t ticks = (TickType_t)((waitUs + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+  vTaskDelay(ticks > 0 ? ticks : 1);
+}
+
+void TaskScheduler::enableTask(TaskId id) {
+  if (!validTask(id)) {
+    Serial.printf("[TaskScheduler] ERROR: Task %d not found!\n", id);
+    return;
   }
-  Serial.printf("[TaskScheduler] ERROR: Task '%s' not found!\n", name);
+  if (tasks[id].enabled) return;
+  tasks[id].enabled = true;
+  tasks[id].nextDueUs = micros();
+  heapPush(id);
+  Serial.printf("[TaskScheduler] Task '%s' enabled\n", tasks[id].name);
 }
 
-Task* TaskScheduler::getTask(const char* name) {
-  for (int i = 0; i < taskCount; i++) {
-    if (strcmp(tasks[i].name, name) == 0) {
-      return &tasks[i];
-    }
+void TaskScheduler::disableTask(TaskId id) {
+  if (!validTask(id)) {
+    Serial.printf("[TaskScheduler] ERROR: Task %d not found!\n", id);
+    return;
   }
-  return nullptr;
+  if (!tasks[id].enabled) return;
+  tasks[id].enabled = false;
+  heapRemove(id);
+  Serial.printf("[TaskScheduler] Task '%s' disabled\n", tasks[id].name);
 }
 
-void TaskScheduler::printTasks() {
+const Task* TaskScheduler::getTask(TaskId id) const {
+  return validTask(id) ? &tasks[id] : nullptr;
+}
+
+void TaskScheduler::printTasks() const {
   Serial.println("\n=== Task Scheduler Status ===");
   Serial.printf("Total tasks: %d/%d\n", taskCount, MAX_TASKS);
   
-  for (int i = 0; i < taskCount; i++) {
-    Serial.printf("[%d] %s | Interval: %lu ms | Enabled: %s | Executions: %lu\n",
+  for (int i = 0; i < MAX_TASKS; i++) {
+    const Task& task = tasks[i];
+    if (!task.used) continue;
+    const TaskRunStats& s = task.stats;
+    uint32_t avgRun = s.executionCount ? (uint32_t)(s.totalRunUs / s.executionCount) : 0;
+    uint32_t avgLate = s.executionCount ? (uint32_t)(s.totalLateUs / s.executionCount) : 0;
+    Serial.printf("[%d] %s | Interval: %lu ms | Enabled: %s | Executions: %lu | "
+                  "Run avg/max: %lu/%lu us | Late avg/max: %lu/%lu us | Overruns: %lu\n",
                   i,
-                  tasks[i].name,
-                  tasks[i].interval,
-                  tasks[i].enabled ? "YES" : "NO",
-                  tasks[i].executionCount);
+                  task.name,
+                  (unsigned long)(task.intervalUs / 1000),
+                  task.enabled ? "YES" : "NO",
+                  (unsigned long)s.executionCount,
+                  (unsigned long)avgRun, (unsigned long)s.maxRunUs,
+                  (unsigned long)avgLate, (unsigned long)s.maxLateUs,
+                  (unsigned long)s.overruns);
   }
   Serial.println("==============================\n");
 }
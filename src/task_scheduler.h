@@ -6,22 +6,57 @@
 // Tipos de funciones que pueden ser tareas
 typedef void (*TaskFunction)(void);
 
+// Identificador de tarea devuelto por addTask() (índice estable)
+typedef int8_t TaskId;
+static const TaskId INVALID_TASK = -1;
+
+// Estadísticas de ejecución de una tarea (µs)
+struct TaskRunStats {
+  uint32_t executionCount;
+  uint32_t lastRunUs;           // Duración de la última ejecución
+  uint32_t maxRunUs;
+  uint64_t totalRunUs;
+  uint32_t maxLateUs;           // Retraso máximo sobre la hora prevista (jitter)
+  uint64_t totalLateUs;
+  uint32_t overruns;            // Veces que se perdió al menos un periodo completo
+};
+
 // Estructura para definir una tarea
 struct Task {
   const char* name;
   TaskFunction function;
-  unsigned long interval;       // Intervalo en milisegundos
-  unsigned long lastExecution;  // Timestamp de última ejecución
+  uint32_t intervalUs;          // Periodo en microsegundos
+  uint32_t nextDueUs;           // micros() de la próxima ejecución
+  bool used;
   bool enabled;
-  unsigned long executionCount; // Contador de ejecuciones
+  TaskRunStats stats;
 };
 
+/**
+ * @brief Planificador cooperativo ordenado por plazos
+ *
+ * Las tareas se guardan en un montículo de mínimos por próxima ejecución,
+ * así que update() solo mira la cima y sleepUntilNext() duerme justo hasta
+ * el siguiente plazo. Cada tarea mantiene un periodo fijo (sin deriva); si
+ * se pierde un periodo entero se cuenta un overrun y se resincroniza.
+ * No es seguro entre tareas: un único hilo FreeRTOS lo posee y lo ejecuta.
+ */
 class TaskScheduler {
 private:
   static const int MAX_TASKS = 16;
+  static_assert(MAX_TASKS <= 32, "update() marca las tareas ejecutadas en un uint32_t");
   Task tasks[MAX_TASKS];
+  TaskId heap[MAX_TASKS];       // Montículo de tareas habilitadas
+  int heapSize;
   int taskCount;
 
+  bool dueBefore(TaskId a, TaskId b) const;
+  void siftUp(int pos);
+  void siftDown(int pos);
+  void heapPush(TaskId id);
+  void heapRemove(TaskId id);
+  bool validTask(TaskId id) const;
+
 public:
   TaskScheduler();
   
@@ -29,47 +64,55 @@ public:
    * @brief Añade una nueva tarea al scheduler
    * @param name Nombre de la tarea (para debugging)
    * @param function Función a ejecutar
-   * @param interval Intervalo en ms (0 = cada loop)
-   * @return true si se añadió exitosamente, false si está lleno
+   * @param interval Intervalo en ms (0 = en cada update)
+   * @return Identificador de la tarea, INVALID_TASK si está lleno
    */
-  bool addTask(const char* name, TaskFunction function, unsigned long interval = 0);
+  TaskId addTask(const char* name, TaskFunction function, unsigned long interval = 0);
   
   /**
-   * @brief Elimina una tarea por nombre
-   * @param name Nombre de la tarea
+   * @brief Elimina una tarea
+   * @param id Identificador devuelto por addTask()
    * @return true si se eliminó, false si no existe
    */
-  bool removeTask(const char* name);
+  bool removeTask(TaskId id);
   
   /**
-   * @brief Actualiza el scheduler - debe llamarse en cada loop
-   * Ejecuta las tareas cuyo intervalo ha vencido
+   * @brief Ejecuta las tareas cuyo plazo ha vencido
    */
   void update();
+
+  /**
+   * @brief Microsegundos hasta el próximo plazo (0 si ya venció)
+   * @return UINT32_MAX si no hay tareas habilitadas
+   */
+  uint32_t timeUntilNextUs() const;
+
+  /**
+   * @brief Bloquea la tarea FreeRTOS actual hasta el próximo plazo
+   * @param maxWaitMs Espera máxima si no hay tareas habilitadas
+   */
+  void sleepUntilNext(uint32_t maxWaitMs = 1000);
   
   /**
-   * @brief Habilita una tarea
-   * @param name Nombre de la tarea
+   * @brief Habilita una tarea; su próxima ejecución será inmediata
    */
-  void enableTask(const char* name);
+  void enableTask(TaskId id);
   
   /**
    * @brief Deshabilita una tarea sin eliminarla
-   * @param name Nombre de la tarea
    */
-  void disableTask(const char* name);
+  void disableTask(TaskId id);
   
   /**
    * @brief Obtiene información de una tarea
-   * @param name Nombre de la tarea
    * @return Puntero a la tarea, nullptr si no existe
    */
-  Task* getTask(const char* name);
+  const Task* getTask(TaskId id) const;
   
   /**
-   * @brief Imprime información de todas las tareas
+   * @brief Imprime información y tiempos de todas las tareas
    */
-  void printTasks();
+  void printTasks() const;
   
   /**
    * @brief Obtiene el número de tareas registradas
@@ -0,0 +1,42 @@
+#include "uart_tx_tracker.h"
+#include <string.h>
+
+UartTxTracker::UartTxTracker() : head(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool UartTxTracker::mark(uint32_t stampUs, uint16_t len, uint8_t tag) {
+  if (full()) return false;
+  Entry& e = entries[(head + stats.inFlight) & (RADIO_TX_INFLIGHT_SLOTS - 1)];
+  e.end = stats.written;
+  e.stampUs = stampUs;
+  e.len = len;
+  e.tag = tag;
+  stats.inFlight++;
+  if (stats.inFlight > stats.maxInFlight) stats.maxInFlight = stats.inFlight;
+  return true;
+}
+
+bool UartTxTracker::popDone(uint32_t pendingBytes, UartTxDone& out) {
+  // Lo pendiente en el driver nunca supera lo entregado y no visto salir
+  uint32_t pending = pendingBytes < outstanding() ? pendingBytes : outstanding();
+  stats.completed = stats.written - pending;
+  if (stats.inFlight == 0) return false;
+
+  const Entry& e = entries[head];
+  if ((int32_t)(stats.completed - e.end) < 0) return false;
+  out.stampUs = e.stampUs;
+  out.len = e.len;
+  out.tag = e.tag;
+  head = (head + 1) & (RADIO_TX_INFLIGHT_SLOTS - 1);
+  stats.inFlight--;
+  stats.frames++;
+  return true;
+}
+
+uint32_t UartTxTracker::bytesUntilNext(uint32_t pendingBytes) const {
+  if (stats.inFlight == 0) return 0;
+  uint32_t pending = pendingBytes < outstanding() ? pendingBytes : outstanding();
+  int32_t left = (int32_t)(entries[head].end - (stats.written - pending));
+  return left > 0 ? (uint32_t)left : 0;
+}
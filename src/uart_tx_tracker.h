@@ -0,0 +1,81 @@
+#ifndef UART_TX_TRACKER_H
+#define UART_TX_TRACKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kroner_config.h"
+
+static_assert((RADIO_TX_INFLIGHT_SLOTS & (RADIO_TX_INFLIGHT_SLOTS - 1)) == 0,
+              "RADIO_TX_INFLIGHT_SLOTS debe ser potencia de 2");
+
+// Trama cuyo último byte ya salió por la UART
+struct UartTxDone {
+  uint32_t stampUs;   // micros() de llegada de la trama (medida de latencia)
+  uint16_t len;
+  uint8_t tag;        // Origen de la trama (lo elige quien la escribe)
+};
+
+// Contadores (instantánea)
+struct UartTxTrackerStats {
+  uint32_t written;   // Bytes entregados al driver
+  uint32_t completed; // Bytes que ya salieron por la línea
+  uint32_t frames;    // Tramas terminadas
+  uint32_t inFlight;  // Tramas entregadas y aún no terminadas
+  uint32_t maxInFlight;
+};
+
+/**
+ * @brief Sigue qué tramas entregadas al buffer TX de la UART han salido ya
+ *
+ * Cada trama se marca con el total de bytes escritos al terminar de entregarla;
+ * cuando los bytes pendientes en el driver bajan de esa marca, la trama está
+ * transmitida. Solo lo usa la tarea de radio; getStats() desde otra tarea
+ * puede mezclar campos de dos instantes (solo estadística).
+ */
+class UartTxTracker {
+public:
+  UartTxTracker();
+
+  // Bytes entregados al driver (una trama puede ir en varios trozos)
+  void wrote(size_t len) { stats.written += len; }
+
+  // Hay hueco para marcar otra trama
+  bool full() const { return stats.inFlight >= RADIO_TX_INFLIGHT_SLOTS; }
+
+  /**
+   * @brief Marca el final de una trama en lo escrito hasta ahora
+   * @return false si no hay hueco (comprobar full() antes de escribirla)
+   */
+  bool mark(uint32_t stampUs, uint16_t len, uint8_t tag);
+
+  /**
+   * @brief Extrae la trama más antigua si ya salió entera
+   * @param pendingBytes Bytes aún en el driver (buffer TX y FIFO)
+   */
+  bool popDone(uint32_t pendingBytes, UartTxDone& out);
+
+  /**
+   * @brief Bytes que faltan por salir hasta terminar la trama más antigua
+   * @return 0 si no hay tramas en vuelo
+   */
+  uint32_t bytesUntilNext(uint32_t pendingBytes) const;
+
+  // Bytes entregados al driver y aún no vistos salir
+  uint32_t outstanding() const { return stats.written - stats.completed; }
+
+  UartTxTrackerStats getStats() const { return stats; }
+
+private:
+  struct Entry {
+    uint32_t end;       // stats.written al terminar la trama
+    uint32_t stampUs;
+    uint16_t len;
+    uint8_t tag;
+  };
+
+  Entry entries[RADIO_TX_INFLIGHT_SLOTS];
+  uint32_t head;        // Próxima a terminar
+  UartTxTrackerStats stats;
+};
+
+#endif
@@ -1,25 +1,71 @@
 #include "kroner_config.h"
 #include "webserver_functions.h"
 #include "ble_functions.h"
+#include "task_functions.h"
+#include "message_store.h"
+#include "ws_fanout.h"
+#include "display_protocol.h"
+#include "static_assets.h"
+#include "event_stream.h"
+#include "latency_metrics.h"
+#include "system_stats.h"
+#include "load_generator.h"
+#include "input_functions.h"
+#include "serial_functions.h"
+#include "captive_dns.h"
+#include "send_body.h"
 
 // Instancias globales
-WebServer webServer(80);
-DNSServer dnsServer;
-WebSocketsServer webSocket(81);  // WebSocket en puerto 81
+AsyncWebServer webServer(80);
+static AsyncUDP dnsUdp;              // DNS cautivo en el puerto 53
+AsyncWebServer webSocketServer(81);  // WebSocket en puerto 81 (ws://<ip>:81/)
+AsyncWebSocket webSocket("/");
+
+// Negociación de formato: el cliente envía un mensaje binario {'K', modo}
+static const uint8_t WS_HELLO_MAGIC = 'K';
+static const uint8_t WS_MODE_JSON = 0x00;
+static const uint8_t WS_MODE_BINARY = MESSAGE_BIN_VERSION;
+
+// Cola de tramas de /api/send; productor: tarea async_tcp, consumidor: tarea de radio
+BridgeQueue webBridgeQueue(BRIDGE_QUEUE_DROP_POLICY);
+
+// Peticiones /api/messages?since= en espera; las añade async_tcp y las
+// responde la tarea web (serviceLongPolls) cuando hay tramas o vence el plazo
+struct LongPollWaiter {
+  bool used;                    // Hueco reservado
+  bool armed;                   // Listo para que lo atienda la tarea web
+  uint32_t since;
+  uint32_t deadline;            // millis()
+  AsyncWebServerRequestPtr request;
+};
+
+static LongPollWaiter longPolls[WEB_LONGPOLL_MAX];
+static portMUX_TYPE longPollMux = portMUX_INITIALIZER_UNLOCKED;
 
 void initWiFiAP() {
   DEBUG_PRINTLN("=================================");
   DEBUG_PRINTLN("Iniciando WiFi AP...");
   WiFi.mode(WIFI_AP);
-  WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASS);  // SSID sin contraseña por defecto
+  WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASS, WIFI_AP_CHANNEL, 0, WIFI_AP_MAX_CONN);  // SSID sin contraseña por defecto
   IPAddress apIP(WIFI_AP_IP0, WIFI_AP_IP1, WIFI_AP_IP2, WIFI_AP_IP3);
   WiFi.softAPConfig(apIP, apIP, IPAddress(WIFI_AP_MASK0, WIFI_AP_MASK1, WIFI_AP_MASK2, WIFI_AP_MASK3));
   DEBUG_PRINT("AP IP: ");
   DEBUG_PRINTLN(WiFi.softAPIP());
 
-  // Configurar DNS para Captive Portal
-  dnsServer.start(53, "*", apIP);
-  DEBUG_PRINTLN("DNS Server iniciado para Captive Portal");
+  // DNS del Captive Portal: AsyncUDP responde en su propia tarea, al llegar
+  // cada consulta, sin que nadie tenga que sondear el socket
+  static const uint8_t dnsIP[4] = {WIFI_AP_IP0, WIFI_AP_IP1, WIFI_AP_IP2, WIFI_AP_IP3};
+  if (dnsUdp.listen(53)) {
+    dnsUdp.onPacket([](AsyncUDPPacket& packet) {
+      uint8_t reply[CAPTIVE_DNS_MAX_PACKET];
+      size_t len = captiveDnsReply(packet.data(), packet.length(), dnsIP, CAPTIVE_DNS_TTL_S,
+                                   reply, sizeof(reply));
+      if (len > 0) packet.write(reply, len);
+    });
+    DEBUG_PRINTLN("DNS Server iniciado para Captive Portal");
+  } else {
+    DEBUG_PRINTLN("Error al iniciar el DNS del Captive Portal");
+  }
 }
 
 void initWebServer() {
@@ -28,140 +74,542 @@ void initWebServer() {
     DEBUG_PRINTLN("Error al inicializar LittleFS");
   } else {
     DEBUG_PRINTLN("LittleFS iniciado correctamente");
+    // Página principal en RAM desde el arranque
+    preloadStaticAsset("/index.html");
   }
 
   // Configurar WebSocket
-  webSocket.begin();
   webSocket.onEvent(onWebSocketEvent);
+  webSocketServer.addHandler(&webSocket);
+  webSocketServer.begin();
+  wsFanoutInit(webSocket);
   DEBUG_PRINTLN("WebSocket Server iniciado en puerto 81");
 
-  // Configurar rutas
-  webServer.on("/", handleRoot);
-  webServer.on("/icon.png", handleStaticFile);
-  webServer.on("/api/messages", handleGetMessages);
-  webServer.on("/api/send", HTTP_POST, handleSendMessage);
+  // Configurar rutas (los handlers corren en la tarea async_tcp, al llegar los datos)
+  webServer.on("/", HTTP_ANY, handleRoot);
+  webServer.on("/icon.png", HTTP_ANY, handleStaticFile);
+  webServer.on("/api/messages", HTTP_ANY, handleGetMessages);
+  webServer.on("/api/send", HTTP_POST, handleSendMessage, nullptr, handleSendMessageBody);
+  webServer.on("/api/stats", HTTP_ANY, handleGetStats);
+  webServer.on("/api/metrics", HTTP_ANY, handleGetMetrics);
+  webServer.on("/api/loadtest", HTTP_ANY, handleLoadTest);
   webServer.onNotFound(handleNotFound);
+  eventStreamInit(webServer);
   webServer.begin();
-  DEBUG_PRINTLN("Web Server iniciado en puerto 80");
+  DEBUG_PRINTLN("Web Server (async) iniciado en puerto 80");
   DEBUG_PRINTLN("=================================");
 }
 
-void handleRoot() {
-  if (LittleFS.exists("/index.html")) {
-    File file = LittleFS.open("/index.html", "r");
-    webServer.streamFile(file, "text/html");
-    file.close();
+/**
+ * @brief Sirve un fichero de LittleFS con gzip, ETag y Cache-Control
+ * @param request Petición en curso
+ * @param path Ruta del fichero
+ * @return false si el fichero no existe (no se envía respuesta)
+ */
+static bool serveStaticFile(AsyncWebServerRequest* request, const String& path) {
+  bool acceptsGzip = request->hasHeader("Accept-Encoding") &&
+                     request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+  StaticAsset asset;
+  if (!resolveStaticAsset(path, acceptsGzip, asset)) {
+    return false;
+  }
+
+  AsyncWebServerResponse* response;
+  bool notModified = request->hasHeader("If-None-Match") &&
+                     request->getHeader("If-None-Match")->value().indexOf(asset.etag) >= 0;
+  if (notModified) {
+    // El cliente ya tiene esta versión
+    releaseStaticAsset(asset);
+    response = request->beginResponse(304);
+  } else if (asset.data != nullptr) {
+    // Desde la caché en RAM, sin pasar por LittleFS. El buffer se lee según
+    // avanza el envío, así que queda retenido hasta que se cierra la conexión
+    response = request->beginResponse(200, asset.contentType, asset.data, asset.size);
+    recordStaticCacheServed(asset.size);
+    int8_t slot = asset.cacheSlot;
+    request->onDisconnect([slot]() {
+      StaticAsset held;
+      held.cacheSlot = slot;
+      releaseStaticAsset(held);
+    });
   } else {
-    webServer.send(404, "text/plain", "index.html no encontrado");
+    // Lectura por trozos a medida que el cliente confirma datos
+    File file = LittleFS.open(asset.path, "r");
+    if (!file) {
+      return false;
+    }
+    response = request->beginResponse(asset.contentType, asset.size,
+                                      [file](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+                                        (void)index;
+                                        return file.read(buffer, maxLen);
+                                      });
+  }
+
+  if (asset.gzip && !notModified) {
+    response->addHeader("Content-Encoding", "gzip");
   }
+  response->addHeader("ETag", asset.etag);
+  response->addHeader("Cache-Control", asset.cacheControl);
+  response->addHeader("Vary", "Accept-Encoding");
+  request->send(response);
+  return true;
 }
 
-void handleStaticFile() {
-  String path = webServer.uri();
-  if (LittleFS.exists(path)) {
-    File file = LittleFS.open(path, "r");
-    String contentType = "application/octet-stream";
-    if (path.endsWith(".png")) contentType = "image/png";
-    else if (path.endsWith(".jpg") || path.endsWith(".jpeg")) contentType = "image/jpeg";
-    else if (path.endsWith(".gif")) contentType = "image/gif";
-    else if (path.endsWith(".ico")) contentType = "image/x-icon";
-    webServer.streamFile(file, contentType);
-    file.close();
-  } else {
-    webServer.send(404, "text/plain", "Archivo no encontrado");
+void handleRoot(AsyncWebServerRequest* request) {
+  if (!serveStaticFile(request, "/index.html")) {
+    request->send(404, "text/plain", "index.html no encontrado");
   }
 }
 
-void handleNotFound() {
-  String path = webServer.uri();
+void handleStaticFile(AsyncWebServerRequest* request) {
+  if (!serveStaticFile(request, request->url())) {
+    request->send(404, "text/plain", "Archivo no encontrado");
+  }
+}
+
+void handleNotFound(AsyncWebServerRequest* request) {
+  String path = request->url();
   if (!path.startsWith("/api/")) {
-    webServer.sendHeader("Location", "http://192.168.4.1/", true);
-    webServer.send(302, "text/plain", "");
+    // Cualquier fichero de data/ (p.ej. /monitor.html)
+    if (serveStaticFile(request, path)) return;
+    // Resto: redirigir al portal cautivo
+    request->redirect("http://192.168.4.1/");
   } else {
-    webServer.send(404, "text/plain", "Not found");
-  }
-}
-
-void handleGetMessages() {
-  char jsonResponse[512];
-  
-  // Convertir buffer a base64
-  char base64Buffer[400];
-  int base64Len = 0;
-  if (bleMessageLen > 0) {
-    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    int i = 0;
-    while (i < bleMessageLen) {
-      uint8_t b1 = bleMessageBuffer[i++];
-      uint8_t b2 = (i < bleMessageLen) ? bleMessageBuffer[i++] : 0;
-      uint8_t b3 = (i < bleMessageLen) ? bleMessageBuffer[i++] : 0;
-      
-      base64Buffer[base64Len++] = alphabet[b1 >> 2];
-      base64Buffer[base64Len++] = alphabet[((b1 & 0x03) << 4) | (b2 >> 4)];
-      if (i - 1 < bleMessageLen) {
-        base64Buffer[base64Len++] = alphabet[((b2 & 0x0F) << 2) | (b3 >> 6)];
-      }
-      if (i < bleMessageLen) {
-        base64Buffer[base64Len++] = alphabet[b3 & 0x3F];
-      }
+    request->send(404, "text/plain", "Not found");
+  }
+}
+
+/**
+ * @brief Responde con las tramas del histórico posteriores a `since`
+ * {"messages":[{"seq":..,"len":..,"time":..,"data":"..."},...],"seq":<última>,"missed":<perdidas>}
+ */
+static void sendMessageHistory(AsyncWebServerRequest* request, uint32_t since) {
+  uint32_t latest = getLatestMessageSeq();
+  // Secuencia del futuro: el hub se ha reiniciado, empezar desde el principio
+  if (since > latest) since = 0;
+
+  uint32_t first = since + 1;
+  uint32_t missed = 0;
+  if (latest >= MESSAGE_HISTORY_SLOTS && first + MESSAGE_HISTORY_SLOTS <= latest) {
+    missed = latest - MESSAGE_HISTORY_SLOTS + 1 - first;
+    first = latest - MESSAGE_HISTORY_SLOTS + 1;
+  }
+
+  AsyncResponseStream* response = request->beginResponseStream("application/json", 1460);
+  response->print("{\"messages\":[");
+  char item[MESSAGE_HISTORY_JSON_MAX];
+  bool firstItem = true;
+  for (uint32_t seq = first; seq != latest + 1; seq++) {
+    size_t len = copyHistoryMessageJson(seq, item, sizeof(item));
+    if (len == 0) {
+      // Sobrescrita mientras se respondía
+      missed++;
+      continue;
+    }
+    if (!firstItem) response->print(',');
+    response->write((const uint8_t*)item, len);
+    firstItem = false;
+  }
+  response->printf("],\"seq\":%u,\"missed\":%u}", (unsigned)latest, (unsigned)missed);
+  request->send(response);
+}
+
+/**
+ * @brief Deja la petición en espera hasta que haya tramas nuevas
+ * @return false si no quedan huecos (hay que responder ya)
+ */
+static bool queueLongPoll(AsyncWebServerRequest* request, uint32_t since, uint32_t waitMs) {
+  int index = -1;
+  portENTER_CRITICAL(&longPollMux);
+  for (int i = 0; i < WEB_LONGPOLL_MAX; i++) {
+    if (!longPolls[i].used) {
+      longPolls[i].used = true;
+      index = i;
+      break;
+    }
+  }
+  portEXIT_CRITICAL(&longPollMux);
+  if (index < 0) return false;
+
+  // pause() puede reservar memoria: fuera de la sección crítica
+  LongPollWaiter& waiter = longPolls[index];
+  waiter.since = since;
+  waiter.deadline = millis() + waitMs;
+  waiter.request = request->pause();
+
+  portENTER_CRITICAL(&longPollMux);
+  waiter.armed = true;
+  portEXIT_CRITICAL(&longPollMux);
+  // La tarea web puede estar dormida sin plazo: que cuente con este
+  notifyWebServerTask();
+  return true;
+}
+
+uint32_t serviceLongPolls() {
+  uint32_t latest = getLatestMessageSeq();
+  uint32_t now = millis();
+  LongPollWaiter ready[WEB_LONGPOLL_MAX];
+  int count = 0;
+  uint32_t nextMs = UINT32_MAX;
+
+  portENTER_CRITICAL(&longPollMux);
+  for (int i = 0; i < WEB_LONGPOLL_MAX; i++) {
+    LongPollWaiter& waiter = longPolls[i];
+    if (!waiter.armed) continue;
+    int32_t remaining = (int32_t)(waiter.deadline - now);
+    if (latest != waiter.since || remaining <= 0 || waiter.request.expired()) {
+      ready[count].since = waiter.since;
+      ready[count].request = std::move(waiter.request);
+      count++;
+      waiter.armed = false;
+      waiter.used = false;
+    } else if ((uint32_t)remaining < nextMs) {
+      nextMs = remaining;
+    }
+  }
+  portEXIT_CRITICAL(&longPollMux);
+
+  // Responder fuera de la sección crítica; el cliente puede haberse ido ya
+  for (int i = 0; i < count; i++) {
+    if (auto request = ready[i].request.lock()) {
+      sendMessageHistory(request.get(), ready[i].since);
+    }
+  }
+  return nextMs;
+}
+
+/**
+ * @brief GET /api/messages
+ * Sin parámetros: la última trama del puente (formato original).
+ * Con ?since=<seq>: las tramas posteriores del histórico en una sola
+ * respuesta; si no hay ninguna, espera hasta ?wait=<ms> (por defecto
+ * WEB_LONGPOLL_TIMEOUT_MS, 0 = no esperar).
+ */
+void handleGetMessages(AsyncWebServerRequest* request) {
+  if (request->hasParam("since")) {
+    uint32_t since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+    uint32_t waitMs = WEB_LONGPOLL_TIMEOUT_MS;
+    if (request->hasParam("wait")) {
+      waitMs = strtoul(request->getParam("wait")->value().c_str(), nullptr, 10);
+      if (waitMs > WEB_LONGPOLL_TIMEOUT_MS) waitMs = WEB_LONGPOLL_TIMEOUT_MS;
+    }
+    if (getLatestMessageSeq() != since || waitMs == 0 || !queueLongPoll(request, since, waitMs)) {
+      sendMessageHistory(request, since);
+    }
+    return;
+  }
+
+  // JSON ya codificado al publicar la trama; aquí solo se copia
+  char jsonResponse[MESSAGE_JSON_MAX];
+  size_t len = copyLatestMessageJson(jsonResponse, sizeof(jsonResponse));
+  AsyncResponseStream* response = request->beginResponseStream("application/json", len);
+  response->write((const uint8_t*)jsonResponse, len);
+  request->send(response);
+}
+
+/**
+ * @brief Acumula el cuerpo de /api/send (puede llegar en varios segmentos TCP)
+ * El buffer se guarda en _tempObject y lo libera la propia petición
+ */
+void handleSendMessageBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    if (total == 0 || total > WEB_SEND_MAX_BODY) return;
+    request->_tempObject = malloc(total);
+  }
+  if (request->_tempObject != nullptr && index + len <= total) {
+    memcpy((uint8_t*)request->_tempObject + index, data, len);
+  }
+}
+
+static_assert((WEB_SEND_MAX_BODY + BRIDGE_FRAME_MAX - 1) / BRIDGE_FRAME_MAX <= BRIDGE_QUEUE_SLOTS,
+              "WEB_SEND_MAX_BODY debe caber en webBridgeQueue vacía");
+
+/**
+ * @brief Encola un cuerpo de /api/send para la tarea de radio, troceado en tramas
+ */
+static void queueSendBody(AsyncWebServerRequest* request, const uint8_t* data, size_t remaining) {
+  uint32_t now = millis();
+  uint32_t nowUs = micros();
+
+  // Todo o nada: un mensaje a medias en la radio es peor que un 503. Este
+  // manejador es el único productor, así que los huecos vistos no se pierden
+  uint32_t frames = (remaining + BRIDGE_FRAME_MAX - 1) / BRIDGE_FRAME_MAX;
+  if (frames > webBridgeQueue.freeSlots()) {
+    request->send(503, "text/plain", "Cola llena");
+    return;
+  }
+
+  // Encolar para la tarea de radio, troceando mensajes largos
+  while (remaining > 0) {
+    size_t chunk = remaining > BRIDGE_FRAME_MAX ? BRIDGE_FRAME_MAX : remaining;
+    webBridgeQueue.push(data, chunk, now, nowUs);
+    data += chunk;
+    remaining -= chunk;
+  }
+  notifyRadioTask();
+  request->send(200, "text/plain", "OK");
+}
+
+void handleSendMessage(AsyncWebServerRequest* request) {
+  if (request->_tempObject != nullptr) {
+    queueSendBody(request, (const uint8_t*)request->_tempObject, request->contentLength());
+    return;
+  }
+  if (request->contentLength() > WEB_SEND_MAX_BODY) {
+    request->send(413, "text/plain", "Mensaje demasiado largo");
+    return;
+  }
+
+  // Un text/plain que empieza por "nombre=" (p.ej. "a=b") llega como parámetros
+  // de formulario y no pasa por handleSendMessageBody: recomponerlo. La
+  // petición libera _tempObject al terminar
+  uint8_t* body = (uint8_t*)malloc(WEB_SEND_MAX_BODY);
+  if (body == nullptr) {
+    request->send(503, "text/plain", "Sin memoria");
+    return;
+  }
+  request->_tempObject = body;
+  size_t len = 0;
+  for (size_t i = 0; i < request->params(); i++) {
+    const AsyncWebParameter* param = request->getParam(i);
+    if (!param->isPost() || param->isFile()) continue;
+    if (!appendSendBodyParam(param->name().c_str(), param->value().c_str(), body, WEB_SEND_MAX_BODY, len)) {
+      request->send(413, "text/plain", "Mensaje demasiado largo");
+      return;
     }
   }
-  base64Buffer[base64Len] = '\0';
-  
-  snprintf(jsonResponse, sizeof(jsonResponse), 
-    "{\"len\":%d,\"time\":%lu,\"data\":\"%s\"}",
-    bleMessageLen, bleMessageTime, base64Buffer);
-  
-  webServer.send(200, "application/json", jsonResponse);
-}
-
-void handleSendMessage() {
-  if (webServer.hasArg("plain")) {
-    String msg = webServer.arg("plain");
-    Serial2.write((uint8_t*)msg.c_str(), msg.length());
-    Serial2.flush();
-    webServer.send(200, "text/plain", "OK");
+
+  if (len > 0) {
+    queueSendBody(request, body, len);
   } else {
-    webServer.send(400, "text/plain", "No message");
+    request->send(400, "text/plain", "No message");
+  }
+}
+
+/**
+ * @brief Estadísticas del hub en JSON
+ * Sección "system": CPU y pila por tarea, idle por núcleo, heap y colas del puente
+ * Sección "inputs": flancos F1-F3 encolados, enviados, perdidos y descartados por antirrebote,
+ *   y lotes binarios del pulsador (eventos, notificaciones, secuencias perdidas)
+ * Sección "credits": control de flujo del puente BLE (concedido, recibido, pendiente, descartado, excesos)
+ * Sección "radioTx": dosificación hacia el APC220 (buffer estimado, esperas, uso del aire)
+ *   tramas en espera (cronos sustituidos) y entregadas a la UART pendientes de salir
+ * Sección "cache": aciertos/fallos de la caché de ficheros en RAM
+ * Sección "stream": conexiones SSE de /api/stream
+ * Sección "websocket": cola, descartes y latencia de envío por cliente
+ */
+void handleGetStats(AsyncWebServerRequest* request) {
+  String json;
+  json.reserve(1792);
+  char item[320];
+
+  SystemStats sys = getSystemStats();
+  snprintf(item, sizeof(item),
+           "{\"system\":{\"uptimeMs\":%u,\"sampleUs\":%u,\"idle\":[%d,%d],"
+           "\"heap\":{\"free\":%u,\"min\":%u,\"largest\":%u,\"fragmentation\":%u},"
+           "\"queues\":{\"ble\":%u,\"web\":%u,\"radioRx\":%u,\"wsPoolFree\":%u},\"tasks\":[",
+           (unsigned)sys.uptimeMs, (unsigned)sys.sampleUs,
+           sys.idlePercent[0] == 0xFF ? -1 : sys.idlePercent[0],
+           sys.idlePercent[1] == 0xFF ? -1 : sys.idlePercent[1],
+           (unsigned)sys.heapFree, (unsigned)sys.heapMin, (unsigned)sys.heapLargest, sys.heapFragPercent,
+           sys.bleQueueDepth, sys.webQueueDepth, sys.radioRxDepth, sys.wsPoolFree);
+  json += item;
+  for (uint8_t i = 0; i < sys.taskCount; i++) {
+    const TaskSample& t = sys.tasks[i];
+    snprintf(item, sizeof(item), "%s{\"name\":\"%s\",\"core\":%u,\"cpu\":%d,\"stackFree\":%u,\"allocs\":%ld}",
+             i ? "," : "", t.name, t.core, t.cpuPercent == 0xFF ? -1 : t.cpuPercent, t.stackFree,
+             sys.allocsCounted ? (long)t.allocs : -1L);
+    json += item;
+  }
+  json += "]},";
+
+  InputEventQueueStats edges = inputEdges.getStats();
+  PulsadorEventStats batch = pulsadorEvents.getStats();
+  snprintf(item, sizeof(item),
+           "\"inputs\":{\"edges\":%u,\"sent\":%u,\"overflows\":%u,\"maxDepth\":%u,\"debounced\":[%u,%u,%u],"
+           "\"batch\":{\"binary\":%s,\"payload\":%u,\"events\":%u,\"notifications\":%u,\"lost\":%u}},",
+           (unsigned)edges.pushed, (unsigned)edges.popped, (unsigned)edges.overflows, (unsigned)edges.maxDepth,
+           (unsigned)inputDebounced[0], (unsigned)inputDebounced[1], (unsigned)inputDebounced[2],
+           pulsadorBinaryEnabled() ? "true" : "false", (unsigned)pulsadorPayloadMax(),
+           (unsigned)batch.records, (unsigned)batch.notifications, (unsigned)batch.lost);
+  json += item;
+
+  BridgeCreditStats credits = bridgeCredits.getStats();
+  snprintf(item, sizeof(item),
+           "\"credits\":{\"byteLimit\":%u,\"frameLimit\":%u,\"maxWrite\":%u,\"received\":%u,"
+           "\"pending\":%u,\"dropped\":%u,\"notifications\":%u,\"overruns\":%u},",
+           (unsigned)credits.grant.byteLimit, (unsigned)credits.grant.frameLimit, (unsigned)credits.grant.maxWrite,
+           (unsigned)credits.receivedBytes, (unsigned)credits.pendingBytes, (unsigned)credits.droppedBytes,
+           (unsigned)credits.notifications, (unsigned)credits.overruns);
+  json += item;
+
+  RadioTxPacerStats tx = radioTxPacer.getStats(micros());
+  UartTxTrackerStats uart = getRadioTxTrackerStats();
+  RadioTxStagingStats staging = getRadioTxStagingStats();
+  snprintf(item, sizeof(item),
+           "\"radioTx\":{\"airBps\":%u,\"bufferLimit\":%u,\"level\":%u,\"peakLevel\":%u,\"bytes\":%u,"
+           "\"throttled\":%u,\"throttledMs\":%u,\"utilization\":%u,\"burstUtilization\":%u,"
+           "\"inFlight\":%u,\"maxInFlight\":%u,\"done\":%u,\"staged\":%u,\"coalesced\":%u},",
+           (unsigned)tx.airBps, (unsigned)tx.bufferLimit, (unsigned)tx.level, (unsigned)tx.peakLevel,
+           (unsigned)tx.bytes, (unsigned)tx.throttled, (unsigned)(tx.throttledUs / 1000),
+           (unsigned)tx.utilization, (unsigned)tx.burstUtilization, (unsigned)uart.inFlight,
+           (unsigned)uart.maxInFlight, (unsigned)uart.frames, (unsigned)staging.depth,
+           (unsigned)staging.coalesced);
+  json += item;
+
+  StaticCacheStats cache = getStaticCacheStats();
+  snprintf(item, sizeof(item),
+           "\"cache\":{\"hits\":%u,\"misses\":%u,\"evictions\":%u,\"bytesServed\":%llu,\"bytesUsed\":%u},",
+           (unsigned)cache.hits, (unsigned)cache.misses, (unsigned)cache.evictions,
+           (unsigned long long)cache.bytesServed, (unsigned)cache.bytesUsed);
+  json += item;
+
+  EventStreamStats stream = eventStreamGetStats();
+  snprintf(item, sizeof(item),
+           "\"stream\":{\"clients\":%u,\"avgQueued\":%u,\"frames\":%u,\"inputs\":%u,\"missed\":%u,\"inputDrops\":%u},",
+           (unsigned)stream.clients, (unsigned)stream.avgQueued, (unsigned)stream.frames,
+           (unsigned)stream.inputs, (unsigned)stream.missed, (unsigned)stream.inputDrops);
+  json += item;
+
+  snprintf(item, sizeof(item), "\"websocket\":{\"poolFree\":%u,\"poolExhausted\":%u,\"clients\":[",
+           (unsigned)wsFanoutPoolFree(), (unsigned)wsFanoutPoolExhausted());
+  json += item;
+
+  bool first = true;
+  for (uint8_t slot = 0; slot < WS_MAX_CLIENTS; slot++) {
+    WsClientStats c = wsFanoutGetStats(slot);
+    if (!c.connected && c.sent == 0 && c.kicked == 0) continue;
+    snprintf(item, sizeof(item),
+             "%s{\"id\":%u,\"connected\":%s,\"binary\":%s,\"depth\":%u,\"sent\":%u,"
+             "\"coalesced\":%u,\"dropped\":%u,\"kicked\":%u,\"busy\":%u,\"latencyAvgUs\":%u,"
+             "\"latencyMaxUs\":%u,\"sendMaxUs\":%u}",
+             first ? "" : ",", (unsigned)c.id, c.connected ? "true" : "false", c.binary ? "true" : "false",
+             c.depth, (unsigned)c.sent, (unsigned)c.coalesced, (unsigned)c.dropped,
+             (unsigned)c.kicked, (unsigned)c.busy, (unsigned)c.latencyAvgUs, (unsigned)c.latencyMaxUs,
+             (unsigned)c.sendMaxUs);
+    json += item;
+    first = false;
+  }
+  json += "]}}";
+
+  request->send(200, "application/json", json);
+}
+
+/**
+ * @brief Histogramas de latencia en formato de texto de Prometheus
+ */
+void handleGetMetrics(AsyncWebServerRequest* request) {
+  String text;
+  text.reserve(6144);
+  appendPrometheusMetrics(text);
+  request->send(200, "text/plain; version=0.0.4", text);
+}
+
+/**
+ * @brief Prueba de carga: POST arranca (?rate=&size=&kind=&displays=&seconds=&inputs=),
+ * POST ?stop=1 la detiene y GET devuelve el informe en curso o el de la última
+ */
+void handleLoadTest(AsyncWebServerRequest* request) {
+  if (request->method() == HTTP_POST) {
+    if (request->hasParam("stop")) {
+      loadGeneratorStop();
+    } else {
+      LoadGeneratorConfig config = loadGeneratorDefaults();
+      for (size_t i = 0; i < request->params(); i++) {
+        const AsyncWebParameter* param = request->getParam(i);
+        if (!loadGeneratorApplyArg(config, param->name().c_str(), param->value().c_str())) {
+          request->send(400, "text/plain", "Parametro no valido: " + param->name());
+          return;
+        }
+      }
+      loadGeneratorStart(config);
+      notifyBleTask();
+    }
   }
+
+  LoadGeneratorReport r = loadGeneratorGetReport();
+  char json[512];
+  snprintf(json, sizeof(json),
+           "{\"running\":%s,\"config\":{\"rate\":%u,\"size\":%u,\"kind\":\"%s\",\"displays\":%u,"
+           "\"seconds\":%u,\"inputs\":%u},\"elapsedMs\":%u,\"generated\":%u,\"delivered\":%u,"
+           "\"dropped\":%u,\"rejected\":%u,\"inputs\":%u,\"offeredFps\":%u,\"sustainedFps\":%u,"
+           "\"bridgeUs\":{\"p50\":%u,\"p99\":%u,\"max\":%u},\"broadcastUs\":{\"p50\":%u,\"p99\":%u,\"max\":%u}}",
+           r.running ? "true" : "false", (unsigned)r.config.rateHz, r.config.frameLen,
+           r.config.kind == LOAD_FRAME_TEXT ? "text" : "chrono", r.config.displays,
+           (unsigned)(r.config.durationMs / 1000), (unsigned)r.config.inputRateHz, (unsigned)r.elapsedMs,
+           (unsigned)r.generated, (unsigned)r.delivered, (unsigned)r.dropped, (unsigned)r.rejected,
+           (unsigned)r.inputs, (unsigned)r.offeredFps, (unsigned)r.sustainedFps,
+           (unsigned)r.bridgeP50Us, (unsigned)r.bridgeP99Us, (unsigned)r.bridgeMaxUs,
+           (unsigned)r.broadcastP50Us, (unsigned)r.broadcastP99Us, (unsigned)r.broadcastMaxUs);
+  request->send(200, "application/json", json);
 }
 
 /**
  * @brief Maneja eventos del WebSocket
+ * Corre en la tarea async_tcp, al llegar los datos; solo encola, no envía
+ * tramas del puente
  */
-void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length) {
+void onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                      void* arg, uint8_t* data, size_t len) {
+  (void)server;
+  uint32_t id = client->id();
   switch (type) {
-    case WStype_CONNECTED:
+    case WS_EVT_CONNECT:
+      // Por defecto JSON, para clientes antiguos
+      if (!wsFanoutClientConnected(id)) {
+        DEBUG_PRINTLN("WebSocket: too many clients, closing");
+        client->close();
+        break;
+      }
       DEBUG_PRINT("WebSocket client #");
-      DEBUG_PRINT(num);
+      DEBUG_PRINT(id);
       DEBUG_PRINTLN(" connected");
       break;
       
-    case WStype_DISCONNECTED:
+    case WS_EVT_DISCONNECT:
+      wsFanoutClientDisconnected(id);
       DEBUG_PRINT("WebSocket client #");
-      DEBUG_PRINT(num);
+      DEBUG_PRINT(id);
       DEBUG_PRINTLN(" disconnected");
       break;
       
-    case WStype_TEXT:
-      // Procesar mensajes JSON recibidos del cliente (simulador)
-      DEBUG_PRINT("WebSocket text from client #");
-      DEBUG_PRINT(num);
-      DEBUG_PRINT(": ");
-      DEBUG_PRINTLN((char*)payload);
-      
-      // El mensaje del simulador ya viene en formato JSON con base64
-      // Solo lo retransmitimos a todos los clientes
-      webSocket.broadcastTXT(payload, length);
-      break;
-      
-    case WStype_BIN:
-      // Datos binarios
-      DEBUG_PRINT("WebSocket binary from client #");
-      DEBUG_PRINT(num);
-      DEBUG_PRINT(": ");
-      DEBUG_PRINTLN(length);
+    case WS_EVT_DATA: {
+      // Solo mensajes completos en un único frame (los del simulador y el hello)
+      AwsFrameInfo* info = (AwsFrameInfo*)arg;
+      if (!info->final || info->index != 0 || info->len != len) break;
+
+      if (info->opcode == WS_TEXT) {
+        DEBUG_PRINT("WebSocket text from client #");
+        DEBUG_PRINT(id);
+        DEBUG_PRINT(": ");
+        DEBUG_PRINTLN(len);
+
+        // El mensaje del simulador ya viene en formato JSON con base64
+        // Solo lo retransmitimos a todos los clientes, a través de sus colas
+        if (!wsFanoutPublishText(data, len)) {
+          DEBUG_PRINTLN("WebSocket text dropped (too large or no free frames)");
+        }
+      } else if (info->opcode == WS_BINARY) {
+        // Negociación de formato: {'K', 0x00} = JSON, {'K', MESSAGE_BIN_VERSION} = binario
+        DEBUG_PRINT("WebSocket binary from client #");
+        DEBUG_PRINT(id);
+        DEBUG_PRINT(": ");
+        DEBUG_PRINTLN(len);
+
+        if (len == 2 && data[0] == WS_HELLO_MAGIC &&
+            (data[1] == WS_MODE_JSON || data[1] == WS_MODE_BINARY)) {
+          bool binary = (data[1] == WS_MODE_BINARY);
+          wsFanoutSetBinary(id, binary);
+          // Confirmar con el modo aceptado (se encola en el cliente, no bloquea)
+          uint8_t ack[2] = {WS_HELLO_MAGIC, data[1]};
+          client->binary(ack, sizeof(ack));
+          DEBUG_PRINT("WebSocket client #");
+          DEBUG_PRINT(id);
+          DEBUG_PRINTLN(binary ? " -> binary frames" : " -> JSON frames");
+        }
+      }
       break;
+    }
       
     default:
       break;
@@ -169,44 +617,40 @@ void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t lengt
 }
 
 /**
- * @brief Transmite el mensaje BLE a todos los clientes WebSocket conectados
- * Se llama cuando hay un nuevo mensaje disponible
+ * @brief Publica una trama del puente hacia la radio (BLE o /api/send) como
+ * última trama e histórico y la transmite a los clientes WebSocket y SSE
+ * Solo encola, el envío lo hace la tarea web (ws_fanout)
  */
-void broadcastBLEMessage() {
-  if (bleMessageLen <= 0) return;
-  
-  // Codificar a base64
-  char base64Buffer[400];
-  int base64Len = 0;
-  
-  const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  int i = 0;
-  while (i < bleMessageLen) {
-    uint8_t b1 = bleMessageBuffer[i++];
-    uint8_t b2 = (i < bleMessageLen) ? bleMessageBuffer[i++] : 0;
-    uint8_t b3 = (i < bleMessageLen) ? bleMessageBuffer[i++] : 0;
-    
-    base64Buffer[base64Len++] = alphabet[b1 >> 2];
-    base64Buffer[base64Len++] = alphabet[((b1 & 0x03) << 4) | (b2 >> 4)];
-    if (i - 1 < bleMessageLen) {
-      base64Buffer[base64Len++] = alphabet[((b2 & 0x0F) << 2) | (b3 >> 6)];
-    }
-    if (i < bleMessageLen) {
-      base64Buffer[base64Len++] = alphabet[b3 & 0x3F];
-    }
+void broadcastBridgeMessage(const BridgeFrame& frame) {
+  if (frame.len == 0) return;
+
+  // Codificar una sola vez: el mismo JSON sirve a /api/messages y a WebSocket.
+  // Las tramas de crono de un mismo display se sustituyen en colas lentas.
+  DisplayFrameInfo info;
+  uint32_t coalesceKey = 0;
+  if (parseDisplayFrame(frame.data, frame.len, info) && info.type == DISPLAY_TYPE_CHRONO) {
+    coalesceKey = info.address;
   }
-  base64Buffer[base64Len] = '\0';
-  
-  // Construir JSON
-  char jsonResponse[512];
-  snprintf(jsonResponse, sizeof(jsonResponse),
-    "{\"len\":%d,\"time\":%lu,\"data\":\"%s\"}",
-    bleMessageLen, bleMessageTime, base64Buffer);
-  
-  // Enviar a todos los clientes conectados
-  webSocket.broadcastTXT((uint8_t*)jsonResponse, strlen(jsonResponse));
-  
-  DEBUG_PRINT("Broadcasting BLE message to WebSocket clients (");
-  DEBUG_PRINT(bleMessageLen);
+  wsFanoutPublish(publishLatestMessage(frame), coalesceKey);
+  // Aunque el pool esté agotado, hay trama nueva para long-poll y SSE
+  notifyWebServerTask();
+
+  DEBUG_PRINT("Broadcasting bridge frame to WebSocket clients (");
+  DEBUG_PRINT(frame.len);
+  DEBUG_PRINTLN(" bytes)");
+}
+
+/**
+ * @brief Transmite una trama recibida por el APC220 a los clientes WebSocket
+ * Mismo formato que broadcastBridgeMessage() con "dir":"rx" (o MESSAGE_BIN_FLAG_RX)
+ */
+void broadcastRadioMessage(const BridgeFrame& frame) {
+  if (frame.len == 0) return;
+
+  wsFanoutPublish(encodeRadioMessage(frame), 0);
+  notifyWebServerTask();
+
+  DEBUG_PRINT("Broadcasting radio frame to WebSocket clients (");
+  DEBUG_PRINT(frame.len);
   DEBUG_PRINTLN(" bytes)");
 }
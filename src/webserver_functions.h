@@ -3,25 +3,35 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
-#include <WebSocketsServer.h>
-#include <DNSServer.h>
+#include <ESPAsyncWebServer.h>
+#include <AsyncUDP.h>
 #include <LittleFS.h>
+#include "bridge_queue.h"
 
 // Declaración de variables globales WebServer
-extern WebServer webServer;
-extern DNSServer dnsServer;
-extern WebSocketsServer webSocket;
+extern AsyncWebServer webServer;
+extern AsyncWebServer webSocketServer;
+extern AsyncWebSocket webSocket;
+
+// Cola de tramas enviadas desde /api/send (para el APC220)
+extern BridgeQueue webBridgeQueue;
 
 // Funciones de WebServer y WiFi
 void initWiFiAP();
 void initWebServer();
-void handleRoot();
-void handleNotFound();
-void handleStaticFile();
-void handleGetMessages();
-void handleSendMessage();
-void broadcastBLEMessage();
-void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
+void handleRoot(AsyncWebServerRequest* request);
+void handleNotFound(AsyncWebServerRequest* request);
+void handleStaticFile(AsyncWebServerRequest* request);
+void handleGetMessages(AsyncWebServerRequest* request);
+uint32_t serviceLongPolls();   // ms hasta el plazo más cercano (UINT32_MAX sin esperas)
+void handleSendMessage(AsyncWebServerRequest* request);
+void handleSendMessageBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
+void handleGetStats(AsyncWebServerRequest* request);
+void handleGetMetrics(AsyncWebServerRequest* request);
+void handleLoadTest(AsyncWebServerRequest* request);
+void broadcastBridgeMessage(const BridgeFrame& frame);
+void broadcastRadioMessage(const BridgeFrame& frame);
+void onWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                      void* arg, uint8_t* data, size_t len);
 
 #endif
@@ -0,0 +1,328 @@
+#include "ws_fanout.h"
+#include "task_functions.h"
+#include "latency_metrics.h"
+
+// Trama compartida entre colas (contador de referencias protegido por fanoutMux)
+struct WsFrame {
+  uint8_t refs;
+  uint32_t publishedUs;
+  uint32_t originUs;        // Llegada de la trama al hub (0 = sin medir)
+  uint32_t coalesceKey;
+  uint16_t jsonLen;
+  uint16_t binLen;          // 0 = solo JSON
+  char json[MESSAGE_JSON_MAX];
+  uint8_t bin[MESSAGE_BIN_MAX];
+};
+
+// Estado de cada cliente
+struct WsClient {
+  bool connected;
+  bool binary;
+  uint32_t id;              // Id de AsyncWebSocketClient
+  bool kick;                // Desconectar en el próximo servicio
+  WsFrame* queue[WS_CLIENT_QUEUE_DEPTH];
+  uint8_t head;
+  uint8_t count;
+  uint32_t dropsSinceSend;
+  uint64_t latencySumUs;
+  WsClientStats stats;
+};
+
+static AsyncWebSocket* server = nullptr;
+static WsFrame pool[WS_FANOUT_POOL_SIZE];
+static WsClient clients[WS_MAX_CLIENTS];
+static uint32_t poolExhausted = 0;
+static portMUX_TYPE fanoutMux = portMUX_INITIALIZER_UNLOCKED;
+
+// =============================
+// Helpers (llamar con fanoutMux tomado)
+// =============================
+static WsFrame* allocFrameLocked() {
+  for (int i = 0; i < WS_FANOUT_POOL_SIZE; i++) {
+    if (pool[i].refs == 0) {
+      pool[i].refs = 1;
+      return &pool[i];
+    }
+  }
+  return nullptr;
+}
+
+static WsClient* findClientLocked(uint32_t id) {
+  for (int slot = 0; slot < WS_MAX_CLIENTS; slot++) {
+    if (clients[slot].connected && clients[slot].id == id) return &clients[slot];
+  }
+  return nullptr;
+}
+
+static void releaseFrameLocked(WsFrame* frame) {
+  if (frame->refs > 0) frame->refs--;
+}
+
+static void clearQueueLocked(WsClient& client) {
+  while (client.count > 0) {
+    releaseFrameLocked(client.queue[client.head]);
+    client.head = (client.head + 1) % WS_CLIENT_QUEUE_DEPTH;
+    client.count--;
+  }
+  client.head = 0;
+}
+
+// Quita de la cola la posición i (0 = la más antigua) manteniendo el orden
+static void removeAtLocked(WsClient& client, uint8_t i) {
+  releaseFrameLocked(client.queue[(client.head + i) % WS_CLIENT_QUEUE_DEPTH]);
+  for (uint8_t j = i; j + 1 < client.count; j++) {
+    client.queue[(client.head + j) % WS_CLIENT_QUEUE_DEPTH] =
+        client.queue[(client.head + j + 1) % WS_CLIENT_QUEUE_DEPTH];
+  }
+  client.count--;
+}
+
+static void enqueueLocked(WsClient& client, WsFrame* frame) {
+  // Latest-value-wins: una trama de estado sustituye a la pendiente del mismo display
+  if (frame->coalesceKey != 0) {
+    for (uint8_t i = 0; i < client.count; i++) {
+      WsFrame* queued = client.queue[(client.head + i) % WS_CLIENT_QUEUE_DEPTH];
+      if (queued->coalesceKey == frame->coalesceKey) {
+        removeAtLocked(client, i);
+        client.stats.coalesced++;
+        break;
+      }
+    }
+  }
+
+  // Cola llena: descartar la más antigua; si se acumulan, el cliente va retrasado
+  if (client.count >= WS_CLIENT_QUEUE_DEPTH) {
+    removeAtLocked(client, 0);
+    client.stats.dropped++;
+    if (++client.dropsSinceSend >= WS_CLIENT_MAX_DROPS) {
+      client.kick = true;
+    }
+  }
+
+  client.queue[(client.head + client.count) % WS_CLIENT_QUEUE_DEPTH] = frame;
+  client.count++;
+  frame->refs++;
+}
+
+static void publishFrame(WsFrame* frame) {
+  portENTER_CRITICAL(&fanoutMux);
+  for (int slot = 0; slot < WS_MAX_CLIENTS; slot++) {
+    if (clients[slot].connected) {
+      enqueueLocked(clients[slot], frame);
+    }
+  }
+  // Soltar la referencia de la reserva
+  releaseFrameLocked(frame);
+  portEXIT_CRITICAL(&fanoutMux);
+
+  notifyWebServerTask();
+}
+
+static WsFrame* reserveFrame() {
+  portENTER_CRITICAL(&fanoutMux);
+  WsFrame* frame = allocFrameLocked();
+  if (frame == nullptr) poolExhausted++;
+  portEXIT_CRITICAL(&fanoutMux);
+  return frame;
+}
+
+// =============================
+// API
+// =============================
+void wsFanoutInit(AsyncWebSocket& ws) {
+  server = &ws;
+}
+
+bool wsFanoutClientConnected(uint32_t id) {
+  portENTER_CRITICAL(&fanoutMux);
+  WsClient* client = findClientLocked(id);
+  for (int slot = 0; client == nullptr && slot < WS_MAX_CLIENTS; slot++) {
+    if (!clients[slot].connected) client = &clients[slot];
+  }
+  if (client == nullptr) {
+    portEXIT_CRITICAL(&fanoutMux);
+    return false;
+  }
+  clearQueueLocked(*client);
+  uint32_t kicked = client->stats.kicked;
+  memset(&client->stats, 0, sizeof(client->stats));
+  client->stats.kicked = kicked;
+  client->id = id;
+  client->connected = true;
+  client->binary = false;  // JSON por defecto, para clientes antiguos
+  client->kick = false;
+  client->dropsSinceSend = 0;
+  client->latencySumUs = 0;
+  portEXIT_CRITICAL(&fanoutMux);
+  return true;
+}
+
+void wsFanoutClientDisconnected(uint32_t id) {
+  portENTER_CRITICAL(&fanoutMux);
+  // Un cliente desconectado por lento ya soltó su cola
+  WsClient* client = findClientLocked(id);
+  if (client != nullptr) {
+    client->connected = false;
+    client->kick = false;
+    clearQueueLocked(*client);
+  }
+  portEXIT_CRITICAL(&fanoutMux);
+}
+
+void wsFanoutSetBinary(uint32_t id, bool binary) {
+  portENTER_CRITICAL(&fanoutMux);
+  WsClient* client = findClientLocked(id);
+  if (client != nullptr) client->binary = binary;
+  portEXIT_CRITICAL(&fanoutMux);
+}
+
+bool wsFanoutPublish(const EncodedMessage& message, uint32_t coalesceKey) {
+  if (message.jsonLen > MESSAGE_JSON_MAX || message.binLen > MESSAGE_BIN_MAX) return false;
+
+  WsFrame* frame = reserveFrame();
+  if (frame == nullptr) return false;
+
+  // Copia fuera de la sección crítica: la trama reservada no es visible aún
+  frame->publishedUs = micros();
+  frame->originUs = message.stampUs;
+  frame->coalesceKey = coalesceKey;
+  frame->jsonLen = message.jsonLen;
+  frame->binLen = message.binLen;
+  memcpy(frame->json, message.json, message.jsonLen);
+  memcpy(frame->bin, message.bin, message.binLen);
+
+  publishFrame(frame);
+  return true;
+}
+
+bool wsFanoutPublishText(const uint8_t* payload, size_t length) {
+  if (length > MESSAGE_JSON_MAX) return false;
+
+  WsFrame* frame = reserveFrame();
+  if (frame == nullptr) return false;
+
+  frame->publishedUs = micros();
+  frame->originUs = 0;
+  frame->coalesceKey = 0;
+  frame->jsonLen = length;
+  frame->binLen = 0;
+  memcpy(frame->json, payload, length);
+
+  publishFrame(frame);
+  return true;
+}
+
+uint32_t wsFanoutService() {
+  if (server == nullptr) return UINT32_MAX;
+
+  bool pending = false;
+  for (uint8_t slot = 0; slot < WS_MAX_CLIENTS; slot++) {
+    WsClient& client = clients[slot];
+
+    // Como mucho una cola completa por cliente y pasada, para no acaparar la tarea
+    for (int n = 0; n < WS_CLIENT_QUEUE_DEPTH; n++) {
+      portENTER_CRITICAL(&fanoutMux);
+      if (!client.connected || client.count == 0) {
+        portEXIT_CRITICAL(&fanoutMux);
+        break;
+      }
+      uint32_t id = client.id;
+      // Retrasado: demasiados descartes o la trama más antigua lleva demasiado esperando
+      uint32_t ageUs = micros() - client.queue[client.head]->publishedUs;
+      if (client.kick || ageUs > (uint32_t)WS_CLIENT_STALL_MS * 1000) {
+        client.connected = false;
+        client.kick = false;
+        client.stats.kicked++;
+        clearQueueLocked(client);
+        portEXIT_CRITICAL(&fanoutMux);
+        DEBUG_PRINT("WebSocket client #");
+        DEBUG_PRINT(id);
+        DEBUG_PRINTLN(" too slow, disconnecting");
+        server->close(id);
+        break;
+      }
+      portEXIT_CRITICAL(&fanoutMux);
+
+      // Su cola de envío está llena: no esperar, seguir con el siguiente cliente
+      if (!server->availableForWrite(id)) {
+        portENTER_CRITICAL(&fanoutMux);
+        client.stats.busy++;
+        portEXIT_CRITICAL(&fanoutMux);
+        break;
+      }
+
+      portENTER_CRITICAL(&fanoutMux);
+      if (!client.connected || client.id != id || client.count == 0) {
+        portEXIT_CRITICAL(&fanoutMux);
+        break;
+      }
+      WsFrame* frame = client.queue[client.head];
+      client.head = (client.head + 1) % WS_CLIENT_QUEUE_DEPTH;
+      client.count--;
+      bool binary = client.binary && frame->binLen > 0;
+      portEXIT_CRITICAL(&fanoutMux);
+
+      // Solo encola en el cliente; el envío lo hace async_tcp
+      uint32_t start = micros();
+      bool sent = binary ? server->binary(id, frame->bin, frame->binLen)
+                         : server->text(id, frame->json, frame->jsonLen);
+      uint32_t end = micros();
+      uint32_t sendUs = end - start;
+      uint32_t latencyUs = end - frame->publishedUs;
+      if (sent && frame->originUs != 0) broadcastLatency.record(end - frame->originUs);
+
+      portENTER_CRITICAL(&fanoutMux);
+      releaseFrameLocked(frame);
+      if (sent) {
+        client.dropsSinceSend = 0;
+        client.stats.sent++;
+        client.latencySumUs += latencyUs;
+        if (latencyUs > client.stats.latencyMaxUs) client.stats.latencyMaxUs = latencyUs;
+        if (sendUs > client.stats.sendMaxUs) client.stats.sendMaxUs = sendUs;
+      } else {
+        client.stats.dropped++;
+      }
+      portEXIT_CRITICAL(&fanoutMux);
+      if (!sent) break;
+    }
+
+    portENTER_CRITICAL(&fanoutMux);
+    if (client.connected && client.count > 0) pending = true;
+    portEXIT_CRITICAL(&fanoutMux);
+  }
+
+  // AsyncWebSocket no avisa cuando un cliente vuelve a tener hueco: reintentar
+  // mientras quede algo, que además vence WS_CLIENT_STALL_MS a tiempo
+  return pending ? WS_BUSY_RETRY_MS : UINT32_MAX;
+}
+
+WsClientStats wsFanoutGetStats(uint8_t slot) {
+  WsClientStats stats;
+  memset(&stats, 0, sizeof(stats));
+  if (slot >= WS_MAX_CLIENTS) return stats;
+
+  portENTER_CRITICAL(&fanoutMux);
+  const WsClient& client = clients[slot];
+  stats = client.stats;
+  stats.connected = client.connected;
+  stats.binary = client.binary;
+  stats.id = client.id;
+  stats.depth = client.count;
+  stats.latencyAvgUs = client.stats.sent ? (uint32_t)(client.latencySumUs / client.stats.sent) : 0;
+  portEXIT_CRITICAL(&fanoutMux);
+  return stats;
+}
+
+uint32_t wsFanoutPoolFree() {
+  uint32_t free = 0;
+  portENTER_CRITICAL(&fanoutMux);
+  for (int i = 0; i < WS_FANOUT_POOL_SIZE; i++) {
+    if (pool[i].refs == 0) free++;
+  }
+  portEXIT_CRITICAL(&fanoutMux);
+  return free;
+}
+
+uint32_t wsFanoutPoolExhausted() {
+  return poolExhausted;
+}
@@ -0,0 +1,83 @@
+#ifndef WS_FANOUT_H
+#define WS_FANOUT_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "kroner_config.h"
+#include "message_store.h"
+
+// Estadísticas de un cliente WebSocket
+struct WsClientStats {
+  bool connected;
+  bool binary;
+  uint32_t id;             // Id de AsyncWebSocketClient
+  uint8_t depth;           // Tramas en cola
+  uint32_t sent;           // Tramas enviadas
+  uint32_t coalesced;      // Tramas sustituidas por una más reciente del mismo display
+  uint32_t dropped;        // Tramas descartadas por cola llena
+  uint32_t kicked;         // Desconexiones por ir retrasado
+  uint32_t busy;           // Pasadas saltadas con su cola de envío llena
+  uint32_t latencyAvgUs;   // Publicación -> envío (media)
+  uint32_t latencyMaxUs;   // Publicación -> envío (máximo)
+  uint32_t sendMaxUs;      // Duración máxima de un envío (solo encola en AsyncWebSocket)
+};
+
+/**
+ * @brief Reparto de tramas a clientes WebSocket con una cola por cliente
+ *
+ * Las tramas se codifican una vez y se comparten entre colas con contador de
+ * referencias. Los productores (tarea de radio, eventos WebSocket) solo
+ * encolan; la tarea web las pasa a AsyncWebSocket con wsFanoutService(), que
+ * no bloquea: un cliente cuya cola de envío (WS_MAX_QUEUED_MESSAGES) está
+ * llena se salta en esa pasada. Mientras tanto sus tramas de crono pendientes
+ * se sustituyen por la más reciente y, si la más antigua supera
+ * WS_CLIENT_STALL_MS o se acumulan descartes, se le desconecta.
+ */
+void wsFanoutInit(AsyncWebSocket& server);
+
+/**
+ * @brief Reserva una cola para un cliente nuevo (llamar desde onWebSocketEvent)
+ * @param id Id de AsyncWebSocketClient
+ * @return false si ya hay WS_MAX_CLIENTS (cerrar la conexión)
+ */
+bool wsFanoutClientConnected(uint32_t id);
+void wsFanoutClientDisconnected(uint32_t id);
+void wsFanoutSetBinary(uint32_t id, bool binary);
+
+/**
+ * @brief Encola una trama codificada para todos los clientes conectados
+ * @param message Trama codificada (se copia al pool)
+ * @param coalesceKey Clave de estado de display (0 = no sustituible)
+ * @return true si se encoló
+ */
+bool wsFanoutPublish(const EncodedMessage& message, uint32_t coalesceKey);
+
+/**
+ * @brief Encola un texto JSON ya formado para todos los clientes (sin formato binario)
+ */
+bool wsFanoutPublishText(const uint8_t* payload, size_t length);
+
+/**
+ * @brief Envía lo pendiente de cada cliente (solo desde la tarea web)
+ * @return ms hasta volver a llamarla (WS_BUSY_RETRY_MS si algún cliente sin
+ *         hueco se quedó con tramas, UINT32_MAX si basta con la notificación)
+ */
+uint32_t wsFanoutService();
+
+/**
+ * @brief Copia las estadísticas de una cola de cliente
+ * @param slot 0..WS_MAX_CLIENTS-1
+ */
+WsClientStats wsFanoutGetStats(uint8_t slot);
+
+/**
+ * @brief Tramas del pool sin usar
+ */
+uint32_t wsFanoutPoolFree();
+
+/**
+ * @brief Publicaciones perdidas por falta de tramas libres en el pool
+ */
+uint32_t wsFanoutPoolExhausted();
+
+#endif
@@ -0,0 +1,88 @@
+// Parámetros del APC220 (lib/APCSettings)
+
+#include <unity.h>
+#include <APCSettings.h>
+
+void setUp() {}
+void tearDown() {}
+
+static void test_parses_write_command() {
+  APCSettings s = {};
+  TEST_ASSERT_TRUE(apcParseSettings("WR 434000 3 9 3 0", s));
+  TEST_ASSERT_EQUAL_UINT32(434000, s.frequencyKHz);
+  TEST_ASSERT_EQUAL_UINT8(3, s.rfRate);
+  TEST_ASSERT_EQUAL_UINT8(9, s.power);
+  TEST_ASSERT_EQUAL_UINT8(3, s.uartRate);
+  TEST_ASSERT_EQUAL_UINT8(0, s.parity);
+}
+
+static void test_parses_module_response_and_bare_params() {
+  APCSettings s = {};
+  // Respuesta de "RD" tal como llega (espacios y fin de línea)
+  TEST_ASSERT_TRUE(apcParseSettings("  PARA 433500 4 5 6 2\r\n", s));
+  TEST_ASSERT_EQUAL_UINT32(433500, s.frequencyKHz);
+  TEST_ASSERT_EQUAL_UINT8(4, s.rfRate);
+  TEST_ASSERT_EQUAL_UINT8(5, s.power);
+  TEST_ASSERT_EQUAL_UINT8(6, s.uartRate);
+  TEST_ASSERT_EQUAL_UINT8(2, s.parity);
+
+  TEST_ASSERT_TRUE(apcParseSettings("470000 1 0 0 1", s));
+  TEST_ASSERT_EQUAL_UINT32(470000, s.frequencyKHz);
+  TEST_ASSERT_EQUAL_UINT8(1, s.rfRate);
+}
+
+static void test_rejects_missing_fields() {
+  APCSettings s = {};
+  TEST_ASSERT_FALSE(apcParseSettings("", s));
+  TEST_ASSERT_FALSE(apcParseSettings("PARA", s));
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 3 9 3", s));
+  TEST_ASSERT_FALSE(apcParseSettings("RD", s));
+}
+
+static void test_rejects_out_of_range_without_writing() {
+  APCSettings s = {434000, 3, 9, 3, 0};
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 0 9 3 0", s));   // RF 1-4
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 5 9 3 0", s));
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 3 10 3 0", s));  // Potencia 0-9
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 3 9 7 0", s));   // UART 0-6
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 3 9 3 3", s));   // Paridad 0-2
+  // Valores que no caben en uint8_t no deben colarse truncados
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 259 9 3 0", s));
+  TEST_ASSERT_FALSE(apcParseSettings("WR 434000 3 9 3 -1", s));
+
+  TEST_ASSERT_EQUAL_UINT32(434000, s.frequencyKHz);
+  TEST_ASSERT_EQUAL_UINT8(3, s.rfRate);
+  TEST_ASSERT_EQUAL_UINT8(9, s.power);
+  TEST_ASSERT_EQUAL_UINT8(3, s.uartRate);
+  TEST_ASSERT_EQUAL_UINT8(0, s.parity);
+}
+
+static void test_rf_rate_codes() {
+  TEST_ASSERT_EQUAL_UINT32(0, apcRfRateBps(0));
+  TEST_ASSERT_EQUAL_UINT32(2400, apcRfRateBps(1));
+  TEST_ASSERT_EQUAL_UINT32(4800, apcRfRateBps(2));
+  TEST_ASSERT_EQUAL_UINT32(9600, apcRfRateBps(3));
+  TEST_ASSERT_EQUAL_UINT32(19200, apcRfRateBps(4));
+  TEST_ASSERT_EQUAL_UINT32(0, apcRfRateBps(5));
+  TEST_ASSERT_EQUAL_UINT32(0, apcRfRateBps(255));
+}
+
+static void test_uart_rate_codes() {
+  static const uint32_t expected[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600};
+  for (uint8_t code = 0; code <= 6; code++) {
+    TEST_ASSERT_EQUAL_UINT32(expected[code], apcUartRateBps(code));
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, apcUartRateBps(7));
+  TEST_ASSERT_EQUAL_UINT32(0, apcUartRateBps(255));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parses_write_command);
+  RUN_TEST(test_parses_module_response_and_bare_params);
+  RUN_TEST(test_rejects_missing_fields);
+  RUN_TEST(test_rejects_out_of_range_without_writing);
+  RUN_TEST(test_rf_rate_codes);
+  RUN_TEST(test_uart_rate_codes);
+  return UNITY_END();
+}
@@ -0,0 +1,73 @@
+// Codificador base64 de tablas (src/base64_codec) frente a los vectores de
+// RFC 4648 y al bucle byte a byte de referencia (native/include/base64_baseline.h)
+
+#include <unity.h>
+#include <base64_baseline.h>
+#include "base64_codec.h"
+#include "kroner_config.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void checkEncode(const char* input, const char* expected) {
+  char out[64];
+  size_t len = base64Encode((const uint8_t*)input, strlen(input), out);
+  TEST_ASSERT_EQUAL_STRING(expected, out);
+  TEST_ASSERT_EQUAL_UINT32(strlen(expected), len);
+  TEST_ASSERT_EQUAL_UINT32(base64EncodedLength(strlen(input)), len);
+}
+
+static void test_rfc4648_vectors() {
+  checkEncode("", "");
+  checkEncode("f", "Zg==");
+  checkEncode("fo", "Zm8=");
+  checkEncode("foo", "Zm9v");
+  checkEncode("foob", "Zm9vYg==");
+  checkEncode("fooba", "Zm9vYmE=");
+  checkEncode("foobar", "Zm9vYmFy");
+}
+
+static void test_every_byte_value() {
+  // Cada byte en cada posición del grupo de 3 y las dos colas con relleno
+  uint8_t in[258];
+  for (size_t i = 0; i < sizeof(in); i++) in[i] = (uint8_t)i;
+  for (size_t shift = 0; shift < 3; shift++) {
+    for (size_t len = 256; len <= 258 - shift; len++) {
+      char table[base64EncodedLength(258) + 1];
+      char baseline[base64EncodedLength(258) + 1];
+      size_t a = base64Encode(in + shift, len, table);
+      size_t b = base64EncodeBaseline(in + shift, len, baseline);
+      TEST_ASSERT_EQUAL_UINT32(b, a);
+      TEST_ASSERT_EQUAL_STRING(baseline, table);
+    }
+  }
+}
+
+static void test_matches_baseline_for_all_frame_lengths() {
+  uint8_t in[BRIDGE_FRAME_MAX + 1];
+  uint32_t x = 0x12345678;
+  for (size_t i = 0; i < sizeof(in); i++) {
+    x = x * 1103515245 + 12345;
+    in[i] = (uint8_t)(x >> 16);
+  }
+  for (size_t len = 0; len <= sizeof(in); len++) {
+    char table[base64EncodedLength(sizeof(in)) + 2];
+    char baseline[base64EncodedLength(sizeof(in)) + 2];
+    memset(table, '#', sizeof(table));
+    size_t a = base64Encode(in, len, table);
+    size_t b = base64EncodeBaseline(in, len, baseline);
+    TEST_ASSERT_EQUAL_UINT32(base64EncodedLength(len), a);
+    TEST_ASSERT_EQUAL_UINT32(b, a);
+    TEST_ASSERT_EQUAL_STRING(baseline, table);
+    // Nada escrito más allá del '\0'
+    TEST_ASSERT_EQUAL_UINT8('#', (uint8_t)table[a + 1]);
+  }
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rfc4648_vectors);
+  RUN_TEST(test_every_byte_value);
+  RUN_TEST(test_matches_baseline_for_all_frame_lengths);
+  return UNITY_END();
+}
@@ -0,0 +1,248 @@
+// Control de flujo por créditos del puente BLE (src/bridge_credits): límites
+// acumulados que solo crecen, cuándo se notifica y que un teléfono que los
+// respeta nunca pierde tramas en bleBridgeQueue
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "bridge_credits.h"
+#include "bridge_queue.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_first_grant_after_reset() {
+  BridgeCredits c;
+  c.reset(244);
+  BridgeCreditGrant g;
+  TEST_ASSERT_TRUE(c.update(BridgeQueue::CAPACITY, false, g));
+  TEST_ASSERT_EQUAL_UINT32(BRIDGE_CREDIT_WINDOW_BYTES, g.byteLimit);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, g.frameLimit);
+  TEST_ASSERT_EQUAL_UINT32(244, g.maxWrite);
+  // Sin cambios no se vuelve a notificar, salvo forzado
+  TEST_ASSERT_FALSE(c.update(BridgeQueue::CAPACITY, false, g));
+  TEST_ASSERT_TRUE(c.update(BridgeQueue::CAPACITY, true, g));
+  TEST_ASSERT_EQUAL_UINT32(2, c.getStats().notifications);
+}
+
+static void test_pack_layout() {
+  BridgeCreditGrant g = {0x01020304, 0x0A0B0C0D, 0x00F4};
+  uint8_t out[BRIDGE_CREDITS_LEN];
+  TEST_ASSERT_EQUAL_UINT32(BRIDGE_CREDITS_LEN, packBridgeCredits(g, out));
+  const uint8_t expected[BRIDGE_CREDITS_LEN] = {BRIDGE_CREDITS_VERSION, 0, 0xF4, 0x00,
+                                                0x04, 0x03, 0x02, 0x01, 0x0D, 0x0C, 0x0B, 0x0A};
+  TEST_ASSERT_EQUAL_MEMORY(expected, out, BRIDGE_CREDITS_LEN);
+}
+
+static void test_limits_never_shrink() {
+  BridgeCredits c;
+  c.reset(244);
+  BridgeCreditGrant g;
+  c.update(BridgeQueue::CAPACITY, false, g);
+
+  // El teléfono gasta créditos y la cola se llena: los límites no bajan
+  for (int i = 0; i < 4; i++) c.onReceived(200);
+  c.update(BridgeQueue::CAPACITY - 4, true, g);
+  TEST_ASSERT_EQUAL_UINT32(BRIDGE_CREDIT_WINDOW_BYTES, g.byteLimit);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, g.frameLimit);
+  c.update(0, true, g);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, g.frameLimit);
+
+  // Lo que sale por la UART abre la ventana de bytes
+  c.onDrained(400);
+  c.update(BridgeQueue::CAPACITY - 2, true, g);
+  TEST_ASSERT_EQUAL_UINT32(800 + BRIDGE_CREDIT_WINDOW_BYTES - 400, g.byteLimit);
+  TEST_ASSERT_EQUAL_UINT32(4 + BridgeQueue::CAPACITY - 2, g.frameLimit);
+  TEST_ASSERT_EQUAL_UINT32(400, c.getStats().pendingBytes);
+}
+
+static void test_small_progress_is_batched() {
+  BridgeCredits c;
+  c.reset(100);
+  BridgeCreditGrant g;
+  c.update(BridgeQueue::CAPACITY, false, g);
+
+  c.onReceived(100);
+  c.onReceived(100);
+  c.onDrained(100);
+  // +100 bytes y +1 escritura: poco avance, el teléfono no está parado
+  TEST_ASSERT_FALSE(c.update(BridgeQueue::CAPACITY - 1, false, g));
+  c.onDrained(100);
+  // Todo transmitido: se notifica para que el teléfono no espere
+  TEST_ASSERT_TRUE(c.update(BridgeQueue::CAPACITY, false, g));
+  TEST_ASSERT_EQUAL_UINT32(200 + BRIDGE_CREDIT_WINDOW_BYTES, g.byteLimit);
+}
+
+static void test_stalled_phone_gets_notified() {
+  BridgeCredits c;
+  c.reset(200);
+  BridgeCreditGrant g;
+  c.update(BridgeQueue::CAPACITY, false, g);
+  // Gasta casi toda la ventana: le quedan menos de maxWrite bytes
+  for (int i = 0; i < 5; i++) c.onReceived(200);
+  c.onDrained(200);
+  TEST_ASSERT_TRUE(c.update(BridgeQueue::CAPACITY, false, g));
+  TEST_ASSERT_EQUAL_UINT32(1000 + BRIDGE_CREDIT_WINDOW_BYTES - 800, g.byteLimit);
+}
+
+static void test_overruns_and_foreign_drains() {
+  BridgeCredits c;
+  c.reset(244);
+  BridgeCreditGrant g;
+  c.update(2, false, g);
+  c.onReceived(10);
+  c.onReceived(10);
+  TEST_ASSERT_EQUAL_UINT32(0, c.getStats().overruns);
+  c.onReceived(10);   // Tercera escritura con dos concedidas
+  TEST_ASSERT_EQUAL_UINT32(1, c.getStats().overruns);
+
+  // Tramas del generador de carga vaciadas por la misma cola: no cuentan de más
+  c.onDrained(1000);
+  BridgeCreditStats s = c.getStats();
+  TEST_ASSERT_EQUAL_UINT32(30, s.drainedBytes);
+  c.update(BridgeQueue::CAPACITY, false, g);
+  TEST_ASSERT_EQUAL_UINT32(0, c.getStats().pendingBytes);
+}
+
+static void test_dropped_frames_reopen_the_window() {
+  // Tramas sacadas de la cola al desbordar: sin devolverlas, la ventana
+  // quedaría reducida hasta la próxima conexión
+  BridgeCredits c;
+  c.reset(244);
+  BridgeCreditGrant g;
+  c.update(BridgeQueue::CAPACITY, false, g);
+  for (int i = 0; i < 4; i++) c.onReceived(200);
+  c.onDrained(200);
+  c.onDropped(400);
+  c.update(BridgeQueue::CAPACITY, true, g);
+  BridgeCreditStats s = c.getStats();
+  TEST_ASSERT_EQUAL_UINT32(400, s.droppedBytes);
+  TEST_ASSERT_EQUAL_UINT32(200, s.pendingBytes);
+  TEST_ASSERT_EQUAL_UINT32(800 + BRIDGE_CREDIT_WINDOW_BYTES - 200, g.byteLimit);
+
+  // Lo que queda sale por la UART: ventana completa otra vez
+  c.onDrained(200);
+  c.update(BridgeQueue::CAPACITY, true, g);
+  TEST_ASSERT_EQUAL_UINT32(0, c.getStats().pendingBytes);
+  TEST_ASSERT_EQUAL_UINT32(800 + BRIDGE_CREDIT_WINDOW_BYTES, g.byteLimit);
+
+  // Descartes del generador de carga no devuelven más de lo recibido
+  c.onDropped(1000);
+  c.update(BridgeQueue::CAPACITY, true, g);
+  TEST_ASSERT_EQUAL_UINT32(800, c.getStats().drainedBytes);
+}
+
+static void test_overrun_phone_counts_as_stalled() {
+  // Recibido por delante del límite notificado: la resta sin signo daba un
+  // número enorme y la concesión no se notificaba por estar parado
+  BridgeCredits c;
+  c.reset(100);
+  BridgeCreditGrant g;
+  c.update(BridgeQueue::CAPACITY, false, g);
+  for (uint32_t sent = 0; sent < BRIDGE_CREDIT_WINDOW_BYTES + 100; sent += 100) c.onReceived(100);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, c.getStats().overruns);
+
+  // Poco avance (< BRIDGE_CREDIT_NOTIFY_BYTES) con datos aún pendientes
+  c.onDrained(100);
+  TEST_ASSERT_TRUE(c.update(BridgeQueue::CAPACITY, false, g));
+}
+
+static void test_lost_notification_never_over_grants() {
+  // El teléfono se queda con una concesión vieja: como los límites son
+  // acumulados, respetarla nunca lleva a escribir de más
+  BridgeCredits c;
+  c.reset(244);
+  BridgeCreditGrant old, latest;
+  c.update(BridgeQueue::CAPACITY, false, old);
+  for (int i = 0; i < 4; i++) c.onReceived(244);
+  c.onDrained(976);
+  c.update(BridgeQueue::CAPACITY, false, latest);   // Se pierde por el camino
+  TEST_ASSERT_GREATER_THAN_UINT32(old.byteLimit, latest.byteLimit);
+
+  uint32_t sentBytes = 976, sentFrames = 4;
+  while (sentBytes + 10 <= old.byteLimit && sentFrames + 1 <= old.frameLimit) {
+    c.onReceived(10);
+    sentBytes += 10;
+    sentFrames++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, c.getStats().overruns);
+}
+
+static void test_credit_honouring_phone_loses_nothing() {
+  // Teléfono que respeta las concesiones frente a la tarea de radio, en dos
+  // hilos: ninguna escritura rechazada por la cola, ni fuera de crédito, y
+  // todas las tramas llegan en orden
+  const uint32_t frames = 100000;
+  BridgeQueue queue(BRIDGE_DROP_NEWEST);
+  BridgeCredits credits;
+  credits.reset(244);
+  std::atomic<uint32_t> byteLimit(0), frameLimit(0);
+  auto publish = [&](bool force) {
+    BridgeCreditGrant grant;
+    if (credits.update(BridgeQueue::CAPACITY - queue.size(), force, grant)) {
+      frameLimit.store(grant.frameLimit, std::memory_order_release);
+      byteLimit.store(grant.byteLimit, std::memory_order_release);
+    }
+  };
+  publish(true);
+
+  std::atomic<bool> done(false);
+  uint32_t received = 0, outOfOrder = 0;
+  std::thread radio([&]() {
+    BridgeFrame f;
+    for (;;) {
+      if (queue.pop(f)) {
+        uint32_t seq;
+        memcpy(&seq, f.data, 4);
+        if (seq != received) outOfOrder++;
+        received++;
+        credits.onDrained(f.len);
+        publish(false);
+      } else if (done.load(std::memory_order_acquire)) {
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint8_t data[BRIDGE_FRAME_MAX] = {0};
+  uint32_t sentBytes = 0, rejected = 0;
+  for (uint32_t i = 0; i < frames; i++) {
+    size_t len = 20 + (i * 37) % 225;
+    while ((int32_t)(byteLimit.load(std::memory_order_acquire) - (sentBytes + len)) < 0 ||
+           (int32_t)(frameLimit.load(std::memory_order_acquire) - (i + 1)) < 0) {
+      std::this_thread::yield();
+    }
+    memcpy(data, &i, 4);
+    if (!queue.push(data, len, 0, 0)) rejected++;
+    credits.onReceived(len);
+    sentBytes += len;
+  }
+  while (queue.size() > 0) std::this_thread::yield();
+  done.store(true, std::memory_order_release);
+  radio.join();
+
+  BridgeCreditStats s = credits.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, rejected);
+  TEST_ASSERT_EQUAL_UINT32(0, queue.getStats().droppedNewest);
+  TEST_ASSERT_EQUAL_UINT32(0, s.overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(frames, received);
+  TEST_ASSERT_EQUAL_UINT32(sentBytes, s.drainedBytes);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_grant_after_reset);
+  RUN_TEST(test_pack_layout);
+  RUN_TEST(test_limits_never_shrink);
+  RUN_TEST(test_small_progress_is_batched);
+  RUN_TEST(test_stalled_phone_gets_notified);
+  RUN_TEST(test_overruns_and_foreign_drains);
+  RUN_TEST(test_dropped_frames_reopen_the_window);
+  RUN_TEST(test_overrun_phone_counts_as_stalled);
+  RUN_TEST(test_lost_notification_never_over_grants);
+  RUN_TEST(test_credit_honouring_phone_loses_nothing);
+  return UNITY_END();
+}
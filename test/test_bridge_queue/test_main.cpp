@@ -0,0 +1,226 @@
+// Cola SPSC del puente (src/bridge_queue): orden, recuento e integridad de las
+// tramas con las dos políticas de descarte, también con productor y
+// consumidor en hilos distintos
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "bridge_queue.h"
+
+static const uint32_t STRESS_FRAMES = 400000;
+
+void setUp() {}
+void tearDown() {}
+
+// Trama i: número de secuencia (4 bytes LE) y relleno que depende de él, con
+// longitud variable para que una copia mezclada de dos tramas se note
+static size_t makeFrame(uint32_t seq, uint8_t* out) {
+  size_t len = 4 + seq % (BRIDGE_FRAME_MAX - 3);
+  memcpy(out, &seq, 4);
+  for (size_t i = 4; i < len; i++) out[i] = (uint8_t)(seq * 31 + i);
+  return len;
+}
+
+// Devuelve la secuencia de la trama, o UINT32_MAX si no es la que se encoló
+static uint32_t checkFrame(const BridgeFrame& f) {
+  if (f.len < 4 || f.len > BRIDGE_FRAME_MAX) return UINT32_MAX;
+  uint32_t seq;
+  memcpy(&seq, f.data, 4);
+  uint8_t expected[BRIDGE_FRAME_MAX];
+  if (makeFrame(seq, expected) != f.len) return UINT32_MAX;
+  if (memcmp(expected, f.data, f.len) != 0) return UINT32_MAX;
+  if (f.time != seq || f.stampUs != ~seq) return UINT32_MAX;
+  return seq;
+}
+
+static bool pushSeq(BridgeQueue& q, uint32_t seq) {
+  uint8_t data[BRIDGE_FRAME_MAX];
+  size_t len = makeFrame(seq, data);
+  return q.push(data, len, seq, ~seq);
+}
+
+static void test_rejects_invalid_length() {
+  BridgeQueue q(BRIDGE_DROP_OLDEST);
+  uint8_t data[BRIDGE_FRAME_MAX + 1] = {0};
+  TEST_ASSERT_FALSE(q.push(data, 0, 0));
+  TEST_ASSERT_FALSE(q.push(data, BRIDGE_FRAME_MAX + 1, 0));
+  TEST_ASSERT_FALSE(q.push(nullptr, 4, 0));
+  TEST_ASSERT_TRUE(q.push(data, BRIDGE_FRAME_MAX, 0));
+  BridgeQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(3, s.rejected);
+  TEST_ASSERT_EQUAL_UINT32(1, s.pushed);
+}
+
+static void test_drop_newest_keeps_first_frames() {
+  BridgeQueue q(BRIDGE_DROP_NEWEST);
+  const uint32_t extra = 5;
+  uint32_t accepted = 0;
+  for (uint32_t i = 0; i < BridgeQueue::CAPACITY + extra; i++) {
+    if (pushSeq(q, i)) accepted++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, accepted);
+
+  BridgeFrame f;
+  for (uint32_t i = 0; i < BridgeQueue::CAPACITY; i++) {
+    TEST_ASSERT_TRUE(q.pop(f));
+    TEST_ASSERT_EQUAL_UINT32(i, checkFrame(f));
+  }
+  TEST_ASSERT_FALSE(q.pop(f));
+
+  BridgeQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(extra, s.droppedNewest);
+  TEST_ASSERT_EQUAL_UINT32(0, s.droppedOldest);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, s.maxDepth);
+  TEST_ASSERT_EQUAL_UINT32(0, s.depth);
+}
+
+static void test_free_slots_track_depth() {
+  BridgeQueue q(BRIDGE_DROP_OLDEST);
+  BridgeFrame f;
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, q.freeSlots());
+  for (uint32_t i = 0; i < BridgeQueue::CAPACITY; i++) {
+    TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY - i, q.freeSlots());
+    pushSeq(q, i);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, q.freeSlots());
+  // Con la cola llena, descartar la más antigua no deja hueco
+  pushSeq(q, BridgeQueue::CAPACITY);
+  TEST_ASSERT_EQUAL_UINT32(0, q.freeSlots());
+  TEST_ASSERT_TRUE(q.pop(f));
+  TEST_ASSERT_EQUAL_UINT32(1, q.freeSlots());
+}
+
+static void test_drop_oldest_keeps_last_frames() {
+  BridgeQueue q(BRIDGE_DROP_OLDEST);
+  const uint32_t extra = 5;
+  for (uint32_t i = 0; i < BridgeQueue::CAPACITY + extra; i++) {
+    TEST_ASSERT_TRUE(pushSeq(q, i));
+  }
+
+  BridgeFrame f;
+  for (uint32_t i = extra; i < BridgeQueue::CAPACITY + extra; i++) {
+    TEST_ASSERT_TRUE(q.pop(f));
+    TEST_ASSERT_EQUAL_UINT32(i, checkFrame(f));
+  }
+  TEST_ASSERT_FALSE(q.pop(f));
+
+  BridgeQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(extra, s.droppedOldest);
+  // Los bytes de las tramas descartadas, para devolver sus créditos
+  uint32_t droppedBytes = 0;
+  uint8_t data[BRIDGE_FRAME_MAX];
+  for (uint32_t i = 0; i < extra; i++) droppedBytes += makeFrame(i, data);
+  TEST_ASSERT_EQUAL_UINT32(droppedBytes, s.droppedOldestBytes);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY + extra, s.pushed);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, s.popped);
+}
+
+// Resultado del consumidor en los tests con dos hilos
+struct ConsumerResult {
+  uint32_t received;
+  uint32_t corrupted;     // Tramas que no coinciden con ninguna encolada
+  uint32_t outOfOrder;    // Secuencia no creciente
+  uint32_t gaps;          // Tramas saltadas (suma de huecos en la secuencia)
+  uint32_t last;          // Última secuencia recibida
+};
+
+// Consume hasta que el productor termina y la cola queda vacía. Cada 256
+// tramas se para un momento para que la cola se llene y actúe la política
+static ConsumerResult consume(BridgeQueue& q, std::atomic<bool>& producerDone) {
+  ConsumerResult r = {0, 0, 0, 0, UINT32_MAX};
+  uint32_t next = 0;
+  BridgeFrame f;
+  for (;;) {
+    if (!q.pop(f)) {
+      if (producerDone.load(std::memory_order_acquire) && q.size() == 0) break;
+      std::this_thread::yield();
+      continue;
+    }
+    uint32_t seq = checkFrame(f);
+    if (seq == UINT32_MAX) {
+      r.corrupted++;
+    } else if (seq < next) {
+      r.outOfOrder++;
+    } else {
+      r.gaps += seq - next;
+      next = seq + 1;
+      r.last = seq;
+    }
+    if (++r.received % 256 == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  }
+  return r;
+}
+
+static void test_stress_drop_newest_two_threads() {
+  BridgeQueue q(BRIDGE_DROP_NEWEST);
+  std::atomic<bool> done(false);
+  uint32_t rejectedPushes = 0;
+
+  // El productor reintenta cada trama rechazada: deben llegar todas, en orden
+  std::thread producer([&]() {
+    for (uint32_t seq = 0; seq < STRESS_FRAMES; seq++) {
+      while (!pushSeq(q, seq)) {
+        rejectedPushes++;
+        std::this_thread::yield();
+      }
+    }
+    done.store(true, std::memory_order_release);
+  });
+  ConsumerResult r = consume(q, done);
+  producer.join();
+
+  BridgeQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, r.corrupted);
+  TEST_ASSERT_EQUAL_UINT32(0, r.outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(0, r.gaps);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, r.received);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES - 1, r.last);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, s.pushed);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, s.popped);
+  TEST_ASSERT_EQUAL_UINT32(rejectedPushes, s.droppedNewest);
+  TEST_ASSERT_EQUAL_UINT32(0, s.droppedOldest);
+  // La cola llegó a llenarse: la política se ejercitó de verdad
+  TEST_ASSERT_GREATER_THAN_UINT32(0, s.droppedNewest);
+}
+
+static void test_stress_drop_oldest_two_threads() {
+  // El productor adelanta tail con un CAS mientras el consumidor copia y
+  // confirma con otro: ninguna copia mezclada puede darse por buena
+  BridgeQueue q(BRIDGE_DROP_OLDEST);
+  std::atomic<bool> done(false);
+
+  std::thread producer([&]() {
+    for (uint32_t seq = 0; seq < STRESS_FRAMES; seq++) {
+      pushSeq(q, seq);
+    }
+    done.store(true, std::memory_order_release);
+  });
+  ConsumerResult r = consume(q, done);
+  producer.join();
+
+  BridgeQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, r.corrupted);
+  TEST_ASSERT_EQUAL_UINT32(0, r.outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, s.pushed);
+  TEST_ASSERT_EQUAL_UINT32(s.popped, r.received);
+  // Cada trama se entregó o se contó como descartada, exactamente una vez
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES, r.received + s.droppedOldest);
+  // La más nueva nunca se descarta: los huecos son justo las descartadas
+  TEST_ASSERT_EQUAL_UINT32(STRESS_FRAMES - 1, r.last);
+  TEST_ASSERT_EQUAL_UINT32(s.droppedOldest, r.gaps);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, s.droppedOldest);
+  TEST_ASSERT_EQUAL_UINT32(0, s.droppedNewest);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rejects_invalid_length);
+  RUN_TEST(test_drop_newest_keeps_first_frames);
+  RUN_TEST(test_drop_oldest_keeps_last_frames);
+  RUN_TEST(test_free_slots_track_depth);
+  RUN_TEST(test_stress_drop_newest_two_threads);
+  RUN_TEST(test_stress_drop_oldest_two_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,125 @@
+// Respuestas DNS del portal cautivo (src/captive_dns): todo nombre resuelve a
+// la IP del AP y nada mal formado recibe respuesta
+
+#include <unity.h>
+#include <string.h>
+#include "captive_dns.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const uint8_t AP_IP[4] = {192, 168, 4, 1};
+
+// Consulta estándar con RD para "name" (en formato de etiquetas) y tipo qtype
+static size_t makeQuery(uint8_t* q, const char* labels, size_t labelsLen, uint16_t qtype, bool edns = false) {
+  const uint8_t header[12] = {0xBE, 0xEF, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, (uint8_t)(edns ? 1 : 0)};
+  memcpy(q, header, 12);
+  memcpy(q + 12, labels, labelsLen);
+  size_t pos = 12 + labelsLen;
+  q[pos++] = (uint8_t)(qtype >> 8);
+  q[pos++] = (uint8_t)qtype;
+  q[pos++] = 0;
+  q[pos++] = 1;   // IN
+  if (edns) {
+    const uint8_t opt[11] = {0, 0, 41, 0x10, 0, 0, 0, 0, 0, 0, 0};
+    memcpy(q + pos, opt, sizeof(opt));
+    pos += sizeof(opt);
+  }
+  return pos;
+}
+
+static const char NAME[] = "\x07" "example" "\x03" "com";   // + raíz
+static const size_t NAME_LEN = sizeof(NAME);                  // Incluye el 0 final
+
+static void test_a_query_resolves_to_ap() {
+  uint8_t q[64], r[CAPTIVE_DNS_MAX_PACKET];
+  size_t qlen = makeQuery(q, NAME, NAME_LEN, 1);
+  size_t rlen = captiveDnsReply(q, qlen, AP_IP, 60, r, sizeof(r));
+  TEST_ASSERT_EQUAL_UINT32(qlen + 16, rlen);
+
+  TEST_ASSERT_EQUAL_UINT8(0xBE, r[0]);
+  TEST_ASSERT_EQUAL_UINT8(0xEF, r[1]);
+  TEST_ASSERT_EQUAL_UINT8(0x85, r[2]);   // QR, AA, RD
+  TEST_ASSERT_EQUAL_UINT8(0x80, r[3]);   // RA, NOERROR
+  const uint8_t counts[8] = {0, 1, 0, 1, 0, 0, 0, 0};
+  TEST_ASSERT_EQUAL_MEMORY(counts, r + 4, 8);
+  TEST_ASSERT_EQUAL_MEMORY(q + 12, r + 12, qlen - 12);
+
+  const uint8_t answer[16] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 192, 168, 4, 1};
+  TEST_ASSERT_EQUAL_MEMORY(answer, r + qlen, 16);
+}
+
+static void test_other_types_get_empty_answer() {
+  uint8_t q[64], r[CAPTIVE_DNS_MAX_PACKET];
+  size_t qlen = makeQuery(q, NAME, NAME_LEN, 28);   // AAAA
+  size_t rlen = captiveDnsReply(q, qlen, AP_IP, 60, r, sizeof(r));
+  TEST_ASSERT_EQUAL_UINT32(qlen, rlen);
+  TEST_ASSERT_EQUAL_UINT8(0x80, r[3]);
+  TEST_ASSERT_EQUAL_UINT8(0, r[7]);   // Sin respuestas
+
+  qlen = makeQuery(q, NAME, NAME_LEN, 255);        // ANY
+  TEST_ASSERT_EQUAL_UINT32(qlen + 16, captiveDnsReply(q, qlen, AP_IP, 60, r, sizeof(r)));
+}
+
+static void test_edns_record_is_not_copied() {
+  uint8_t q[64], r[CAPTIVE_DNS_MAX_PACKET];
+  size_t qlen = makeQuery(q, NAME, NAME_LEN, 1, true);
+  size_t rlen = captiveDnsReply(q, qlen, AP_IP, 60, r, sizeof(r));
+  TEST_ASSERT_EQUAL_UINT32(qlen - 11 + 16, rlen);
+  TEST_ASSERT_EQUAL_UINT8(0, r[11]);   // ARCOUNT
+}
+
+static void test_non_query_opcode_gets_notimp() {
+  uint8_t q[64], r[CAPTIVE_DNS_MAX_PACKET];
+  size_t qlen = makeQuery(q, NAME, NAME_LEN, 1);
+  q[2] = 0x28;   // UPDATE
+  TEST_ASSERT_EQUAL_UINT32(12, captiveDnsReply(q, qlen, AP_IP, 60, r, sizeof(r)));
+  TEST_ASSERT_EQUAL_UINT8(0x84 | 0x28, r[2]);
+  TEST_ASSERT_EQUAL_UINT8(0x84, r[3]);
+}
+
+static void test_malformed_packets_get_no_reply() {
+  uint8_t q[64], r[CAPTIVE_DNS_MAX_PACKET];
+  size_t qlen = makeQuery(q, NAME, NAME_LEN, 1);
+
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(q, 11, AP_IP, 60, r, sizeof(r)));
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(nullptr, qlen, AP_IP, 60, r, sizeof(r)));
+  // Nombre o tipo cortados
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(q, 16, AP_IP, 60, r, sizeof(r)));
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(q, qlen - 1, AP_IP, 60, r, sizeof(r)));
+  // Destino demasiado pequeño
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(q, qlen, AP_IP, 60, r, qlen + 15));
+
+  // Una respuesta no se contesta
+  uint8_t copy[64];
+  memcpy(copy, q, qlen);
+  copy[2] |= 0x80;
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(copy, qlen, AP_IP, 60, r, sizeof(r)));
+
+  // Dos preguntas o ninguna
+  memcpy(copy, q, qlen);
+  copy[5] = 2;
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(copy, qlen, AP_IP, 60, r, sizeof(r)));
+  copy[5] = 0;
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(copy, qlen, AP_IP, 60, r, sizeof(r)));
+
+  // Compresión en la pregunta
+  memcpy(copy, q, qlen);
+  copy[12] = 0xC0;
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(copy, qlen, AP_IP, 60, r, sizeof(r)));
+
+  // Etiqueta que salta más allá del paquete
+  memcpy(copy, q, qlen);
+  copy[12] = 63;
+  TEST_ASSERT_EQUAL_UINT32(0, captiveDnsReply(copy, qlen, AP_IP, 60, r, sizeof(r)));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_a_query_resolves_to_ap);
+  RUN_TEST(test_other_types_get_empty_answer);
+  RUN_TEST(test_edns_record_is_not_copied);
+  RUN_TEST(test_non_query_opcode_gets_notimp);
+  RUN_TEST(test_malformed_packets_get_no_reply);
+  return UNITY_END();
+}
@@ -0,0 +1,72 @@
+// Antirrebote de F1-F3, switches y teclado (src/input_debounce)
+
+#include <unity.h>
+#include "input_debounce.h"
+
+static const uint64_t WINDOW_US = 500000;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_first_event_is_accepted() {
+  InputDebounce d = {};
+  // También a la hora 0 (arranque): no hay evento anterior con el que comparar
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, 0, WINDOW_US));
+  TEST_ASSERT_TRUE(d.seen);
+  TEST_ASSERT_EQUAL_UINT64(0, d.lastUs);
+}
+
+static void test_rejects_inside_window_and_at_boundary() {
+  InputDebounce d = {};
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, 1000000, WINDOW_US));
+  TEST_ASSERT_FALSE(inputDebounceAccept(d, 1000001, WINDOW_US));
+  TEST_ASSERT_FALSE(inputDebounceAccept(d, 1000000 + WINDOW_US, WINDOW_US));
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, 1000000 + WINDOW_US + 1, WINDOW_US));
+}
+
+static void test_rejected_events_do_not_move_reference() {
+  InputDebounce d = {};
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, 0, WINDOW_US));
+  // Rebotes cada 100 ms: ninguno alarga la ventana del primero
+  for (uint64_t t = 100000; t <= WINDOW_US; t += 100000) {
+    TEST_ASSERT_FALSE(inputDebounceAccept(d, t, WINDOW_US));
+  }
+  TEST_ASSERT_EQUAL_UINT64(0, d.lastUs);
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, WINDOW_US + 100000, WINDOW_US));
+  TEST_ASSERT_EQUAL_UINT64(WINDOW_US + 100000, d.lastUs);
+}
+
+static void test_mark_sets_reference_without_check() {
+  InputDebounce d = {};
+  inputDebounceMark(d, 2000000);
+  TEST_ASSERT_FALSE(inputDebounceAccept(d, 2000000 + 100000, 100000));
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, 2000000 + 100001, 100000));
+}
+
+static void test_channels_are_independent() {
+  InputDebounce channels[3] = {};
+  TEST_ASSERT_TRUE(inputDebounceAccept(channels[0], 10, WINDOW_US));
+  TEST_ASSERT_TRUE(inputDebounceAccept(channels[1], 20, WINDOW_US));
+  TEST_ASSERT_FALSE(inputDebounceAccept(channels[0], 30, WINDOW_US));
+  TEST_ASSERT_TRUE(inputDebounceAccept(channels[2], 30, WINDOW_US));
+}
+
+static void test_long_uptime() {
+  // esp_timer_get_time() es de 64 bits: sin saltos al pasar los 2^32 µs (~71 min)
+  InputDebounce d = {};
+  uint64_t t = 0xFFFFFFFFULL - 100000;
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, t, WINDOW_US));
+  TEST_ASSERT_FALSE(inputDebounceAccept(d, t + 200000, WINDOW_US));
+  TEST_ASSERT_TRUE(inputDebounceAccept(d, t + WINDOW_US + 1, WINDOW_US));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_event_is_accepted);
+  RUN_TEST(test_rejects_inside_window_and_at_boundary);
+  RUN_TEST(test_rejected_events_do_not_move_reference);
+  RUN_TEST(test_mark_sets_reference_without_check);
+  RUN_TEST(test_channels_are_independent);
+  RUN_TEST(test_long_uptime);
+  return UNITY_END();
+}
@@ -0,0 +1,137 @@
+// Cola de flancos F1-F3 (src/input_event_queue): orden FIFO, secuencia sin
+// huecos, desbordamiento sin pisar pendientes y varios productores a la vez
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "input_event_queue.h"
+
+static const uint32_t STRESS_EVENTS = 100000;   // Por productor
+
+void setUp() {}
+void tearDown() {}
+
+static void test_fifo_with_sequence_numbers() {
+  InputEventQueue q;
+  TEST_ASSERT_TRUE(q.push(2, 1000));
+  TEST_ASSERT_TRUE(q.push(0, 2000));
+  TEST_ASSERT_TRUE(q.push(1, 3000));
+  TEST_ASSERT_EQUAL_UINT32(3, q.size());
+
+  InputEvent e;
+  const uint8_t channels[] = {2, 0, 1};
+  for (uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(q.pop(e));
+    TEST_ASSERT_EQUAL_UINT8(channels[i], e.channel);
+    TEST_ASSERT_EQUAL_UINT64((i + 1) * 1000, e.timeUs);
+    TEST_ASSERT_EQUAL_UINT32(i, e.seq);
+  }
+  TEST_ASSERT_FALSE(q.pop(e));
+}
+
+static void test_overflow_keeps_pending_events() {
+  InputEventQueue q;
+  for (uint32_t i = 0; i < InputEventQueue::CAPACITY; i++) {
+    TEST_ASSERT_TRUE(q.push(i % 3, i));
+  }
+  TEST_ASSERT_FALSE(q.push(0, 999999));
+  TEST_ASSERT_FALSE(q.push(1, 999999));
+
+  InputEventQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(2, s.overflows);
+  TEST_ASSERT_EQUAL_UINT32(InputEventQueue::CAPACITY, s.pushed);
+  TEST_ASSERT_EQUAL_UINT32(InputEventQueue::CAPACITY, s.maxDepth);
+
+  InputEvent e;
+  for (uint32_t i = 0; i < InputEventQueue::CAPACITY; i++) {
+    TEST_ASSERT_TRUE(q.pop(e));
+    TEST_ASSERT_EQUAL_UINT64(i, e.timeUs);
+  }
+  TEST_ASSERT_FALSE(q.pop(e));
+  // Hay hueco otra vez y la secuencia sigue donde iba (lo perdido no la consume)
+  TEST_ASSERT_TRUE(q.push(2, 5));
+  TEST_ASSERT_TRUE(q.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(InputEventQueue::CAPACITY, e.seq);
+}
+
+static void test_wraps_around_many_times() {
+  InputEventQueue q;
+  InputEvent e;
+  uint32_t expected = 0;
+  for (uint32_t round = 0; round < 10 * InputEventQueue::CAPACITY; round++) {
+    TEST_ASSERT_TRUE(q.push(round % 3, round));
+    if (round % 3 == 2) {
+      while (q.pop(e)) {
+        TEST_ASSERT_EQUAL_UINT32(expected, e.seq);
+        TEST_ASSERT_EQUAL_UINT64(expected, e.timeUs);
+        expected++;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, q.getStats().overflows);
+}
+
+static void test_three_producers_one_consumer() {
+  // Las tres ISR a la vez: cada canal sale en su orden y la secuencia global
+  // no tiene huecos ni repeticiones
+  InputEventQueue q;
+  std::atomic<uint32_t> producersDone(0);
+  std::atomic<uint32_t> retries(0);
+
+  auto producer = [&](uint8_t channel) {
+    for (uint64_t t = 1; t <= STRESS_EVENTS; t++) {
+      while (!q.push(channel, t)) {
+        retries.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+      }
+    }
+    producersDone.fetch_add(1, std::memory_order_release);
+  };
+  std::thread p0(producer, 0);
+  std::thread p1(producer, 1);
+  std::thread p2(producer, 2);
+
+  uint64_t lastTime[3] = {0, 0, 0};
+  uint32_t received = 0, outOfOrder = 0, badSeq = 0, badChannel = 0;
+  InputEvent e;
+  for (;;) {
+    if (q.pop(e)) {
+      if (e.seq != received) badSeq++;
+      if (e.channel > 2) {
+        badChannel++;
+      } else {
+        if (e.timeUs != lastTime[e.channel] + 1) outOfOrder++;
+        lastTime[e.channel] = e.timeUs;
+      }
+      received++;
+    } else if (producersDone.load(std::memory_order_acquire) == 3 && q.size() == 0) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  p0.join();
+  p1.join();
+  p2.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, badChannel);
+  TEST_ASSERT_EQUAL_UINT32(0, badSeq);
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(3 * STRESS_EVENTS, received);
+  for (int c = 0; c < 3; c++) {
+    TEST_ASSERT_EQUAL_UINT64(STRESS_EVENTS, lastTime[c]);
+  }
+  InputEventQueueStats s = q.getStats();
+  TEST_ASSERT_EQUAL_UINT32(3 * STRESS_EVENTS, s.pushed);
+  TEST_ASSERT_EQUAL_UINT32(3 * STRESS_EVENTS, s.popped);
+  TEST_ASSERT_EQUAL_UINT32(retries.load(), s.overflows);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_with_sequence_numbers);
+  RUN_TEST(test_overflow_keeps_pending_events);
+  RUN_TEST(test_wraps_around_many_times);
+  RUN_TEST(test_three_producers_one_consumer);
+  return UNITY_END();
+}
@@ -0,0 +1,210 @@
+// Generador de carga sintética (src/load_generator) con el reloj manual:
+// tasa exacta, tramas válidas, ráfagas acotadas y recuento de pérdidas
+
+#include <unity.h>
+#include "display_protocol.h"
+#include "load_generator.h"
+
+static BridgeQueue queue(BRIDGE_DROP_NEWEST);
+static uint32_t notifies;
+static uint32_t inputsSeen;
+static uint8_t inputChannels[64];
+
+static void onNotify() {
+  notifies++;
+}
+
+static void onInput(uint8_t input) {
+  if (inputsSeen < sizeof(inputChannels)) inputChannels[inputsSeen] = input;
+  inputsSeen++;
+}
+
+static void drain() {
+  BridgeFrame f;
+  while (queue.pop(f)) {
+  }
+}
+
+void setUp() {
+  nativeSetMicros(5000000);
+  drain();
+  notifies = 0;
+  inputsSeen = 0;
+  loadGeneratorInit(queue, onNotify, onInput);
+}
+
+void tearDown() {
+  loadGeneratorStop();
+}
+
+static void test_parse_args() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  TEST_ASSERT_TRUE(loadGeneratorParseArgs(c, "rate=200 size=40,kind=text&displays=8 seconds=5 inputs=10"));
+  TEST_ASSERT_EQUAL_UINT32(200, c.rateHz);
+  TEST_ASSERT_EQUAL_UINT32(40, c.frameLen);
+  TEST_ASSERT_EQUAL_UINT32(LOAD_FRAME_TEXT, c.kind);
+  TEST_ASSERT_EQUAL_UINT32(8, c.displays);
+  TEST_ASSERT_EQUAL_UINT32(5000, c.durationMs);
+  TEST_ASSERT_EQUAL_UINT32(10, c.inputRateHz);
+  TEST_ASSERT_TRUE(loadGeneratorParseArgs(c, ""));
+
+  LoadGeneratorConfig d = loadGeneratorDefaults();
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "rate=0"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "rate=5001"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "rate=12x"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "size=4"));      // Menos que XXYYT
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "size=256"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "kind=binary"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "displays=0"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "seconds=601"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "inputs=51"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "speed=10"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "rate"));
+  TEST_ASSERT_FALSE(loadGeneratorParseArgs(d, "rate=0000000000000000000000000000001"));
+}
+
+static void test_generates_exact_rate_of_valid_chrono_frames() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  c.rateHz = 200;
+  c.frameLen = 24;
+  c.displays = 4;
+  c.durationMs = 2000;
+  loadGeneratorStart(c);
+
+  // La primera trama toca a 1/rate del arranque
+  TEST_ASSERT_EQUAL_UINT32(5000, loadGeneratorService());
+  TEST_ASSERT_EQUAL_UINT32(0, queue.size());
+
+  uint32_t frames = 0;
+  uint32_t wait = 0;
+  BridgeFrame f;
+  for (int ms = 1; ms <= 2100 && wait != UINT32_MAX; ms++) {
+    nativeAdvanceMicros(1000);
+    wait = loadGeneratorService();
+    while (queue.pop(f)) {
+      DisplayFrameInfo info;
+      TEST_ASSERT_TRUE(parseDisplayFrame(f.data, f.len, info));
+      TEST_ASSERT_EQUAL_UINT32(DISPLAY_TYPE_CHRONO, info.type);
+      TEST_ASSERT_EQUAL_UINT32(24, f.len);
+      // Displays 01..04 por turnos, fila 01
+      char address[5];
+      snprintf(address, sizeof(address), "%02u01", (unsigned)(frames % 4 + 1));
+      TEST_ASSERT_EQUAL_MEMORY(address, f.data, 4);
+      TEST_ASSERT_EQUAL_UINT8(' ', f.data[f.len - 1]);
+      frames++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wait);
+  TEST_ASSERT_FALSE(loadGeneratorRunning());
+  TEST_ASSERT_EQUAL_UINT32(400, frames);
+
+  LoadGeneratorReport r = loadGeneratorGetReport();
+  TEST_ASSERT_EQUAL_UINT32(400, r.generated);
+  TEST_ASSERT_EQUAL_UINT32(0, r.rejected);
+  TEST_ASSERT_EQUAL_UINT32(0, r.dropped);
+  TEST_ASSERT_EQUAL_UINT32(2000, r.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(200, r.offeredFps);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, notifies);
+}
+
+static void test_text_frames_are_padded() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  TEST_ASSERT_TRUE(loadGeneratorParseArgs(c, "kind=text size=40 rate=100 displays=2"));
+  loadGeneratorStart(c);
+  nativeAdvanceMicros(10000);
+  loadGeneratorService();
+
+  BridgeFrame f;
+  TEST_ASSERT_TRUE(queue.pop(f));
+  TEST_ASSERT_EQUAL_UINT32(40, f.len);
+  TEST_ASSERT_EQUAL_MEMORY("01012 0 00 LOAD 0 ", f.data, 18);
+  TEST_ASSERT_EQUAL_UINT8('A' + 39 % 26, f.data[39]);
+}
+
+static void test_catch_up_is_bounded_per_call() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  c.rateHz = 5000;
+  loadGeneratorStart(c);
+  // El hilo productor se retrasa 10 ms: 50 tramas atrasadas
+  nativeAdvanceMicros(10000);
+  TEST_ASSERT_EQUAL_UINT32(0, loadGeneratorService());
+  TEST_ASSERT_EQUAL_UINT32(LOAD_GEN_MAX_BURST, loadGeneratorGetReport().generated);
+  drain();
+  uint32_t wait = loadGeneratorService();
+  TEST_ASSERT_EQUAL_UINT32(50, loadGeneratorGetReport().generated);
+  TEST_ASSERT_EQUAL_UINT32(200, wait);
+}
+
+static void test_counts_frames_the_queue_rejects() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  c.rateHz = 1000;
+  loadGeneratorStart(c);
+  // Nadie consume: la cola se llena y BRIDGE_DROP_NEWEST rechaza el resto
+  for (int ms = 0; ms < 100; ms++) {
+    nativeAdvanceMicros(1000);
+    loadGeneratorService();
+  }
+  LoadGeneratorReport r = loadGeneratorGetReport();
+  TEST_ASSERT_EQUAL_UINT32(100, r.generated);
+  TEST_ASSERT_EQUAL_UINT32(100 - BridgeQueue::CAPACITY, r.rejected);
+  TEST_ASSERT_EQUAL_UINT32(100 - BridgeQueue::CAPACITY, r.dropped);
+  TEST_ASSERT_EQUAL_UINT32(BridgeQueue::CAPACITY, queue.size());
+
+  // Un arranque nuevo no hereda las pérdidas de la prueba anterior
+  drain();
+  loadGeneratorStart(c);
+  TEST_ASSERT_EQUAL_UINT32(0, loadGeneratorGetReport().dropped);
+  TEST_ASSERT_EQUAL_UINT32(0, loadGeneratorGetReport().rejected);
+}
+
+static void test_simulated_inputs_rotate_channels() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  c.inputRateHz = 30;
+  loadGeneratorStart(c);
+  for (int ms = 0; ms < 1000; ms++) {
+    nativeAdvanceMicros(1000);
+    loadGeneratorService();
+    drain();
+  }
+  TEST_ASSERT_EQUAL_UINT32(30, inputsSeen);
+  TEST_ASSERT_EQUAL_UINT32(30, loadGeneratorGetReport().inputs);
+  for (uint32_t i = 0; i < 30; i++) {
+    TEST_ASSERT_EQUAL_UINT8(i % 3, inputChannels[i]);
+  }
+}
+
+static void test_stop_freezes_report() {
+  LoadGeneratorConfig c = loadGeneratorDefaults();
+  loadGeneratorStart(c);
+  for (int step = 0; step < 15; step++) {
+    nativeAdvanceMicros(100000);
+    loadGeneratorService();
+    drain();
+  }
+  loadGeneratorStop();
+  TEST_ASSERT_FALSE(loadGeneratorRunning());
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, loadGeneratorService());
+
+  nativeAdvanceMicros(3000000);
+  LoadGeneratorReport r = loadGeneratorGetReport();
+  TEST_ASSERT_FALSE(r.running);
+  TEST_ASSERT_EQUAL_UINT32(1500, r.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(75, r.generated);
+
+  char line[96];
+  size_t len = formatLoadGeneratorReport(r, line, sizeof(line));
+  TEST_ASSERT_EQUAL_UINT32(strlen(line), len);
+  TEST_ASSERT_EQUAL_MEMORY("END 1s ", line, 7);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_args);
+  RUN_TEST(test_generates_exact_rate_of_valid_chrono_frames);
+  RUN_TEST(test_text_frames_are_padded);
+  RUN_TEST(test_catch_up_is_bounded_per_call);
+  RUN_TEST(test_counts_frames_the_queue_rejects);
+  RUN_TEST(test_simulated_inputs_rotate_channels);
+  RUN_TEST(test_stop_freezes_report);
+  return UNITY_END();
+}
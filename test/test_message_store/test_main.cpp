@@ -0,0 +1,150 @@
+// Última trama e histórico (src/message_store): JSON y binario codificados una
+// vez, histórico por secuencia y copias coherentes con el escritor en marcha
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <string.h>
+#include <stdio.h>
+#include "message_store.h"
+
+void setUp() {}
+void tearDown() {}
+
+static BridgeFrame makeFrame(const char* text, uint32_t time) {
+  BridgeFrame frame;
+  frame.len = (uint16_t)strlen(text);
+  memcpy(frame.data, text, frame.len);
+  frame.time = time;
+  frame.stampUs = time * 1000;
+  return frame;
+}
+
+static void test_publish_encodes_json_and_binary() {
+  BridgeFrame frame = makeFrame("abc", 42);
+  const EncodedMessage& m = publishLatestMessage(frame);
+  TEST_ASSERT_EQUAL_STRING("{\"len\":3,\"time\":42,\"data\":\"YWJj\"}", m.json);
+  TEST_ASSERT_EQUAL_UINT32(strlen(m.json), m.jsonLen);
+  TEST_ASSERT_EQUAL_UINT32(MESSAGE_BIN_HEADER_LEN + 3, m.binLen);
+  TEST_ASSERT_EQUAL_UINT8(MESSAGE_BIN_VERSION, m.bin[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, m.bin[1]);
+  TEST_ASSERT_EQUAL_MEMORY("abc", m.bin + MESSAGE_BIN_HEADER_LEN, 3);
+
+  char out[MESSAGE_JSON_MAX];
+  TEST_ASSERT_EQUAL_UINT32(m.jsonLen, copyLatestMessageJson(out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING(m.json, out);
+  TEST_ASSERT_EQUAL_UINT32(m.seq, getLatestMessageSeq());
+
+  // Truncado al destino, siempre terminado en '\0'
+  TEST_ASSERT_EQUAL_UINT32(4, copyLatestMessageJson(out, 5));
+  TEST_ASSERT_EQUAL_STRING("{\"le", out);
+}
+
+static void test_radio_frames_go_to_history_only() {
+  char latest[MESSAGE_JSON_MAX];
+  const EncodedMessage& tx = publishLatestMessage(makeFrame("tx", 1));
+  uint32_t txSeq = tx.seq;
+  copyLatestMessageJson(latest, sizeof(latest));
+
+  const EncodedMessage& rx = encodeRadioMessage(makeFrame("rx", 2));
+  TEST_ASSERT_EQUAL_UINT32(txSeq + 1, rx.seq);
+  TEST_ASSERT_EQUAL_UINT8(MESSAGE_BIN_FLAG_RX, rx.bin[1]);
+  TEST_ASSERT_EQUAL_UINT32(rx.seq, getLatestMessageSeq());
+
+  char out[MESSAGE_HISTORY_JSON_MAX];
+  copyLatestMessageJson(out, sizeof(out));
+  TEST_ASSERT_EQUAL_STRING(latest, out);
+
+  char expected[MESSAGE_HISTORY_JSON_MAX];
+  snprintf(expected, sizeof(expected), "{\"seq\":%u,\"len\":2,\"time\":2,\"data\":\"cng=\",\"dir\":\"rx\"}",
+           (unsigned)rx.seq);
+  TEST_ASSERT_EQUAL_UINT32(strlen(expected), copyHistoryMessageJson(rx.seq, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING(expected, out);
+}
+
+static void test_history_keeps_last_slots() {
+  uint32_t first = 0, last = 0;
+  for (uint32_t i = 0; i < MESSAGE_HISTORY_SLOTS * 2; i++) {
+    last = publishLatestMessage(makeFrame("h", i)).seq;
+    if (i == 0) first = last;
+  }
+  char out[MESSAGE_HISTORY_JSON_MAX];
+  TEST_ASSERT_EQUAL_UINT32(0, copyHistoryMessageJson(first, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_UINT32(0, copyHistoryMessageJson(last - MESSAGE_HISTORY_SLOTS, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_UINT32(0, copyHistoryMessageJson(last + 1, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_UINT32(0, copyHistoryMessageJson(0, out, sizeof(out)));
+  for (uint32_t seq = last - MESSAGE_HISTORY_SLOTS + 1; seq <= last; seq++) {
+    TEST_ASSERT_GREATER_THAN_UINT32(0, copyHistoryMessageJson(seq, out, sizeof(out)));
+    unsigned got;
+    TEST_ASSERT_EQUAL_INT(1, sscanf(out, "{\"seq\":%u,", &got));
+    TEST_ASSERT_EQUAL_UINT32(seq, got);
+  }
+}
+
+// Trama de prueba: su longitud y contenido dependen de time, así una copia
+// que mezcle dos tramas no coincide con ninguna
+static BridgeFrame makeTimedFrame(uint32_t time) {
+  BridgeFrame frame;
+  frame.len = (uint16_t)(1 + time % BRIDGE_FRAME_MAX);
+  memset(frame.data, 'a' + time % 26, frame.len);
+  frame.time = time;
+  frame.stampUs = 0;
+  return frame;
+}
+
+// "time" del JSON copiado (sin el prefijo), o UINT32_MAX si no es el de esa trama
+static uint32_t checkJson(const char* json) {
+  const char* p = strstr(json, "\"time\":");
+  unsigned time;
+  if (p == nullptr || sscanf(p, "\"time\":%u", &time) != 1) return UINT32_MAX;
+  char expected[MESSAGE_JSON_MAX];
+  encodeFrameJson(makeTimedFrame(time), nullptr, expected, sizeof(expected));
+  return strcmp(json, expected + 1) == 0 ? time : UINT32_MAX;
+}
+
+static void test_readers_see_whole_frames_while_publishing() {
+  const uint32_t frames = 20000;
+  publishLatestMessage(makeTimedFrame(0));
+
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (uint32_t time = 1; time <= frames; time++) publishLatestMessage(makeTimedFrame(time));
+    done = true;
+  });
+
+  uint32_t torn = 0, backwards = 0, lastTime = 0;
+  char out[MESSAGE_HISTORY_JSON_MAX];
+  while (!done) {
+    copyLatestMessageJson(out, sizeof(out));
+    uint32_t time = out[0] == '{' ? checkJson(out + 1) : UINT32_MAX;
+    if (time == UINT32_MAX) {
+      torn++;
+    } else {
+      if (time < lastTime) backwards++;
+      lastTime = time;
+    }
+
+    // Una entrada del histórico puede haberse sobrescrito ya (0), nunca mezclado
+    uint32_t seq = getLatestMessageSeq();
+    if (copyHistoryMessageJson(seq, out, sizeof(out)) > 0) {
+      unsigned got;
+      const char* rest = strchr(out, ',');
+      if (sscanf(out, "{\"seq\":%u,", &got) != 1 || got != seq || checkJson(rest + 1) == UINT32_MAX) torn++;
+    }
+  }
+  writer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, backwards);
+  copyLatestMessageJson(out, sizeof(out));
+  TEST_ASSERT_EQUAL_UINT32(frames, checkJson(out + 1));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_publish_encodes_json_and_binary);
+  RUN_TEST(test_radio_frames_go_to_history_only);
+  RUN_TEST(test_history_keeps_last_slots);
+  RUN_TEST(test_readers_see_whole_frames_while_publishing);
+  return UNITY_END();
+}
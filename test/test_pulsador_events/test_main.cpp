@@ -0,0 +1,205 @@
+// Lotes binarios del pulsador (src/pulsador_events): formato de la
+// notificación, reparto por MTU y huecos de secuencia para lo perdido
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "pulsador_events.h"
+
+void setUp() {}
+void tearDown() {}
+
+struct Decoded {
+  uint8_t count;
+  uint32_t seq;
+  uint64_t timeUs;
+};
+
+static Decoded header(const uint8_t* p) {
+  Decoded d;
+  TEST_ASSERT_EQUAL_UINT8(PULSADOR_EVENTS_VERSION, p[0]);
+  d.count = p[1];
+  memcpy(&d.seq, p + 2, 4);
+  memcpy(&d.timeUs, p + 6, 8);
+  return d;
+}
+
+static void record(const uint8_t* p, uint32_t index, uint8_t& id, uint8_t& value, int32_t& offsetUs) {
+  const uint8_t* r = p + PULSADOR_EVENTS_HEADER_LEN + index * PULSADOR_EVENTS_RECORD_LEN;
+  id = r[0];
+  value = r[1];
+  memcpy(&offsetUs, r + 2, 4);
+}
+
+static void test_packs_header_and_records() {
+  PulsadorEventBatch b;
+  TEST_ASSERT_TRUE(b.append(PULSADOR_EVENT_F1 + 1, 0, 10000000));
+  TEST_ASSERT_TRUE(b.append(PULSADOR_EVENT_SWITCH + 2, 1, 10000250));
+  TEST_ASSERT_TRUE(b.append(PULSADOR_EVENT_KEY + 4, 0, 9999900));   // Tomado antes (despertar por teclado)
+
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  size_t len = b.packNext(packet, sizeof(packet));
+  TEST_ASSERT_EQUAL_UINT32(PULSADOR_EVENTS_HEADER_LEN + 3 * PULSADOR_EVENTS_RECORD_LEN, len);
+  Decoded d = header(packet);
+  TEST_ASSERT_EQUAL_UINT8(3, d.count);
+  TEST_ASSERT_EQUAL_UINT32(0, d.seq);
+  TEST_ASSERT_EQUAL_UINT64(10000000, d.timeUs);
+
+  uint8_t id, value;
+  int32_t offset;
+  record(packet, 0, id, value, offset);
+  TEST_ASSERT_EQUAL_UINT8(PULSADOR_EVENT_F1 + 1, id);
+  TEST_ASSERT_EQUAL_UINT32(0, offset);
+  record(packet, 1, id, value, offset);
+  TEST_ASSERT_EQUAL_UINT8(PULSADOR_EVENT_SWITCH + 2, id);
+  TEST_ASSERT_EQUAL_UINT8(1, value);
+  TEST_ASSERT_EQUAL_UINT32(250, offset);
+  record(packet, 2, id, value, offset);
+  TEST_ASSERT_EQUAL_UINT8(PULSADOR_EVENT_KEY + 4, id);
+  TEST_ASSERT_TRUE(offset == -100);
+
+  TEST_ASSERT_EQUAL_UINT32(0, b.packNext(packet, sizeof(packet)));
+  PulsadorEventStats s = b.getStats();
+  TEST_ASSERT_EQUAL_UINT32(3, s.records);
+  TEST_ASSERT_EQUAL_UINT32(1, s.notifications);
+  TEST_ASSERT_EQUAL_UINT32(0, s.pending);
+}
+
+static void test_splits_by_payload_size() {
+  PulsadorEventBatch b;
+  for (int i = 0; i < 5; i++) b.append(PULSADOR_EVENT_KEY, 0, i);
+
+  // MTU por defecto (23): un registro por notificación
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  for (uint32_t i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUAL_UINT32(PULSADOR_EVENTS_MIN_PAYLOAD, b.packNext(packet, BLE_DEFAULT_MTU - 3));
+    Decoded d = header(packet);
+    TEST_ASSERT_EQUAL_UINT8(1, d.count);
+    TEST_ASSERT_EQUAL_UINT32(i, d.seq);
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, b.getStats().notifications);
+
+  // Menos que cabecera + un registro: no se empaqueta nada ni se pierde
+  b.append(PULSADOR_EVENT_KEY, 0, 9);
+  TEST_ASSERT_EQUAL_UINT32(0, b.packNext(packet, PULSADOR_EVENTS_MIN_PAYLOAD - 1));
+  TEST_ASSERT_EQUAL_UINT32(1, b.getStats().pending);
+}
+
+static void test_skipped_sequences_open_new_notification() {
+  PulsadorEventBatch b;
+  b.append(PULSADOR_EVENT_F1, 0, 100);
+  b.append(PULSADOR_EVENT_F1, 0, 200);
+  b.skip(3);   // Flancos perdidos en la cola de interrupciones
+  b.append(PULSADOR_EVENT_F1, 0, 300);
+
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  TEST_ASSERT_GREATER_THAN_UINT32(0, b.packNext(packet, sizeof(packet)));
+  Decoded d = header(packet);
+  TEST_ASSERT_EQUAL_UINT8(2, d.count);
+  TEST_ASSERT_EQUAL_UINT32(0, d.seq);
+
+  TEST_ASSERT_GREATER_THAN_UINT32(0, b.packNext(packet, sizeof(packet)));
+  d = header(packet);
+  TEST_ASSERT_EQUAL_UINT8(1, d.count);
+  TEST_ASSERT_EQUAL_UINT32(5, d.seq);
+  TEST_ASSERT_EQUAL_UINT32(3, b.getStats().lost);
+}
+
+static void test_full_batch_loses_events_visibly() {
+  PulsadorEventBatch b;
+  for (uint32_t i = 0; i < PulsadorEventBatch::CAPACITY; i++) {
+    TEST_ASSERT_TRUE(b.append(PULSADOR_EVENT_KEY, 0, i));
+  }
+  TEST_ASSERT_FALSE(b.append(PULSADOR_EVENT_KEY, 0, 1000));
+  TEST_ASSERT_FALSE(b.append(PULSADOR_EVENT_KEY, 0, 1001));
+  TEST_ASSERT_EQUAL_UINT32(2, b.getStats().lost);
+
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  uint32_t delivered = 0;
+  size_t len;
+  while ((len = b.packNext(packet, sizeof(packet))) > 0) {
+    Decoded d = header(packet);
+    TEST_ASSERT_EQUAL_UINT32(delivered, d.seq);
+    delivered += d.count;
+  }
+  TEST_ASSERT_EQUAL_UINT32(PulsadorEventBatch::CAPACITY, delivered);
+
+  // El siguiente evento salta las dos secuencias perdidas
+  b.append(PULSADOR_EVENT_KEY, 0, 2000);
+  b.packNext(packet, sizeof(packet));
+  TEST_ASSERT_EQUAL_UINT32(PulsadorEventBatch::CAPACITY + 2, header(packet).seq);
+}
+
+static void test_clear_drops_pending_and_keeps_sequence() {
+  PulsadorEventBatch b;
+  b.append(PULSADOR_EVENT_F1, 0, 1);
+  b.append(PULSADOR_EVENT_F1, 0, 2);
+  b.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, b.getStats().pending);
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  TEST_ASSERT_EQUAL_UINT32(0, b.packNext(packet, sizeof(packet)));
+  b.append(PULSADOR_EVENT_F1, 0, 3);
+  b.packNext(packet, sizeof(packet));
+  TEST_ASSERT_EQUAL_UINT32(2, header(packet).seq);
+}
+
+static void test_concurrent_producers_account_for_every_event() {
+  // Tarea de entradas y tarea BLE añadiendo mientras la de entradas empaqueta:
+  // cada secuencia llega una vez o se cuenta como perdida
+  const uint32_t perProducer = 50000;
+  PulsadorEventBatch b;
+  std::atomic<int> done(0);
+  auto producer = [&](uint8_t id) {
+    for (uint32_t i = 0; i < perProducer; i++) b.append(id, 0, i);
+    done.fetch_add(1);
+  };
+  std::thread p0(producer, PULSADOR_EVENT_F1);
+  std::thread p1(producer, PULSADOR_EVENT_SWITCH);
+
+  std::vector<uint8_t> seen(2 * perProducer, 0);
+  uint32_t delivered = 0, duplicates = 0, backwards = 0, gaps = 0, nextSeq = 0;
+  uint8_t packet[PULSADOR_NOTIFY_MAX];
+  for (;;) {
+    size_t len = b.packNext(packet, sizeof(packet));
+    if (len == 0) {
+      if (done.load() == 2 && b.getStats().pending == 0) break;
+      std::this_thread::yield();
+      continue;
+    }
+    Decoded d = header(packet);
+    if (d.seq < nextSeq) backwards++;
+    gaps += d.seq - nextSeq;
+    for (uint32_t i = 0; i < d.count; i++) {
+      uint32_t seq = d.seq + i;
+      if (seq >= seen.size() || seen[seq]) {
+        duplicates++;
+      } else {
+        seen[seq] = 1;
+      }
+    }
+    delivered += d.count;
+    nextSeq = d.seq + d.count;
+  }
+  p0.join();
+  p1.join();
+
+  PulsadorEventStats s = b.getStats();
+  TEST_ASSERT_EQUAL_UINT32(0, duplicates);
+  TEST_ASSERT_EQUAL_UINT32(0, backwards);
+  TEST_ASSERT_EQUAL_UINT32(s.records, delivered);
+  TEST_ASSERT_EQUAL_UINT32(2 * perProducer, delivered + s.lost);
+  // Los huecos que ve el cliente son las pérdidas, salvo las del final
+  TEST_ASSERT_EQUAL_UINT32(s.lost, gaps + (2 * perProducer - nextSeq));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_packs_header_and_records);
+  RUN_TEST(test_splits_by_payload_size);
+  RUN_TEST(test_skipped_sequences_open_new_notification);
+  RUN_TEST(test_full_batch_loses_events_visibly);
+  RUN_TEST(test_clear_drops_pending_and_keeps_sequence);
+  RUN_TEST(test_concurrent_producers_account_for_every_event);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// Dosificador de transmisión hacia el APC220 (src/radio_tx_pacer): ritmo de
+// vaciado, esperas calculadas y ningún desbordamiento del buffer del módulo
+
+#include <unity.h>
+#include "radio_tx_pacer.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t BUFFER_LIMIT = RADIO_MODULE_BUFFER_BYTES * RADIO_TX_BUFFER_FILL_PCT / 100;
+
+static void test_configure_derives_drain_and_limit() {
+  RadioTxPacer p;
+  p.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, 0);
+  RadioTxPacerStats s = p.getStats(0);
+  TEST_ASSERT_EQUAL_UINT32(9600 * RADIO_TX_AIR_EFFICIENCY_PCT / 800, s.drainBytesPerSec);
+  TEST_ASSERT_EQUAL_UINT32(BUFFER_LIMIT, s.bufferLimit);
+  TEST_ASSERT_EQUAL_UINT32(BUFFER_LIMIT, p.maxChunk());
+
+  // UART más lenta que el aire: manda la UART (8N1)
+  p.configure(19200, 9600, RADIO_MODULE_BUFFER_BYTES, 0);
+  TEST_ASSERT_EQUAL_UINT32(960, p.getStats(0).drainBytesPerSec);
+}
+
+static void test_waits_until_the_bucket_has_room() {
+  RadioTxPacer p;
+  p.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, 1000);
+  const uint32_t drain = 9600 * RADIO_TX_AIR_EFFICIENCY_PCT / 800;
+
+  TEST_ASSERT_EQUAL_UINT32(0, p.reserve(BUFFER_LIMIT, 1000));
+  p.commit(BUFFER_LIMIT, 1000, 0);
+  // Lleno: 20 bytes más esperan a que salgan 20 por el aire (redondeo hacia arriba)
+  uint32_t wait = p.reserve(20, 1000);
+  TEST_ASSERT_EQUAL_UINT32((20 * 1000000 + drain - 1) / drain, wait);
+  TEST_ASSERT_EQUAL_UINT32(0, p.reserve(20, 1000 + wait));
+
+  RadioTxPacer early;
+  early.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, 1000);
+  early.commit(BUFFER_LIMIT, 1000, 0);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, early.reserve(20, 1000 + wait - 1));
+
+  // Una escritura mayor que el límite se trata como el límite
+  TEST_ASSERT_EQUAL_UINT32(p.reserve(BUFFER_LIMIT, 1000 + wait), p.reserve(BUFFER_LIMIT + 100, 1000 + wait));
+}
+
+static void test_stats_track_level_and_utilization() {
+  RadioTxPacer p;
+  p.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, 0);
+  p.commit(120, 0, 0);
+  p.commit(60, 0, 500);
+  RadioTxPacerStats s = p.getStats(0);
+  TEST_ASSERT_EQUAL_UINT32(180, s.level);
+  TEST_ASSERT_EQUAL_UINT32(180, s.peakLevel);
+  TEST_ASSERT_EQUAL_UINT32(180, s.bytes);
+  TEST_ASSERT_EQUAL_UINT32(2, s.chunks);
+  TEST_ASSERT_EQUAL_UINT32(1, s.throttled);
+  TEST_ASSERT_EQUAL_UINT64(500, s.throttledUs);
+  TEST_ASSERT_EQUAL_UINT64(180ULL * 8000000 / 9600, s.airBusyUs);
+
+  // Un segundo después el buffer está vacío y el canal se usó un 15 %
+  s = p.getStats(1000000);
+  TEST_ASSERT_EQUAL_UINT32(0, s.level);
+  TEST_ASSERT_EQUAL_UINT32(180, s.peakLevel);
+  TEST_ASSERT_EQUAL_UINT32(15, s.utilization);
+  TEST_ASSERT_EQUAL_UINT32(100 * 150000 / (180 * 1000000 / (9600 * RADIO_TX_AIR_EFFICIENCY_PCT / 800)),
+                           s.burstUtilization);
+}
+
+static void test_micros_wraparound() {
+  RadioTxPacer p;
+  const uint32_t t0 = 0xFFFFFFFFu - 10000;
+  p.configure(9600, 19200, RADIO_MODULE_BUFFER_BYTES, t0);
+  p.commit(BUFFER_LIMIT, t0, 0);
+  uint32_t wait = p.reserve(BUFFER_LIMIT, t0);
+  TEST_ASSERT_GREATER_THAN_UINT32(10000, wait);
+  TEST_ASSERT_EQUAL_UINT32(0, p.reserve(BUFFER_LIMIT, t0 + wait));   // t0 + wait ya desbordó
+  TEST_ASSERT_EQUAL_UINT64(wait, p.getStats(t0 + wait).elapsedUs);
+}
+
+/**
+ * @brief Ráfaga continua de tramas de 20 B hacia un APC220 simulado (RF 9600,
+ * UART 19200, buffer RADIO_MODULE_BUFFER_BYTES) que de verdad vacía el 85 %
+ * de la velocidad RF, en tiempo simulado
+ * @return Veces que el buffer del módulo se habría desbordado
+ */
+static uint32_t simulateRadioTx(bool paced, RadioTxPacerStats& stats) {
+  const uint32_t airBps = 9600, uartBps = 19200, seconds = 10;
+  const double realDrain = airBps / 8.0 * 0.85;
+  const size_t len = 20;
+  RadioTxPacer pacer;
+  pacer.configure(airBps, uartBps, RADIO_MODULE_BUFFER_BYTES, 0);
+  double level = 0;
+  uint32_t t = 0;
+  uint32_t overflows = 0;
+  auto elapse = [&](uint32_t us) {
+    level -= realDrain * us / 1e6;
+    if (level < 0) level = 0;
+    t += us;
+  };
+  while (t < seconds * 1000000) {
+    uint32_t wait = paced ? pacer.reserve(len, t) : 0;
+    elapse(wait);
+    elapse((uint32_t)(len * 10 * 1000000ULL / uartBps));
+    level += len;
+    if (level > RADIO_MODULE_BUFFER_BYTES) {
+      overflows++;
+      level = RADIO_MODULE_BUFFER_BYTES;
+    }
+    pacer.commit(len, t, wait);
+  }
+  stats = pacer.getStats(t);
+  return overflows;
+}
+
+static void test_paced_burst_never_overflows_module() {
+  RadioTxPacerStats unpaced, paced;
+  TEST_ASSERT_GREATER_THAN_UINT32(0, simulateRadioTx(false, unpaced));
+  TEST_ASSERT_EQUAL_UINT32(0, simulateRadioTx(true, paced));
+
+  // Sin desperdiciar el aire: lo que sale es el vaciado supuesto (±2 %)
+  uint32_t bytesPerSec = (uint32_t)(paced.bytes * 1000000ULL / paced.elapsedUs);
+  TEST_ASSERT_UINT32_WITHIN(paced.drainBytesPerSec / 50, paced.drainBytesPerSec, bytesPerSec);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(paced.bufferLimit, paced.peakLevel);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, paced.throttled);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_configure_derives_drain_and_limit);
+  RUN_TEST(test_waits_until_the_bucket_has_room);
+  RUN_TEST(test_stats_track_level_and_utilization);
+  RUN_TEST(test_micros_wraparound);
+  RUN_TEST(test_paced_burst_never_overflows_module);
+  return UNITY_END();
+}
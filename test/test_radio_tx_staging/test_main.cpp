@@ -0,0 +1,204 @@
+// Cola de salida hacia el APC220 (src/radio_tx_staging): el crono más reciente
+// de cada display sustituye al pendiente sin saltarse barreras de orden
+
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+#include "radio_tx_staging.h"
+#include "bridge_queue.h"
+
+void setUp() {}
+void tearDown() {}
+
+static uint16_t supersededLen;
+static uint8_t supersededTag;
+
+static bool stage(RadioTxStaging& staging, const char* text, uint8_t tag, uint32_t stampUs = 0) {
+  TEST_ASSERT_FALSE(staging.full());
+  BridgeFrame& slot = staging.back();
+  slot.len = (uint16_t)strlen(text);
+  memcpy(slot.data, text, slot.len);
+  slot.time = 0;
+  slot.stampUs = stampUs;
+  supersededLen = 0;
+  supersededTag = 0;
+  return staging.commit(tag, supersededLen, supersededTag);
+}
+
+static void expectPop(RadioTxStaging& staging, const char* text, uint8_t expectedTag) {
+  BridgeFrame frame;
+  uint8_t tag;
+  TEST_ASSERT_TRUE(staging.pop(frame, tag));
+  TEST_ASSERT_EQUAL_UINT16(strlen(text), frame.len);
+  TEST_ASSERT_EQUAL_MEMORY(text, frame.data, frame.len);
+  TEST_ASSERT_EQUAL_UINT8(expectedTag, tag);
+}
+
+static void test_chrono_replaces_pending_chrono_in_place() {
+  RadioTxStaging staging;
+  TEST_ASSERT_FALSE(stage(staging, "01021 0 00 12:34.5", 1, 100));
+  TEST_ASSERT_FALSE(stage(staging, "03042 0 00HOLA", 2));
+  TEST_ASSERT_TRUE(stage(staging, "01021 0 00 12:34.6x", 3, 200));
+  TEST_ASSERT_EQUAL_UINT16(18, supersededLen);
+  TEST_ASSERT_EQUAL_UINT8(1, supersededTag);
+
+  RadioTxStagingStats s = staging.getStats();
+  TEST_ASSERT_EQUAL_UINT32(3, s.staged);
+  TEST_ASSERT_EQUAL_UINT32(1, s.coalesced);
+  TEST_ASSERT_EQUAL_UINT32(2, s.depth);
+
+  // El crono nuevo ocupa el sitio del viejo, con su propia marca de tiempo
+  BridgeFrame frame;
+  uint8_t tag;
+  TEST_ASSERT_TRUE(staging.pop(frame, tag));
+  TEST_ASSERT_EQUAL_UINT8(3, tag);
+  TEST_ASSERT_EQUAL_UINT32(200, frame.stampUs);
+  TEST_ASSERT_EQUAL_MEMORY("01021 0 00 12:34.6x", frame.data, frame.len);
+  expectPop(staging, "03042 0 00HOLA", 2);
+  TEST_ASSERT_TRUE(staging.empty());
+}
+
+static void test_same_display_frames_are_barriers() {
+  RadioTxStaging staging;
+  stage(staging, "01021 0 00 1", 1);
+  TEST_ASSERT_FALSE(stage(staging, "01023", 2));            // Limpiar ese display
+  TEST_ASSERT_FALSE(stage(staging, "01021 0 00 2", 3));
+  // Solo puede sustituir al crono posterior a la barrera
+  TEST_ASSERT_TRUE(stage(staging, "01021 0 00 3", 4));
+  TEST_ASSERT_EQUAL_UINT8(3, supersededTag);
+  expectPop(staging, "01021 0 00 1", 1);
+  expectPop(staging, "01023", 2);
+  expectPop(staging, "01021 0 00 3", 4);
+  TEST_ASSERT_TRUE(staging.empty());
+}
+
+static void test_undecodable_frame_is_a_barrier_for_all() {
+  RadioTxStaging staging;
+  stage(staging, "01021 0 00 1", 1);
+  TEST_ASSERT_FALSE(stage(staging, "hi", 2));
+  TEST_ASSERT_FALSE(stage(staging, "0102X basura", 3));
+  TEST_ASSERT_FALSE(stage(staging, "01021 0 00 2", 4));
+  TEST_ASSERT_EQUAL_UINT32(0, staging.getStats().coalesced);
+  expectPop(staging, "01021 0 00 1", 1);
+  expectPop(staging, "hi", 2);
+  expectPop(staging, "0102X basura", 3);
+  expectPop(staging, "01021 0 00 2", 4);
+}
+
+static void test_text_frames_never_coalesce() {
+  RadioTxStaging staging;
+  TEST_ASSERT_FALSE(stage(staging, "01022 0 00A", 1));
+  TEST_ASSERT_FALSE(stage(staging, "01022 0 00B", 2));
+  TEST_ASSERT_FALSE(stage(staging, "01024 0 00C", 3));
+  TEST_ASSERT_EQUAL_UINT32(3, staging.getStats().depth);
+  expectPop(staging, "01022 0 00A", 1);
+  expectPop(staging, "01022 0 00B", 2);
+  expectPop(staging, "01024 0 00C", 3);
+}
+
+static void test_full_and_fifo_across_wrap() {
+  RadioTxStaging staging;
+  char text[24];
+  BridgeFrame frame;
+  uint8_t tag;
+  for (int round = 0; round < 3; round++) {
+    // Cronos de displays distintos: ninguno se sustituye
+    for (uint32_t i = 0; i < RADIO_TX_STAGING_SLOTS; i++) {
+      snprintf(text, sizeof(text), "%02u011 0 00 %u", (unsigned)i, (unsigned)round);
+      TEST_ASSERT_FALSE(stage(staging, text, (uint8_t)i));
+    }
+    TEST_ASSERT_TRUE(staging.full());
+    // Vaciar y desplazar el anillo una posición en cada vuelta
+    for (uint32_t i = 0; i < RADIO_TX_STAGING_SLOTS; i++) {
+      TEST_ASSERT_TRUE(staging.pop(frame, tag));
+      TEST_ASSERT_EQUAL_UINT8(i, tag);
+    }
+    TEST_ASSERT_TRUE(staging.empty());
+    TEST_ASSERT_FALSE(staging.pop(frame, tag));
+    stage(staging, "01021 0 00 x", 0xEE);
+    TEST_ASSERT_TRUE(staging.pop(frame, tag));
+    TEST_ASSERT_EQUAL_UINT8(0xEE, tag);
+  }
+  RadioTxStagingStats s = staging.getStats();
+  TEST_ASSERT_EQUAL_UINT32(RADIO_TX_STAGING_SLOTS, s.maxDepth);
+  TEST_ASSERT_EQUAL_UINT32(s.staged, s.sent);
+}
+
+struct ChronoBurstResult {
+  uint32_t maxLatencyUs;
+  uint32_t sent;
+  uint32_t rejected;
+  uint32_t coalesced;
+  uint32_t stale;   // Cronos que salieron después de uno más nuevo del mismo display
+};
+
+/**
+ * @brief Teléfono enviando cronos de 4 displays a 200 fps contra una radio de
+ * ~48 tramas/s (9600 bps 8N1), en tiempo simulado
+ * @param coalesce true para pasar por RadioTxStaging, false para FIFO directo
+ */
+static ChronoBurstResult simulateChronoBurst(bool coalesce) {
+  const uint32_t periodUs = 5000, seconds = 10, displays = 4;
+  const uint32_t byteUs = 10000000 / 9600;
+  static BridgeQueue queue(BRIDGE_DROP_NEWEST);
+  BridgeFrame frame;
+  while (queue.pop(frame)) {}
+  RadioTxStaging staging;
+  ChronoBurstResult r;
+  memset(&r, 0, sizeof(r));
+  uint32_t lastStamp[displays + 1] = {};
+  uint8_t tag;
+  uint16_t len16;
+  uint32_t busyUntil = 0, seq = 0;
+
+  for (uint32_t t = 0; t < seconds * 1000000; t += 100) {
+    if (t % periodUs == 0) {
+      char text[32];
+      int len = snprintf(text, sizeof(text), "%02u011 0 00 %02u:%02u.%u", (unsigned)(seq % displays + 1),
+                         (unsigned)(t / 60000000), (unsigned)(t / 1000000 % 60), (unsigned)(t / 100000 % 10));
+      if (!queue.push((const uint8_t*)text, len, 0, t)) r.rejected++;
+      seq++;
+    }
+    if (coalesce) {
+      while (!staging.full() && queue.pop(staging.back())) staging.commit(0, len16, tag);
+    }
+    if (t >= busyUntil && (coalesce ? staging.pop(frame, tag) : queue.pop(frame))) {
+      busyUntil = t + frame.len * byteUs;
+      if (busyUntil - frame.stampUs > r.maxLatencyUs) r.maxLatencyUs = busyUntil - frame.stampUs;
+      uint32_t display = (uint32_t)(frame.data[0] - '0') * 10 + (frame.data[1] - '0');
+      if (r.sent > 0 && frame.stampUs < lastStamp[display]) r.stale++;
+      lastStamp[display] = frame.stampUs;
+      r.sent++;
+    }
+  }
+  r.coalesced = staging.getStats().coalesced;
+  return r;
+}
+
+static void test_chrono_burst_latency_is_bounded() {
+  ChronoBurstResult fifo = simulateChronoBurst(false);
+  ChronoBurstResult latest = simulateChronoBurst(true);
+
+  // FIFO: la cola se llena de valores viejos y se rechazan los nuevos
+  TEST_ASSERT_GREATER_THAN_UINT32(0, fifo.rejected);
+  TEST_ASSERT_GREATER_THAN_UINT32(200000, fifo.maxLatencyUs);
+
+  // Último valor: nada rechazado y cada crono sale como mucho un par de
+  // tramas por display después de generarse
+  TEST_ASSERT_EQUAL_UINT32(0, latest.rejected);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, latest.coalesced);
+  TEST_ASSERT_LESS_THAN_UINT32(100000, latest.maxLatencyUs);
+  TEST_ASSERT_EQUAL_UINT32(0, latest.stale);
+  TEST_ASSERT_UINT32_WITHIN(latest.sent / 20, fifo.sent, latest.sent);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_chrono_replaces_pending_chrono_in_place);
+  RUN_TEST(test_same_display_frames_are_barriers);
+  RUN_TEST(test_undecodable_frame_is_a_barrier_for_all);
+  RUN_TEST(test_text_frames_never_coalesce);
+  RUN_TEST(test_full_and_fifo_across_wrap);
+  RUN_TEST(test_chrono_burst_latency_is_bounded);
+  return UNITY_END();
+}
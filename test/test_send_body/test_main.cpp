@@ -0,0 +1,49 @@
+// Cuerpo de /api/send recompuesto desde los parámetros de formulario
+// (src/send_body): mensajes text/plain con '=' que ESPAsyncWebServer separa
+
+#include <unity.h>
+#include <string.h>
+#include "send_body.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_single_param_is_rejoined() {
+  // "a=b" enviado como text/plain llega como el parámetro a -> b
+  uint8_t out[32];
+  size_t len = 0;
+  TEST_ASSERT_TRUE(appendSendBodyParam("a", "b", out, sizeof(out), len));
+  TEST_ASSERT_EQUAL_UINT32(3, len);
+  TEST_ASSERT_EQUAL_MEMORY("a=b", out, 3);
+}
+
+static void test_params_and_plain_chunks_keep_order() {
+  // "XX01=1 0 00&hola&k=" -> (XX01, "1 0 00"), (body, hola), (k, "")
+  uint8_t out[64];
+  size_t len = 0;
+  TEST_ASSERT_TRUE(appendSendBodyParam("XX01", "1 0 00", out, sizeof(out), len));
+  TEST_ASSERT_TRUE(appendSendBodyParam("body", "hola", out, sizeof(out), len));
+  TEST_ASSERT_TRUE(appendSendBodyParam("k", "", out, sizeof(out), len));
+  const char expected[] = "XX01=1 0 00&hola&k=";
+  TEST_ASSERT_EQUAL_UINT32(sizeof(expected) - 1, len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, out, len);
+}
+
+static void test_overflow_leaves_output_untouched() {
+  uint8_t out[8];
+  size_t len = 0;
+  TEST_ASSERT_TRUE(appendSendBodyParam("a", "bcd", out, sizeof(out), len));   // "a=bcd"
+  TEST_ASSERT_FALSE(appendSendBodyParam("e", "f", out, sizeof(out), len));    // "&e=f" no cabe
+  TEST_ASSERT_EQUAL_UINT32(5, len);
+  TEST_ASSERT_TRUE(appendSendBodyParam("body", "xy", out, sizeof(out), len)); // "&xy" justo
+  TEST_ASSERT_EQUAL_UINT32(8, len);
+  TEST_ASSERT_EQUAL_MEMORY("a=bcd&xy", out, 8);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_param_is_rejoined);
+  RUN_TEST(test_params_and_plain_chunks_keep_order);
+  RUN_TEST(test_overflow_leaves_output_untouched);
+  return UNITY_END();
+}
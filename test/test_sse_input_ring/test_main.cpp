@@ -0,0 +1,166 @@
+// Anillo de eventos de entrada de /api/stream (src/sse_input_ring): orden,
+// truncado, descarte del más antiguo y varios productores a la vez
+
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "sse_input_ring.h"
+
+static const uint32_t STRESS_EVENTS = 50000;   // Por productor
+
+void setUp() {}
+void tearDown() {}
+
+static void push(SseInputRing& ring, const char* text, uint32_t time) {
+  ring.push(text, strlen(text), time);
+}
+
+static void test_fifo_order() {
+  SseInputRing ring;
+  push(ring, "Inicio:100", 100);
+  push(ring, "Pausa:200", 200);
+  TEST_ASSERT_EQUAL_UINT32(2, ring.size());
+
+  SseInputRecord e;
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(100, e.time);
+  TEST_ASSERT_EQUAL_UINT8(10, e.len);
+  TEST_ASSERT_EQUAL_MEMORY("Inicio:100", e.text, 10);
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(200, e.time);
+  TEST_ASSERT_EQUAL_MEMORY("Pausa:200", e.text, 9);
+  TEST_ASSERT_FALSE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(0, ring.drops());
+}
+
+static void test_long_text_is_truncated() {
+  SseInputRing ring;
+  char text[SSE_INPUT_TEXT_MAX + 20];
+  memset(text, 'x', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  push(ring, text, 1);
+
+  SseInputRecord e;
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT8(SSE_INPUT_TEXT_MAX, e.len);
+  TEST_ASSERT_EQUAL_MEMORY(text, e.text, SSE_INPUT_TEXT_MAX);
+}
+
+// El flanco F1-F3 crece con el tiempo encendido: con los contadores al máximo
+// llega entero, sin perder el timestamp en µs ni el sufijo
+static void test_longest_edge_text_fits() {
+  SseInputRing ring;
+  char text[SSE_INPUT_TEXT_MAX + 1];
+  int n = snprintf(text, sizeof(text), SSE_EDGE_TEXT_FORMAT, (unsigned)UINT32_MAX, (unsigned)UINT32_MAX,
+                   (unsigned)UINT32_MAX, 3u, (unsigned long long)UINT64_MAX);
+  TEST_ASSERT_EQUAL_STRING(SSE_EDGE_TEXT_LONGEST, text);
+  TEST_ASSERT_TRUE(ring.push(text, n, 1));
+
+  // Tras ~2.8 h (10^10 µs) el formato ya pasaba de los 48 bytes de antes
+  char later[SSE_INPUT_TEXT_MAX + 1];
+  int m = snprintf(later, sizeof(later), SSE_EDGE_TEXT_FORMAT, 9999999u, 9999999u, 9999999u, 1u,
+                   10000000000ULL);
+  TEST_ASSERT_GREATER_THAN_UINT32(48, m);
+  TEST_ASSERT_TRUE(ring.push(later, m, 2));
+
+  SseInputRecord e;
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT8(n, e.len);
+  TEST_ASSERT_EQUAL_MEMORY(SSE_EDGE_TEXT_LONGEST, e.text, n);
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT8(m, e.len);
+  TEST_ASSERT_EQUAL_MEMORY(later, e.text, m);
+  TEST_ASSERT_EQUAL_MEMORY("10000000000us", e.text + m - 13, 13);
+}
+
+static void test_overflow_drops_oldest() {
+  SseInputRing ring;
+  char text[16];
+  for (uint32_t i = 0; i < SseInputRing::CAPACITY; i++) {
+    snprintf(text, sizeof(text), "K:%u", (unsigned)i);
+    TEST_ASSERT_TRUE(ring.push(text, strlen(text), i));
+  }
+  TEST_ASSERT_FALSE(ring.push("K:new", 5, 1000));
+  TEST_ASSERT_FALSE(ring.push("K:new", 5, 1001));
+  TEST_ASSERT_EQUAL_UINT32(2, ring.drops());
+  TEST_ASSERT_EQUAL_UINT32(SseInputRing::CAPACITY, ring.size());
+
+  SseInputRecord e;
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(2, e.time);   // Los dos primeros ya no están
+  for (uint32_t i = 3; i < SseInputRing::CAPACITY; i++) TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(1000, e.time);
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(1001, e.time);
+  TEST_ASSERT_FALSE(ring.pop(e));
+}
+
+static void test_clear_discards_pending() {
+  SseInputRing ring;
+  push(ring, "A:1", 1);
+  push(ring, "B:2", 2);
+  ring.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+  SseInputRecord e;
+  TEST_ASSERT_FALSE(ring.pop(e));
+  push(ring, "C:3", 3);
+  TEST_ASSERT_TRUE(ring.pop(e));
+  TEST_ASSERT_EQUAL_UINT32(3, e.time);
+}
+
+// Dos productores y un consumidor: cada registro llega entero y, por
+// productor, en orden; lo que falta está contado en drops()
+static void test_concurrent_producers() {
+  SseInputRing ring;
+  std::atomic<int> running(2);
+  auto produce = [&ring, &running](char tag) {
+    char text[SSE_INPUT_TEXT_MAX];
+    for (uint32_t i = 0; i < STRESS_EVENTS; i++) {
+      // Texto que repite el número hasta llenar el registro: un registro roto se nota
+      int n = snprintf(text, sizeof(text), "%c:%08u", tag, (unsigned)i);
+      while (n + 10 <= (int)sizeof(text)) n += snprintf(text + n, sizeof(text) - n, ":%08u", (unsigned)i);
+      ring.push(text, n, i);
+    }
+    running--;
+  };
+  std::thread a(produce, 'A');
+  std::thread b(produce, 'B');
+
+  uint32_t received = 0;
+  int64_t last[2] = {-1, -1};
+  bool ok = true;
+  SseInputRecord e;
+  auto drain = [&]() {
+    while (ring.pop(e)) {
+      int p = e.text[0] - 'A';
+      char expected[SSE_INPUT_TEXT_MAX];
+      int n = snprintf(expected, sizeof(expected), "%c:%08u", e.text[0], (unsigned)e.time);
+      while (n + 10 <= (int)sizeof(expected)) n += snprintf(expected + n, sizeof(expected) - n, ":%08u", (unsigned)e.time);
+      if (p < 0 || p > 1 || e.len != n || memcmp(expected, e.text, n) != 0 || (int64_t)e.time <= last[p]) ok = false;
+      if (p >= 0 && p <= 1) last[p] = e.time;
+      received++;
+    }
+  };
+  while (running > 0) drain();
+  a.join();
+  b.join();
+  drain();
+
+  TEST_ASSERT_TRUE(ok);
+  TEST_ASSERT_EQUAL_UINT32(2 * STRESS_EVENTS, received + ring.drops());
+  TEST_ASSERT_EQUAL_UINT64(STRESS_EVENTS - 1, (uint64_t)(last[0] > last[1] ? last[0] : last[1]));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order);
+  RUN_TEST(test_long_text_is_truncated);
+  RUN_TEST(test_longest_edge_text_fits);
+  RUN_TEST(test_overflow_drops_oldest);
+  RUN_TEST(test_clear_discards_pending);
+  RUN_TEST(test_concurrent_producers);
+  return UNITY_END();
+}
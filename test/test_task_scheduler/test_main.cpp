@@ -0,0 +1,200 @@
+// Planificador de trabajos de baja frecuencia (src/task_scheduler) con el
+// reloj manual de native/fakes: periodo fijo, resincronización tras un
+// overrun y desborde de micros() a los 2^32 µs
+
+#include <unity.h>
+#include "task_scheduler.h"
+
+static uint32_t runsA;
+static uint32_t runsB;
+static uint32_t runCostUs;      // Lo que "tarda" cada ejecución de jobA
+static uint32_t order[8];
+static uint32_t orderLen;
+
+static void jobA() {
+  runsA++;
+  if (orderLen < 8) order[orderLen++] = 'A';
+  nativeAdvanceMicros(runCostUs);
+}
+
+static void jobB() {
+  runsB++;
+  if (orderLen < 8) order[orderLen++] = 'B';
+}
+
+void setUp() {
+  runsA = 0;
+  runsB = 0;
+  runCostUs = 0;
+  orderLen = 0;
+  nativeSetMicros(1000000);
+}
+
+void tearDown() {}
+
+static void test_fixed_period_without_drift() {
+  TaskScheduler s;
+  TaskId id = s.addTask("a", jobA, 10);
+  const uint32_t t0 = micros();
+
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(t0 + 10000, s.getTask(id)->nextDueUs);
+  TEST_ASSERT_EQUAL_UINT32(10000, s.timeUntilNextUs());
+
+  nativeSetMicros(t0 + 9999);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+
+  // Ejecutada tarde: el siguiente plazo sigue en la rejilla del periodo
+  for (uint32_t k = 1; k <= 5; k++) {
+    nativeSetMicros(t0 + k * 10000 + 700);
+    s.update();
+    TEST_ASSERT_EQUAL_UINT32(k + 1, runsA);
+    TEST_ASSERT_EQUAL_UINT32(t0 + (k + 1) * 10000, s.getTask(id)->nextDueUs);
+  }
+  const TaskRunStats& st = s.getTask(id)->stats;
+  TEST_ASSERT_EQUAL_UINT32(6, st.executionCount);
+  TEST_ASSERT_EQUAL_UINT32(700, st.maxLateUs);
+  TEST_ASSERT_EQUAL_UINT32(0, st.overruns);
+}
+
+static void test_sleep_until_next_wakes_at_deadline() {
+  TaskScheduler s;
+  TaskId id = s.addTask("a", jobA, 10);
+  runCostUs = 2500;
+  for (int i = 0; i < 20; i++) {
+    s.update();
+    s.sleepUntilNext();
+  }
+  // El reloj manual avanza con vTaskDelay(): redondeo al tick, nunca antes del plazo
+  TEST_ASSERT_EQUAL_UINT32(20, runsA);
+  TEST_ASSERT_EQUAL_UINT32(0, s.getTask(id)->stats.overruns);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(portTICK_PERIOD_MS * 1000, s.getTask(id)->stats.maxLateUs);
+}
+
+static void test_long_run_counts_overrun_and_resyncs() {
+  TaskScheduler s;
+  TaskId id = s.addTask("a", jobA, 10);
+  const uint32_t t0 = micros();
+  runCostUs = 25000;   // Dura dos periodos y medio
+
+  s.update();
+  const Task* task = s.getTask(id);
+  TEST_ASSERT_EQUAL_UINT32(1, task->stats.overruns);
+  // Resincronizada desde el final de la ejecución, no a ráfagas de atrasadas
+  TEST_ASSERT_EQUAL_UINT32(t0 + 25000 + 10000, task->nextDueUs);
+  TEST_ASSERT_EQUAL_UINT32(25000, task->stats.maxRunUs);
+
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+}
+
+static void test_late_start_counts_overrun_once() {
+  TaskScheduler s;
+  TaskId id = s.addTask("a", jobA, 10);
+  const uint32_t t0 = micros();
+  s.update();
+
+  // La tarea FreeRTOS no llegó a tiempo: se pierden dos periodos enteros
+  nativeSetMicros(t0 + 35000);
+  s.update();
+  s.update();
+  const Task* task = s.getTask(id);
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  TEST_ASSERT_EQUAL_UINT32(1, task->stats.overruns);
+  TEST_ASSERT_EQUAL_UINT32(t0 + 45000, task->nextDueUs);
+
+  // Menos de un periodo de retraso: se recupera sin resincronizar
+  nativeSetMicros(t0 + 45000 + 9000);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, task->stats.overruns);
+  TEST_ASSERT_EQUAL_UINT32(t0 + 55000, task->nextDueUs);
+}
+
+static void test_micros_wraparound() {
+  nativeSetMicros(0xFFFFFFFFu - 15000);
+  TaskScheduler s;
+  TaskId a = s.addTask("a", jobA, 10);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFu - 5000, s.getTask(a)->nextDueUs);
+
+  nativeAdvanceMicros(10000);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  // El plazo ya ha desbordado (4999) pero sigue siendo futuro
+  TEST_ASSERT_EQUAL_UINT32(4999, s.getTask(a)->nextDueUs);
+  TEST_ASSERT_EQUAL_UINT32(10000, s.timeUntilNextUs());
+
+  nativeAdvanceMicros(9999);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  nativeAdvanceMicros(1);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(3, runsA);
+  TEST_ASSERT_EQUAL_UINT32(0, s.getTask(a)->stats.overruns);
+  TEST_ASSERT_EQUAL_UINT32(0, s.getTask(a)->stats.maxLateUs);
+}
+
+static void test_heap_orders_deadlines_across_wraparound() {
+  nativeSetMicros(0xFFFFFFFFu - 3000);
+  TaskScheduler s;
+  s.addTask("a", jobA, 5);   // Próximo plazo tras el desborde (2 ms después)
+  s.addTask("b", jobB, 2);   // Próximo plazo antes del desborde
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, orderLen);
+  orderLen = 0;
+
+  // Solo la de 2 ms ha vencido, aunque su plazo sea numéricamente mayor
+  nativeAdvanceMicros(2000);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, orderLen);
+  TEST_ASSERT_EQUAL_UINT32('B', order[0]);
+
+  nativeAdvanceMicros(3000);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  TEST_ASSERT_EQUAL_UINT32(3, runsB);
+}
+
+static void test_disable_and_enable() {
+  TaskScheduler s;
+  TaskId a = s.addTask("a", jobA, 10);
+  TaskId b = s.addTask("b", jobB, 0);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(1, runsB);
+
+  // Periodo 0: una vez por update(), sin acaparar el bucle
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, runsB);
+
+  s.disableTask(b);
+  nativeAdvanceMicros(10000);
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  TEST_ASSERT_EQUAL_UINT32(2, runsB);
+
+  s.disableTask(a);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, s.timeUntilNextUs());
+  nativeAdvanceMicros(3000);
+  s.enableTask(a);
+  TEST_ASSERT_EQUAL_UINT32(0, s.timeUntilNextUs());
+  s.update();
+  TEST_ASSERT_EQUAL_UINT32(3, runsA);
+  TEST_ASSERT_TRUE(s.removeTask(b));
+  TEST_ASSERT_EQUAL_INT(1, s.getTaskCount());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_period_without_drift);
+  RUN_TEST(test_sleep_until_next_wakes_at_deadline);
+  RUN_TEST(test_long_run_counts_overrun_and_resyncs);
+  RUN_TEST(test_late_start_counts_overrun_once);
+  RUN_TEST(test_micros_wraparound);
+  RUN_TEST(test_heap_orders_deadlines_across_wraparound);
+  RUN_TEST(test_disable_and_enable);
+  return UNITY_END();
+}
@@ -0,0 +1,127 @@
+// Seguimiento de tramas en el buffer TX de la UART (src/uart_tx_tracker):
+// cada trama se cierra, en orden, cuando su último byte sale por la línea
+
+#include <unity.h>
+#include "uart_tx_tracker.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void writeFrame(UartTxTracker& tracker, uint16_t len, uint8_t tag, uint32_t stampUs) {
+  tracker.wrote(len);
+  TEST_ASSERT_TRUE(tracker.mark(stampUs, len, tag));
+}
+
+static void test_frames_complete_in_order() {
+  UartTxTracker tracker;
+  UartTxDone done;
+  TEST_ASSERT_FALSE(tracker.popDone(0, done));
+  writeFrame(tracker, 20, 1, 100);
+  writeFrame(tracker, 30, 2, 200);
+  TEST_ASSERT_EQUAL_UINT32(50, tracker.outstanding());
+
+  // Todo sigue en el driver
+  TEST_ASSERT_FALSE(tracker.popDone(50, done));
+  // Salieron 19 bytes de la primera: aún no está
+  TEST_ASSERT_FALSE(tracker.popDone(31, done));
+  TEST_ASSERT_EQUAL_UINT32(1, tracker.bytesUntilNext(31));
+
+  // Salió la primera y parte de la segunda
+  TEST_ASSERT_TRUE(tracker.popDone(30, done));
+  TEST_ASSERT_EQUAL_UINT32(100, done.stampUs);
+  TEST_ASSERT_EQUAL_UINT16(20, done.len);
+  TEST_ASSERT_EQUAL_UINT8(1, done.tag);
+  TEST_ASSERT_FALSE(tracker.popDone(10, done));
+  TEST_ASSERT_EQUAL_UINT32(10, tracker.bytesUntilNext(10));
+
+  TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT32(200, done.stampUs);
+  TEST_ASSERT_EQUAL_UINT8(2, done.tag);
+  TEST_ASSERT_FALSE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT32(0, tracker.bytesUntilNext(0));
+
+  UartTxTrackerStats s = tracker.getStats();
+  TEST_ASSERT_EQUAL_UINT32(50, s.written);
+  TEST_ASSERT_EQUAL_UINT32(50, s.completed);
+  TEST_ASSERT_EQUAL_UINT32(2, s.frames);
+  TEST_ASSERT_EQUAL_UINT32(0, s.inFlight);
+  TEST_ASSERT_EQUAL_UINT32(2, s.maxInFlight);
+}
+
+static void test_frame_written_in_pieces() {
+  UartTxTracker tracker;
+  UartTxDone done;
+  // Una trama entregada en dos trozos solo se marca al final
+  tracker.wrote(12);
+  tracker.wrote(8);
+  TEST_ASSERT_TRUE(tracker.mark(7, 20, 3));
+  TEST_ASSERT_FALSE(tracker.popDone(8, done));
+  TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT16(20, done.len);
+}
+
+static void test_full_at_inflight_slots() {
+  UartTxTracker tracker;
+  UartTxDone done;
+  for (uint32_t i = 0; i < RADIO_TX_INFLIGHT_SLOTS; i++) {
+    TEST_ASSERT_FALSE(tracker.full());
+    writeFrame(tracker, 10, (uint8_t)i, i);
+  }
+  TEST_ASSERT_TRUE(tracker.full());
+  tracker.wrote(10);
+  TEST_ASSERT_FALSE(tracker.mark(99, 10, 0));
+
+  // Liberar una deja hueco; el orden se mantiene a través de la vuelta del anillo
+  TEST_ASSERT_TRUE(tracker.popDone(tracker.outstanding() - 10, done));
+  TEST_ASSERT_EQUAL_UINT8(0, done.tag);
+  TEST_ASSERT_FALSE(tracker.full());
+  TEST_ASSERT_TRUE(tracker.mark(99, 10, 0xAA));
+  for (uint32_t i = 1; i < RADIO_TX_INFLIGHT_SLOTS; i++) {
+    TEST_ASSERT_TRUE(tracker.popDone(0, done));
+    TEST_ASSERT_EQUAL_UINT8(i, done.tag);
+  }
+  TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT8(0xAA, done.tag);
+  TEST_ASSERT_EQUAL_UINT32(RADIO_TX_INFLIGHT_SLOTS, tracker.getStats().maxInFlight);
+}
+
+static void test_pending_clamped_to_outstanding() {
+  UartTxTracker tracker;
+  UartTxDone done;
+  // El driver puede informar de más bytes de los que este seguidor entregó
+  // (restos de otra escritura): nunca se cuentan como negativos
+  writeFrame(tracker, 20, 1, 0);
+  TEST_ASSERT_FALSE(tracker.popDone(500, done));
+  TEST_ASSERT_EQUAL_UINT32(20, tracker.bytesUntilNext(500));
+  TEST_ASSERT_EQUAL_UINT32(0, tracker.getStats().completed);
+  TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT32(0, tracker.outstanding());
+}
+
+static void test_written_counter_wraparound() {
+  UartTxTracker tracker;
+  UartTxDone done;
+  // Llevar los contadores cerca del desborde de 32 bits
+  const uint32_t chunk = 0x40000000;
+  for (int i = 0; i < 3; i++) {
+    tracker.wrote(chunk);
+    TEST_ASSERT_TRUE(tracker.mark(0, 0, 0));
+    TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  }
+  tracker.wrote(chunk - 10);
+  writeFrame(tracker, 30, 5, 0);   // Termina pasada la vuelta
+  TEST_ASSERT_FALSE(tracker.popDone(1, done));
+  TEST_ASSERT_EQUAL_UINT32(1, tracker.bytesUntilNext(1));
+  TEST_ASSERT_TRUE(tracker.popDone(0, done));
+  TEST_ASSERT_EQUAL_UINT8(5, done.tag);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_frames_complete_in_order);
+  RUN_TEST(test_frame_written_in_pieces);
+  RUN_TEST(test_full_at_inflight_slots);
+  RUN_TEST(test_pending_clamped_to_outstanding);
+  RUN_TEST(test_written_counter_wraparound);
+  return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// Reparto a clientes WebSocket (src/ws_fanout): una cola por cliente en su
+// formato, sin esperar a clientes sin hueco y desconectando a los retrasados
+
+#include <unity.h>
+#include <string.h>
+#include "ws_fanout.h"
+
+static AsyncWebSocket ws("/");
+
+// Las colas son estado del módulo: cada test usa ids propios y los suelta
+void setUp() {
+  ws = AsyncWebSocket("/");
+  wsFanoutInit(ws);
+  nativeSetMicros(1000000);
+}
+
+void tearDown() {
+  for (uint32_t id = 0; id < NATIVE_WS_IDS; id++) wsFanoutClientDisconnected(id);
+  TEST_ASSERT_EQUAL_UINT32(WS_FANOUT_POOL_SIZE, wsFanoutPoolFree());
+}
+
+static EncodedMessage makeMessage(const char* json, uint32_t seq) {
+  static uint8_t bin[MESSAGE_BIN_MAX];
+  EncodedMessage m;
+  m.seq = seq;
+  m.stampUs = 0;
+  m.json = json;
+  m.jsonLen = strlen(json);
+  m.bin = bin;
+  m.binLen = MESSAGE_BIN_HEADER_LEN + 1;
+  return m;
+}
+
+static WsClientStats statsFor(uint32_t id) {
+  for (uint8_t slot = 0; slot < WS_MAX_CLIENTS; slot++) {
+    WsClientStats s = wsFanoutGetStats(slot);
+    if (s.id == id && (s.connected || s.kicked > 0)) return s;
+  }
+  WsClientStats none;
+  memset(&none, 0, sizeof(none));
+  return none;
+}
+
+static void test_each_client_gets_its_format() {
+  for (uint32_t id = 1; id <= 4; id++) {
+    TEST_ASSERT_TRUE(wsFanoutClientConnected(id));
+    wsFanoutSetBinary(id, id >= 3);
+  }
+  TEST_ASSERT_TRUE(wsFanoutPublish(makeMessage("{\"a\":1}", 1), 0));
+  TEST_ASSERT_TRUE(wsFanoutPublish(makeMessage("{\"a\":2}", 2), 0));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wsFanoutService());   // Nada pendiente: esperar notificación
+
+  TEST_ASSERT_EQUAL_UINT64(4, ws.textFrames);
+  TEST_ASSERT_EQUAL_UINT64(4, ws.binaryFrames);
+  for (uint32_t id = 1; id <= 4; id++) {
+    TEST_ASSERT_EQUAL_UINT32(2, ws.framesTo[id]);
+    TEST_ASSERT_EQUAL_UINT32(2, statsFor(id).sent);
+    TEST_ASSERT_EQUAL_UINT8(0, statsFor(id).depth);
+  }
+  // Todas las referencias soltadas tras enviar
+  TEST_ASSERT_EQUAL_UINT32(WS_FANOUT_POOL_SIZE, wsFanoutPoolFree());
+
+  // Un texto sin formato binario sale como texto aunque el cliente pida binario
+  const char* text = "{\"sim\":1}";
+  TEST_ASSERT_TRUE(wsFanoutPublishText((const uint8_t*)text, strlen(text)));
+  wsFanoutService();
+  TEST_ASSERT_EQUAL_UINT64(8, ws.textFrames);
+}
+
+static void test_busy_client_is_skipped_without_blocking_others() {
+  wsFanoutClientConnected(10);
+  wsFanoutClientConnected(11);
+  ws.setWritable(10, false);
+
+  // Cronos del mismo display: el cliente atascado solo guarda el último
+  for (uint32_t i = 0; i < 5; i++) {
+    wsFanoutPublish(makeMessage("{\"c\":1}", i), 0x30313032);
+    TEST_ASSERT_EQUAL_UINT32(WS_BUSY_RETRY_MS, wsFanoutService());
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, ws.framesTo[11]);
+  TEST_ASSERT_EQUAL_UINT32(0, ws.framesTo[10]);
+  WsClientStats busy = statsFor(10);
+  TEST_ASSERT_EQUAL_UINT8(1, busy.depth);
+  TEST_ASSERT_EQUAL_UINT32(4, busy.coalesced);
+  TEST_ASSERT_EQUAL_UINT32(5, busy.busy);
+  TEST_ASSERT_FALSE(ws.closed[10]);
+
+  // Con hueco otra vez recibe lo pendiente
+  ws.setWritable(10, true);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wsFanoutService());
+  TEST_ASSERT_EQUAL_UINT32(1, ws.framesTo[10]);
+  TEST_ASSERT_EQUAL_UINT8(0, statsFor(10).depth);
+}
+
+static void test_stale_queue_kicks_client() {
+  wsFanoutClientConnected(20);
+  wsFanoutClientConnected(21);
+  ws.setWritable(20, false);
+
+  wsFanoutPublish(makeMessage("{\"x\":1}", 1), 0);
+  nativeAdvanceMicros(WS_CLIENT_STALL_MS * 1000);
+  wsFanoutService();
+  TEST_ASSERT_FALSE(ws.closed[20]);   // Justo en el límite aún no
+  TEST_ASSERT_EQUAL_UINT32(1, ws.framesTo[21]);
+
+  nativeAdvanceMicros(1);
+  wsFanoutService();
+  TEST_ASSERT_TRUE(ws.closed[20]);
+  TEST_ASSERT_FALSE(ws.closed[21]);
+  WsClientStats s = statsFor(20);
+  TEST_ASSERT_FALSE(s.connected);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, s.kicked);
+  TEST_ASSERT_EQUAL_UINT32(WS_FANOUT_POOL_SIZE, wsFanoutPoolFree());
+
+  // El evento de desconexión que llega después no toca a nadie más
+  wsFanoutClientDisconnected(20);
+  wsFanoutPublish(makeMessage("{\"x\":2}", 2), 0);
+  wsFanoutService();
+  TEST_ASSERT_EQUAL_UINT32(2, ws.framesTo[21]);
+}
+
+static void test_repeated_drops_kick_client() {
+  wsFanoutClientConnected(30);
+  ws.setWritable(30, false);
+  uint32_t kicked = statsFor(30).kicked;   // Acumulado del hueco, de tests anteriores
+  const char* text = "{\"t\":1}";
+  for (uint32_t i = 0; i < WS_CLIENT_QUEUE_DEPTH + WS_CLIENT_MAX_DROPS - 1; i++) {
+    wsFanoutPublishText((const uint8_t*)text, strlen(text));
+  }
+  wsFanoutService();
+  TEST_ASSERT_FALSE(ws.closed[30]);
+  TEST_ASSERT_EQUAL_UINT32(WS_CLIENT_MAX_DROPS - 1, statsFor(30).dropped);
+
+  wsFanoutPublishText((const uint8_t*)text, strlen(text));
+  wsFanoutService();
+  TEST_ASSERT_TRUE(ws.closed[30]);
+  TEST_ASSERT_EQUAL_UINT32(kicked + 1, statsFor(30).kicked);
+}
+
+static void test_client_limit() {
+  for (uint32_t id = 0; id < WS_MAX_CLIENTS; id++) {
+    TEST_ASSERT_TRUE(wsFanoutClientConnected(40 + id));
+  }
+  TEST_ASSERT_FALSE(wsFanoutClientConnected(40 + WS_MAX_CLIENTS));
+  // Reconectar un id que ya tiene cola no gasta otra
+  TEST_ASSERT_TRUE(wsFanoutClientConnected(40));
+
+  wsFanoutClientDisconnected(41);
+  TEST_ASSERT_TRUE(wsFanoutClientConnected(40 + WS_MAX_CLIENTS));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_each_client_gets_its_format);
+  RUN_TEST(test_busy_client_is_skipped_without_blocking_others);
+  RUN_TEST(test_stale_queue_kicks_client);
+  RUN_TEST(test_repeated_drops_kick_client);
+  RUN_TEST(test_client_limit);
+  return UNITY_END();
+}